@@ -0,0 +1,464 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//=============================================================================
+//
+// Code available from: https://verilator.org
+//
+// Copyright 2001-2025 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//=============================================================================
+///
+/// \file
+/// \brief Verilated C++ tracing in binary change-log format implementation code
+///
+/// This file must be compiled and linked against all Verilated objects
+/// that use --trace-bin.
+///
+/// Use "verilator --trace-bin" to add this to the Makefile for the linker.
+///
+//=============================================================================
+
+// clang-format off
+
+#include "verilatedos.h"
+#include "verilated.h"
+#include "verilated_bin_c.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+# include <io.h>
+#else
+# include <sys/mman.h>
+# include <unistd.h>
+# define VL_BIN_MMAP  // Window is a shared mapping of the file
+#endif
+
+#ifndef O_LARGEFILE  // WIN32 headers omit this
+# define O_LARGEFILE 0
+#endif
+#ifndef O_CLOEXEC  // WIN32 headers omit this
+# define O_CLOEXEC 0
+#endif
+#ifndef O_BINARY  // Only WIN32 headers have this
+# define O_BINARY 0
+#endif
+
+// clang-format on
+
+// mmap offsets must be page aligned. This is a multiple of all common page sizes.
+constexpr size_t VL_BIN_PAGE_SIZE = 64 * 1024;
+
+//=============================================================================
+// Specialization of the generics for this trace format
+
+#define VL_SUB_T VerilatedBin
+#define VL_BUF_T VerilatedBinBuffer
+#include "verilated_trace_imp.h"
+#undef VL_SUB_T
+#undef VL_BUF_T
+
+//=============================================================================
+//=============================================================================
+//=============================================================================
+// Opening/Closing
+
+void VerilatedBin::open(const char* filename) VL_MT_SAFE_EXCLUDES(m_mutex) {
+    const VerilatedLockGuard lock{m_mutex};
+    if (isOpen()) return;
+
+    // Set member variables
+    m_filename = filename;  // "" is ok, as someone may overload open
+
+    // cppcheck-suppress duplicateExpression
+    m_fd = ::open(m_filename.c_str(),
+                  O_CREAT | O_TRUNC | O_RDWR | O_LARGEFILE | O_CLOEXEC | O_BINARY, 0666);
+    if (m_fd < 0) return;  // User code can check isOpen()
+    if (!windowMap(0, m_wrWindowSize > WINDOW_SIZE ? m_wrWindowSize : WINDOW_SIZE)) {
+        ::close(m_fd);
+        return;
+    }
+    m_isOpen = true;
+
+    // Header
+    writeBytes("VLTBIN01", 8);
+    const uint32_t byteOrder = 0x01020304;
+    writeBytes(&byteOrder, sizeof(byteOrder));
+    writeString(timeResStr());
+
+    // Scope and signal definitions
+    Super::traceInit();
+
+    writeBytes("E", 1);
+
+    constDump(true);  // First dump must containt the const signals
+    fullDump(true);  // First dump must be full
+}
+
+VerilatedBin::~VerilatedBin() {
+    close();
+#ifndef VL_BIN_MMAP
+    if (m_wrBufp) VL_DO_CLEAR(delete[] m_wrBufp, m_wrBufp = nullptr);
+#endif
+}
+
+void VerilatedBin::closeErr() {
+    // Close due to an error.  We might abort before even getting here,
+    // depending on the definition of vl_fatal.
+    if (!isOpen()) return;
+
+    // No window write back, just close
+    m_isOpen = false;
+    ::close(m_fd);  // May get error, just ignore it
+}
+
+void VerilatedBin::close() VL_MT_SAFE_EXCLUDES(m_mutex) {
+    // This function is on the flush() call path
+    const VerilatedLockGuard lock{m_mutex};
+    if (!isOpen()) return;
+    Super::flushBase();
+    // Release the window, and trim the file to the data actually written
+    const size_t used = m_writep - m_wrBufp;
+    windowUnmap(used);
+    if (isOpen()) {
+#ifdef VL_BIN_MMAP
+        if (VL_UNCOVERABLE(::ftruncate(m_fd, m_wrOffset + used) != 0)) {}  // Ignore errors
+#endif
+        m_isOpen = false;
+        ::close(m_fd);
+    }
+    Super::closeBase();
+}
+
+void VerilatedBin::flush() VL_MT_SAFE_EXCLUDES(m_mutex) {
+    const VerilatedLockGuard lock{m_mutex};
+    Super::flushBase();
+    if (isOpen()) windowSlide(m_wrWindowSize);
+}
+
+//=============================================================================
+// Output window
+
+bool VerilatedBin::windowMap(uint64_t offset, size_t size) {
+#ifdef VL_BIN_MMAP
+    if (::ftruncate(m_fd, offset + size) != 0) return false;
+    void* const p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, offset);
+    if (p == MAP_FAILED) return false;
+    m_wrBufp = static_cast<char*>(p);
+#else
+    if (!m_wrBufp || size != m_wrWindowSize) {
+        if (m_wrBufp) VL_DO_CLEAR(delete[] m_wrBufp, m_wrBufp = nullptr);
+        m_wrBufp = new char[size];
+    }
+#endif
+    m_wrOffset = offset;
+    m_wrWindowSize = size;
+    // Keep a quarter of the window spare, so a record started before the
+    // slide trigger always fits (see windowResize)
+    m_wrFlushp = m_wrBufp + size - size / 4;
+    m_writep = m_wrBufp;
+    return true;
+}
+
+void VerilatedBin::windowUnmap(size_t usedBytes) {
+    // Release the window, of which the first usedBytes are valid data
+#ifdef VL_BIN_MMAP
+    ::munmap(m_wrBufp, m_wrWindowSize);
+    m_wrBufp = nullptr;
+#else
+    const char* wp = m_wrBufp;
+    const char* const endp = m_wrBufp + usedBytes;
+    while (wp < endp) {
+        errno = 0;
+        const ssize_t got = ::write(m_fd, wp, endp - wp);
+        if (got > 0) {
+            wp += got;
+        } else if (VL_UNCOVERABLE(got < 0)) {
+            if (VL_UNCOVERABLE(errno != EAGAIN && errno != EINTR)) {
+                // LCOV_EXCL_START
+                // write failed, presume error (perhaps out of disk space)
+                const std::string msg = "VerilatedBin::windowUnmap: "s + std::strerror(errno);
+                VL_FATAL_MT("", 0, "", msg.c_str());
+                closeErr();
+                break;
+                // LCOV_EXCL_STOP
+            }
+        }
+    }
+#endif
+}
+
+void VerilatedBin::windowSlide(size_t newSize) VL_MT_UNSAFE_ONE {
+    // Move the window forward past the data written so far. The file offset
+    // of a mapping must be page aligned, so the last partial page stays in
+    // the window, and as it is a mapping of the file, its contents are kept.
+    // Without mmap the whole buffer is written out.
+    const size_t used = m_writep - m_wrBufp;
+#ifdef VL_BIN_MMAP
+    const size_t keep = used % VL_BIN_PAGE_SIZE;
+#else
+    const size_t keep = 0;
+#endif
+    windowUnmap(used);
+    if (VL_UNLIKELY(!isOpen())) return;
+    if (VL_UNCOVERABLE(!windowMap(m_wrOffset + used - keep, newSize))) {
+        // LCOV_EXCL_START
+        const std::string msg = "VerilatedBin::windowSlide: "s + std::strerror(errno);
+        VL_FATAL_MT("", 0, "", msg.c_str());
+        closeErr();
+        return;
+        // LCOV_EXCL_STOP
+    }
+    m_writep = m_wrBufp + keep;
+    m_wrTimeBeginp = nullptr;
+    m_wrTimeEndp = nullptr;
+}
+
+void VerilatedBin::windowResize(size_t minsize) {
+    // minsize is size of largest write. The window is at least 8 times as
+    // large, so the quarter kept spare beyond the slide trigger always fits it.
+    if (VL_LIKELY(minsize * 4 <= m_wrWindowSize)) return;
+    const size_t newSize = roundUpToMultipleOf<VL_BIN_PAGE_SIZE>(minsize * 8);
+    if (isOpen()) {
+        windowSlide(newSize);
+    } else {
+        m_wrWindowSize = newSize;
+    }
+}
+
+void VerilatedBin::writeBytes(const void* datap, size_t len) {
+    // Not fast, only used for header records
+    windowResize(len);
+    std::memcpy(m_writep, datap, len);
+    m_writep += len;
+    windowCheck();
+}
+
+void VerilatedBin::writeString(const std::string& str) {
+    const uint16_t len = static_cast<uint16_t>(std::min<size_t>(str.size(), UINT16_MAX));
+    writeBytes(&len, sizeof(len));
+    writeBytes(str.data(), len);
+}
+
+void VerilatedBin::emitTimeChange(uint64_t timeui) {
+    // Remember pointers when last emitted time stamp; if last output was
+    // timestamp backup and overwrite it, as VerilatedVcd does.
+    if (m_wrTimeEndp == m_writep) m_writep = m_wrTimeBeginp;
+    windowCheck();
+    m_wrTimeBeginp = m_writep;
+    *m_writep++ = 'T';
+    std::memcpy(m_writep, &timeui, sizeof(timeui));
+    m_writep += sizeof(timeui);
+    m_wrTimeEndp = m_writep;
+}
+
+//=============================================================================
+// Definitions
+
+void VerilatedBin::pushPrefix(const std::string& name, VerilatedTracePrefixType type) {
+    assert(!m_prefixStack.empty());  // Constructor makes an empty entry
+    std::string pname = name;
+    // An empty name means this is the root of a model created with name()=="".
+    // Put the signals under a new scope, as VerilatedVcd does, so the
+    // converted trace matches a VCD dump.
+    // Terminate earlier $root?
+    if (m_prefixStack.back().second == VerilatedTracePrefixType::ROOTIO_MODULE) popPrefix();
+    if (pname.empty()) {  // Start new temporary root
+        pname = "$rootio";
+        m_prefixStack.emplace_back("", VerilatedTracePrefixType::ROOTIO_WRAPPER);
+        type = VerilatedTracePrefixType::ROOTIO_MODULE;
+    }
+    std::string newPrefix = m_prefixStack.back().first + pname;
+    switch (type) {
+    case VerilatedTracePrefixType::ROOTIO_MODULE:
+    case VerilatedTracePrefixType::SCOPE_MODULE:
+    case VerilatedTracePrefixType::SCOPE_INTERFACE:
+    case VerilatedTracePrefixType::STRUCT_PACKED:
+    case VerilatedTracePrefixType::STRUCT_UNPACKED:
+    case VerilatedTracePrefixType::UNION_PACKED: {
+        const uint8_t typeByte = static_cast<uint8_t>(type);
+        writeBytes("S", 1);
+        writeBytes(&typeByte, sizeof(typeByte));
+        writeString(lastWord(newPrefix));
+        newPrefix += ' ';
+        break;
+    }
+    default: break;
+    }
+    m_prefixStack.emplace_back(newPrefix, type);
+}
+
+void VerilatedBin::popPrefix() {
+    assert(!m_prefixStack.empty());
+    switch (m_prefixStack.back().second) {
+    case VerilatedTracePrefixType::ROOTIO_MODULE:
+    case VerilatedTracePrefixType::SCOPE_MODULE:
+    case VerilatedTracePrefixType::SCOPE_INTERFACE:
+    case VerilatedTracePrefixType::STRUCT_PACKED:
+    case VerilatedTracePrefixType::STRUCT_UNPACKED:
+    case VerilatedTracePrefixType::UNION_PACKED: writeBytes("U", 1); break;
+    default: break;
+    }
+    m_prefixStack.pop_back();
+    assert(!m_prefixStack.empty());  // Always one left, the constructor's initial one
+}
+
+void VerilatedBin::declare(uint32_t code, const char* name, int kind, bool array, int arraynum,
+                           bool bussed, int msb, int lsb) {
+    const int bits = ((msb > lsb) ? (msb - lsb) : (lsb - msb)) + 1;
+
+    const std::string hierarchicalName = m_prefixStack.back().first + name;
+
+    const bool enabled = Super::declCode(code, hierarchicalName, bits);
+
+    // Keep upper bound on bytes a single signal can emit into the buffer:
+    // tag + code + payload, plus room for a preceding time record
+    m_maxSignalBytes = std::max<size_t>(m_maxSignalBytes, 5 + VL_WORDS_I(bits) * 4 + 16);
+    // Make sure the window is large enough
+    windowResize(m_maxSignalBytes);
+
+    if (!enabled) return;
+
+    const uint8_t kindByte = static_cast<uint8_t>(kind);
+    const uint8_t flags = (array ? 1 : 0) | (bussed ? 2 : 0);
+    const int32_t nums[3] = {arraynum, msb, lsb};
+    writeBytes("D", 1);
+    writeBytes(&code, sizeof(code));
+    writeBytes(&kindByte, sizeof(kindByte));
+    writeBytes(&flags, sizeof(flags));
+    writeBytes(nums, sizeof(nums));
+    writeString(lastWord(hierarchicalName));
+}
+
+void VerilatedBin::declEvent(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                             VerilatedTraceSigDirection, VerilatedTraceSigKind,
+                             VerilatedTraceSigType, bool array, int arraynum) {
+    declare(code, name, 1, array, arraynum, false, 0, 0);
+}
+void VerilatedBin::declBit(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                           VerilatedTraceSigDirection, VerilatedTraceSigKind,
+                           VerilatedTraceSigType, bool array, int arraynum) {
+    declare(code, name, 0, array, arraynum, false, 0, 0);
+}
+void VerilatedBin::declBus(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                           VerilatedTraceSigDirection, VerilatedTraceSigKind,
+                           VerilatedTraceSigType, bool array, int arraynum, int msb, int lsb) {
+    declare(code, name, 0, array, arraynum, true, msb, lsb);
+}
+void VerilatedBin::declQuad(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                            VerilatedTraceSigDirection, VerilatedTraceSigKind,
+                            VerilatedTraceSigType, bool array, int arraynum, int msb, int lsb) {
+    declare(code, name, 0, array, arraynum, true, msb, lsb);
+}
+void VerilatedBin::declArray(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                             VerilatedTraceSigDirection, VerilatedTraceSigKind,
+                             VerilatedTraceSigType, bool array, int arraynum, int msb, int lsb) {
+    declare(code, name, 0, array, arraynum, true, msb, lsb);
+}
+void VerilatedBin::declDouble(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                              VerilatedTraceSigDirection, VerilatedTraceSigKind,
+                              VerilatedTraceSigType, bool array, int arraynum) {
+    declare(code, name, 2, array, arraynum, false, 63, 0);
+}
+
+//=============================================================================
+// Get/commit trace buffer
+
+VerilatedBin::Buffer* VerilatedBin::getTraceBuffer(uint32_t fidx) {
+    assert(!parallel());  // Not requested by --trace-bin models
+    return new Buffer{*this};
+}
+
+void VerilatedBin::commitTraceBuffer(VerilatedBin::Buffer* bufp) {
+    // Needs adjusting for emitTimeChange
+    m_writep = bufp->m_writep;
+    delete bufp;
+}
+
+//=============================================================================
+// VerilatedBinBuffer implementation
+
+VL_ATTR_ALWINLINE
+char* VerilatedBinBuffer::startRecord(uint32_t code) {
+    char* const wp = m_writep;
+    wp[0] = 'V';
+    std::memcpy(wp + 1, &code, sizeof(code));
+    return wp + 1 + sizeof(code);
+}
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::finishRecord(char* writep) {
+    m_writep = writep;
+    // Slide the output window if there's not enough space left for another record
+    if (VL_UNLIKELY(m_writep > m_wrFlushp)) {
+        m_owner.m_writep = m_writep;
+        m_owner.windowSlide(m_owner.m_wrWindowSize);
+        m_writep = m_owner.m_writep;
+        m_wrFlushp = m_owner.m_wrFlushp;
+    }
+}
+
+//=============================================================================
+// emit* trace routines
+
+// Note: emit* are only ever called from one place (full* in
+// verilated_trace_imp.h, which is included in this file at the top),
+// so always inline them.
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::emitEvent(uint32_t code) { finishRecord(startRecord(code)); }
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::emitBit(uint32_t code, CData newval) {
+    char* const wp = startRecord(code);
+    wp[0] = static_cast<char>(newval);
+    finishRecord(wp + 1);
+}
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::emitCData(uint32_t code, CData newval, int bits) {
+    char* const wp = startRecord(code);
+    wp[0] = static_cast<char>(newval);
+    finishRecord(wp + 1);
+}
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::emitSData(uint32_t code, SData newval, int bits) {
+    char* const wp = startRecord(code);
+    std::memcpy(wp, &newval, sizeof(newval));
+    finishRecord(wp + sizeof(newval));
+}
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::emitIData(uint32_t code, IData newval, int bits) {
+    char* const wp = startRecord(code);
+    std::memcpy(wp, &newval, sizeof(newval));
+    finishRecord(wp + sizeof(newval));
+}
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::emitQData(uint32_t code, QData newval, int bits) {
+    char* const wp = startRecord(code);
+    std::memcpy(wp, &newval, sizeof(newval));
+    finishRecord(wp + sizeof(newval));
+}
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::emitWData(uint32_t code, const WData* newvalp, int bits) {
+    char* const wp = startRecord(code);
+    const size_t len = VL_WORDS_I(bits) * sizeof(EData);
+    std::memcpy(wp, newvalp, len);
+    finishRecord(wp + len);
+}
+
+VL_ATTR_ALWINLINE
+void VerilatedBinBuffer::emitDouble(uint32_t code, double newval) {
+    char* const wp = startRecord(code);
+    std::memcpy(wp, &newval, sizeof(newval));
+    finishRecord(wp + sizeof(newval));
+}
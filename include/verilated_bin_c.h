@@ -0,0 +1,303 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//=============================================================================
+//
+// Code available from: https://verilator.org
+//
+// Copyright 2001-2025 by Wilson Snyder. This program is free software; you
+// can redistribute it and/or modify it under the terms of either the GNU
+// Lesser General Public License Version 3 or the Perl Artistic License
+// Version 2.0.
+// SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+//
+//=============================================================================
+///
+/// \file
+/// \brief Verilated tracing in binary change-log format header
+///
+/// User wrapper code should use this header when creating binary traces.
+///
+/// The binary format is a raw change log that is written with no
+/// formatting at all, and is intended to be converted offline to VCD or FST
+/// using verilator_bin2vcd. All multi-byte fields are in the byte order of
+/// the host that wrote the file (see the byte order marker), and are not
+/// aligned. The file is:
+///
+///     "VLTBIN01"                      8 byte magic
+///     u32 0x01020304                  Byte order marker
+///     u16 length, chars               Timescale, e.g. "1ps"
+///     records...
+///
+/// Each record starts with a one byte ASCII tag:
+///
+///     'S' u8 type, u16 length, chars  Begin scope
+///     'U'                             End scope
+///     'D' u32 code, u8 kind, u8 flags, i32 arraynum, i32 msb, i32 lsb,
+///         u16 length, chars           Declare signal. kind: 0 wire,
+///                                     1 event, 2 real. flags: 1 array,
+///                                     2 bussed
+///     'E'                             End of declarations
+///     'T' u64 time                    Time change
+///     'V' u32 code, payload           Value change
+///
+/// The value payload size is fixed per code from its declaration: nothing
+/// for events, 8 bytes for reals, and otherwise 1, 2, 4 or 8 bytes for up to
+/// 8, 16, 32 or 64 bits, or 4 bytes per 32 bit word for wider signals, least
+/// significant word first. A zero tag ends the log; a trace that was not
+/// closed may have zero padding up to the end of the last written window.
+///
+//=============================================================================
+
+#ifndef VERILATOR_VERILATED_BIN_C_H_
+#define VERILATOR_VERILATED_BIN_C_H_
+
+#include "verilated.h"
+#include "verilated_trace.h"
+
+#include <string>
+#include <vector>
+
+class VerilatedBinBuffer;
+
+//=============================================================================
+// VerilatedBin
+// Base class to create a Verilator binary change-log dump
+// This is an internally used class - see VerilatedBinC for what to call from applications
+
+class VerilatedBin VL_NOT_FINAL : public VerilatedTrace<VerilatedBin, VerilatedBinBuffer> {
+public:
+    using Super = VerilatedTrace<VerilatedBin, VerilatedBinBuffer>;
+
+private:
+    friend VerilatedBinBuffer;  // Give the buffer access to the private bits
+
+    //=========================================================================
+    // Binary-specific internals
+
+    int m_fd = -1;  // File descriptor we're writing to
+    bool m_isOpen = false;  // True indicates open file
+    std::string m_filename;  // Filename we're writing to (if open)
+
+    // The output is written through a window onto the file. With mmap the
+    // window is a mapping of the file which slides forward as it fills,
+    // otherwise it is a plain buffer written out as it slides.
+    char* m_wrBufp = nullptr;  // Start of window
+    char* m_wrFlushp = nullptr;  // Window slide trigger location
+    char* m_writep = nullptr;  // Write pointer into window
+    char* m_wrTimeBeginp = nullptr;  // Write pointer for last time dump
+    char* m_wrTimeEndp = nullptr;  // Write pointer for last time dump
+    size_t m_wrWindowSize = 0;  // Window size
+    uint64_t m_wrOffset = 0;  // File offset of window start
+    size_t m_maxSignalBytes = 0;  // Upper bound on number of bytes a single signal can generate
+    static constexpr size_t WINDOW_SIZE = 16 * 1024 * 1024;  // Initial window size
+
+    // Prefixes to add to signal names/scope types
+    std::vector<std::pair<std::string, VerilatedTracePrefixType>> m_prefixStack{
+        {"", VerilatedTracePrefixType::SCOPE_MODULE}};
+
+    bool windowMap(uint64_t offset, size_t size);
+    void windowUnmap(size_t usedBytes);
+    void windowSlide(size_t newSize) VL_MT_UNSAFE_ONE;
+    void windowResize(size_t minsize);
+    void windowCheck() {
+        // Slide the window if there's not enough space left for another record
+        if (VL_UNLIKELY(m_writep > m_wrFlushp)) windowSlide(m_wrWindowSize);
+    }
+    void closeErr();
+    void writeBytes(const void* datap, size_t len);
+    void writeString(const std::string& str);
+    void declare(uint32_t code, const char* name, int kind, bool array, int arraynum,
+                 bool bussed, int msb, int lsb);
+
+    // CONSTRUCTORS
+    VL_UNCOPYABLE(VerilatedBin);
+
+protected:
+    //=========================================================================
+    // Implementation of VerilatedTrace interface
+
+    // Called when the trace moves forward to a new time point
+    void emitTimeChange(uint64_t timeui) override;
+
+    // Hooks called from VerilatedTrace
+    bool preFullDump() override { return isOpen(); }
+    bool preChangeDump() override { return isOpen(); }
+
+    // Trace buffer management
+    Buffer* getTraceBuffer(uint32_t fidx) override;
+    void commitTraceBuffer(Buffer*) override;
+
+    // Configure sub-class
+    void configure(const VerilatedTraceConfig&) override {}
+
+public:
+    //=========================================================================
+    // External interface to client code
+
+    // CONSTRUCTOR
+    VerilatedBin() = default;
+    ~VerilatedBin();
+
+    // METHODS - All must be thread safe
+    // Open the file; call isOpen() to see if errors
+    void open(const char* filename) VL_MT_SAFE_EXCLUDES(m_mutex);
+    // Close the file
+    void close() VL_MT_SAFE_EXCLUDES(m_mutex);
+    // Flush any remaining data to this file
+    void flush() VL_MT_SAFE_EXCLUDES(m_mutex);
+    // Return if file is open
+    bool isOpen() const VL_MT_SAFE { return m_isOpen; }
+
+    //=========================================================================
+    // Internal interface to Verilator generated code
+
+    void pushPrefix(const std::string&, VerilatedTracePrefixType);
+    void popPrefix();
+
+    void declEvent(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                   VerilatedTraceSigDirection, VerilatedTraceSigKind, VerilatedTraceSigType,
+                   bool array, int arraynum);
+    void declBit(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                 VerilatedTraceSigDirection, VerilatedTraceSigKind, VerilatedTraceSigType,
+                 bool array, int arraynum);
+    void declBus(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                 VerilatedTraceSigDirection, VerilatedTraceSigKind, VerilatedTraceSigType,
+                 bool array, int arraynum, int msb, int lsb);
+    void declQuad(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                  VerilatedTraceSigDirection, VerilatedTraceSigKind, VerilatedTraceSigType,
+                  bool array, int arraynum, int msb, int lsb);
+    void declArray(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                   VerilatedTraceSigDirection, VerilatedTraceSigKind, VerilatedTraceSigType,
+                   bool array, int arraynum, int msb, int lsb);
+    void declDouble(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                    VerilatedTraceSigDirection, VerilatedTraceSigKind, VerilatedTraceSigType,
+                    bool array, int arraynum);
+};
+
+#ifndef DOXYGEN
+// Declare specialization here as it's used in VerilatedBinC just below
+template <>
+void VerilatedBin::Super::dump(uint64_t time);
+template <>
+void VerilatedBin::Super::set_time_unit(const char* unitp);
+template <>
+void VerilatedBin::Super::set_time_unit(const std::string& unit);
+template <>
+void VerilatedBin::Super::set_time_resolution(const char* unitp);
+template <>
+void VerilatedBin::Super::set_time_resolution(const std::string& unit);
+template <>
+void VerilatedBin::Super::dumpvars(int level, const std::string& hier);
+template <>
+void VerilatedBin::Super::traceScopeEnable(const std::string& hier, bool enable);
+#endif  // DOXYGEN
+
+//=============================================================================
+// VerilatedBinBuffer
+
+class VerilatedBinBuffer VL_NOT_FINAL {
+    // Give the trace file and sub-classes access to the private bits
+    friend VerilatedBin;
+    friend VerilatedBin::Super;
+    friend VerilatedBin::Buffer;
+    friend VerilatedBin::OffloadBuffer;
+
+    VerilatedBin& m_owner;  // Trace file owning this buffer. Required by subclasses.
+
+    // Records are written straight into the owner's output window. Models Verilated
+    // with --trace-bin use neither parallel nor offloaded tracing (see
+    // V3Options::notify), so there is a single buffer at a time.
+    char* m_writep = m_owner.m_writep;  // Write pointer into output window
+    char* m_wrFlushp = m_owner.m_wrFlushp;  // Output window slide trigger location
+
+    VL_ATTR_ALWINLINE char* startRecord(uint32_t code);
+    VL_ATTR_ALWINLINE void finishRecord(char* writep);
+
+    // CONSTRUCTOR
+    explicit VerilatedBinBuffer(VerilatedBin& owner)
+        : m_owner{owner} {}
+    virtual ~VerilatedBinBuffer() = default;
+
+    //=========================================================================
+    // Implementation of VerilatedTraceBuffer interface
+    // Implementations of duck-typed methods for VerilatedTraceBuffer. These are
+    // called from only one place (the full* methods), so always inline them.
+    VL_ATTR_ALWINLINE void emitEvent(uint32_t code);
+    VL_ATTR_ALWINLINE void emitBit(uint32_t code, CData newval);
+    VL_ATTR_ALWINLINE void emitCData(uint32_t code, CData newval, int bits);
+    VL_ATTR_ALWINLINE void emitSData(uint32_t code, SData newval, int bits);
+    VL_ATTR_ALWINLINE void emitIData(uint32_t code, IData newval, int bits);
+    VL_ATTR_ALWINLINE void emitQData(uint32_t code, QData newval, int bits);
+    VL_ATTR_ALWINLINE void emitWData(uint32_t code, const WData* newvalp, int bits);
+    VL_ATTR_ALWINLINE void emitDouble(uint32_t code, double newval);
+};
+
+//=============================================================================
+// VerilatedBinC
+/// Class representing a binary change-log dump file in C standalone (no
+/// SystemC) simulations.  Also derived for use in SystemC simulations.
+
+class VerilatedBinC VL_NOT_FINAL : public VerilatedTraceBaseC {
+    VerilatedBin m_sptrace;  // Trace file being created
+
+    // CONSTRUCTORS
+    VL_UNCOPYABLE(VerilatedBinC);
+
+public:
+    /// Construct the dump
+    VerilatedBinC() = default;
+    /// Destruct, flush, and close the dump
+    virtual ~VerilatedBinC() { close(); }
+
+    // METHODS - User called
+
+    /// Return if file is open
+    bool isOpen() const override VL_MT_SAFE { return m_sptrace.isOpen(); }
+    /// Open a new binary trace file
+    virtual void open(const char* filename) VL_MT_SAFE { m_sptrace.open(filename); }
+    /// Close dump
+    void close() VL_MT_SAFE {
+        m_sptrace.close();
+        modelConnected(false);
+    }
+    /// Flush dump
+    void flush() VL_MT_SAFE { m_sptrace.flush(); }
+    /// Write one cycle of dump data
+    /// Call with the current context's time just after eval'ed,
+    /// e.g. ->dump(contextp->time())
+    void dump(uint64_t timeui) VL_MT_SAFE { m_sptrace.dump(timeui); }
+    /// Write one cycle of dump data - backward compatible and to reduce
+    /// conversion warnings.  It's better to use a uint64_t time instead.
+    void dump(double timestamp) { dump(static_cast<uint64_t>(timestamp)); }
+    void dump(uint32_t timestamp) { dump(static_cast<uint64_t>(timestamp)); }
+    void dump(int timestamp) { dump(static_cast<uint64_t>(timestamp)); }
+
+    // METHODS - Internal/backward compatible
+    // \protectedsection
+
+    // Set time units (s/ms, defaults to ns)
+    // Users should not need to call this, as for Verilated models, these
+    // propagate from the Verilated default timeunit
+    void set_time_unit(const char* unit) VL_MT_SAFE { m_sptrace.set_time_unit(unit); }
+    void set_time_unit(const std::string& unit) VL_MT_SAFE { m_sptrace.set_time_unit(unit); }
+    // Set time resolution (s/ms, defaults to ns)
+    // Users should not need to call this, as for Verilated models, these
+    // propagate from the Verilated default timeprecision
+    void set_time_resolution(const char* unit) VL_MT_SAFE { m_sptrace.set_time_resolution(unit); }
+    void set_time_resolution(const std::string& unit) VL_MT_SAFE {
+        m_sptrace.set_time_resolution(unit);
+    }
+    // Set variables to dump, using $dumpvars format
+    // If level = 0, dump everything and hier is then ignored
+    void dumpvars(int level, const std::string& hier) VL_MT_SAFE {
+        m_sptrace.dumpvars(level, hier);
+    }
+    // Enable or disable dumping signals under a scope, at any time
+    void traceScopeEnable(const std::string& hier, bool enable) VL_MT_SAFE {
+        m_sptrace.traceScopeEnable(hier, enable);
+    }
+
+    // Internal class access
+    VerilatedBin* spTrace() { return &m_sptrace; }
+};
+
+#endif  // guard
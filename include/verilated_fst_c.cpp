@@ -70,18 +70,37 @@ static_assert(std::is_same<vlFstEnumHandle, fstEnumHandle>::value, "vlFstHandle
 
 VerilatedFst::VerilatedFst(void* /*fst*/) {}
 
+VL_ATTR_ALWINLINE
+void VerilatedFst::Shard::emitTimeChangeMaybe() {
+    if (VL_UNLIKELY(m_timeui)) {
+        fstWriterEmitTimeChange(m_fst, m_timeui);
+        m_timeui = 0;
+    }
+}
+
 VerilatedFst::~VerilatedFst() {
-    if (m_fst) fstWriterClose(m_fst);
+    for (Shard& shard : m_shards) fstWriterClose(shard.m_fst);
     if (m_symbolp) VL_DO_CLEAR(delete[] m_symbolp, m_symbolp = nullptr);
-    if (m_strbufp) VL_DO_CLEAR(delete[] m_strbufp, m_strbufp = nullptr);
 }
 
 void VerilatedFst::open(const char* filename) VL_MT_SAFE_EXCLUDES(m_mutex) {
     const VerilatedLockGuard lock{m_mutex};
-    m_fst = fstWriterCreate(filename, 1);
-    fstWriterSetPackType(m_fst, FST_WR_PT_LZ4);
-    fstWriterSetTimescaleFromString(m_fst, timeResStr().c_str());  // lintok-begin-on-ref
-    if (m_useFstWriterThread) fstWriterSetParallelMode(m_fst, 1);
+    // With sharding, "name.fst" is written as "name_shard<n>.fst" files
+    std::string stem = filename;
+    if (stem.size() > 4 && stem.compare(stem.size() - 4, 4, ".fst") == 0) {
+        stem.erase(stem.size() - 4);
+    }
+    m_shards.resize(m_numShards);
+    for (unsigned i = 0; i < m_numShards; ++i) {
+        Shard& shard = m_shards[i];
+        shard.m_filename
+            = m_numShards == 1 ? filename : stem + "_shard" + std::to_string(i) + ".fst";
+        shard.m_fst = fstWriterCreate(shard.m_filename.c_str(), 1);
+        fstWriterSetPackType(shard.m_fst, FST_WR_PT_LZ4);
+        fstWriterSetTimescaleFromString(shard.m_fst,
+                                        timeResStr().c_str());  // lintok-begin-on-ref
+        if (m_useFstWriterThread) fstWriterSetParallelMode(shard.m_fst, 1);
+    }
     constDump(true);  // First dump must contain the const signals
     fullDump(true);  // First dump must be full for fst
 
@@ -95,34 +114,56 @@ void VerilatedFst::open(const char* filename) VL_MT_SAFE_EXCLUDES(m_mutex) {
     m_code2symbol.clear();
 
     // Allocate string buffer for arrays
-    if (!m_strbufp) m_strbufp = new char[maxBits() + 32];
+    for (Shard& shard : m_shards) shard.m_strbuf.resize(maxBits() + 32);
+
+    if (m_numShards > 1) writeManifest(stem + ".manifest");
+}
+
+void VerilatedFst::writeManifest(const std::string& filename) {
+    // Text file listing the shards, so they can be opened or merged together
+    FILE* const fp = std::fopen(filename.c_str(), "w");
+    if (VL_UNLIKELY(!fp)) {
+        const std::string msg = "Can't write FST shard manifest: " + filename;
+        VL_FATAL_MT(filename.c_str(), 0, "", msg.c_str());
+        return;
+    }
+    fprintf(fp, "# Verilator FST shard manifest\n");
+    fprintf(fp, "# Each shard has the full scope hierarchy, and a disjoint subset of the\n");
+    fprintf(fp, "# signals. Format: shard <filename relative to manifest> <signals>\n");
+    fprintf(fp, "timescale %s\n", timeResStr().c_str());
+    fprintf(fp, "shards %zu\n", m_shards.size());
+    for (const Shard& shard : m_shards) {
+        const size_t pos = shard.m_filename.find_last_of("/\\");
+        const std::string name
+            = pos == std::string::npos ? shard.m_filename : shard.m_filename.substr(pos + 1);
+        fprintf(fp, "shard %s %u\n", name.c_str(), shard.m_numSignals);
+    }
+    std::fclose(fp);
 }
 
 void VerilatedFst::close() VL_MT_SAFE_EXCLUDES(m_mutex) {
     const VerilatedLockGuard lock{m_mutex};
     Super::closeBase();
-    emitTimeChangeMaybe();
-    fstWriterClose(m_fst);
-    m_fst = nullptr;
+    for (Shard& shard : m_shards) {
+        shard.emitTimeChangeMaybe();
+        fstWriterClose(shard.m_fst);
+    }
+    m_shards.clear();
 }
 
 void VerilatedFst::flush() VL_MT_SAFE_EXCLUDES(m_mutex) {
     const VerilatedLockGuard lock{m_mutex};
     Super::flushBase();
-    emitTimeChangeMaybe();
-    fstWriterFlushContext(m_fst);
+    for (Shard& shard : m_shards) {
+        shard.emitTimeChangeMaybe();
+        fstWriterFlushContext(shard.m_fst);
+    }
 }
 
 void VerilatedFst::emitTimeChange(uint64_t timeui) {
-    if (!timeui) fstWriterEmitTimeChange(m_fst, timeui);
-    m_timeui = timeui;
-}
-
-VL_ATTR_ALWINLINE
-void VerilatedFst::emitTimeChangeMaybe() {
-    if (VL_UNLIKELY(m_timeui)) {
-        fstWriterEmitTimeChange(m_fst, m_timeui);
-        m_timeui = 0;
+    for (Shard& shard : m_shards) {
+        if (!timeui) fstWriterEmitTimeChange(shard.m_fst, timeui);
+        shard.m_timeui = timeui;
     }
 }
 
@@ -132,9 +173,11 @@ void VerilatedFst::emitTimeChangeMaybe() {
 void VerilatedFst::declDTypeEnum(int dtypenum, const char* name, uint32_t elements,
                                  unsigned int minValbits, const char** itemNamesp,
                                  const char** itemValuesp) {
-    const fstEnumHandle enumNum
-        = fstWriterCreateEnumTable(m_fst, name, elements, minValbits, itemNamesp, itemValuesp);
-    m_local2fstdtype[dtypenum] = enumNum;
+    for (Shard& shard : m_shards) {
+        const fstEnumHandle enumNum = fstWriterCreateEnumTable(
+            shard.m_fst, name, elements, minValbits, itemNamesp, itemValuesp);
+        shard.m_local2fstdtype[dtypenum] = enumNum;
+    }
 }
 
 // TODO: should return std::optional<fstScopeType>, but I can't have C++17
@@ -171,19 +214,23 @@ void VerilatedFst::pushPrefix(const std::string& name, VerilatedTracePrefixType
     m_prefixStack.emplace_back(newPrefix + (properScope ? " " : ""), type);
     if (properScope) {
         const std::string scopeName = lastWord(newPrefix);
-        fstWriterSetScope(m_fst, scopeType, scopeName.c_str(), nullptr);
+        for (Shard& shard : m_shards) {
+            fstWriterSetScope(shard.m_fst, scopeType, scopeName.c_str(), nullptr);
+        }
     }
 }
 
 void VerilatedFst::popPrefix() {
     assert(!m_prefixStack.empty());
     const bool properScope = toFstScopeType(m_prefixStack.back().second).first;
-    if (properScope) fstWriterSetUpscope(m_fst);
+    if (properScope) {
+        for (Shard& shard : m_shards) fstWriterSetUpscope(shard.m_fst);
+    }
     m_prefixStack.pop_back();
     assert(!m_prefixStack.empty());  // Always one left, the constructor's initial one
 }
 
-void VerilatedFst::declare(uint32_t code, const char* name, int dtypenum,
+void VerilatedFst::declare(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
                            VerilatedTraceSigDirection direction, VerilatedTraceSigKind kind,
                            VerilatedTraceSigType type, bool array, int arraynum, bool bussed,
                            int msb, int lsb) {
@@ -201,7 +248,11 @@ void VerilatedFst::declare(uint32_t code, const char* name, int dtypenum,
     if (bussed) name_ss << " [" << msb << ":" << lsb << "]";
     const std::string name_str = name_ss.str();
 
-    if (dtypenum > 0) fstWriterEmitEnumTableRef(m_fst, m_local2fstdtype[dtypenum]);
+    // Signals go in the file written by the trace function that dumps them
+    Shard& shard = m_shards[fidx % m_shards.size()];
+    ++shard.m_numSignals;
+
+    if (dtypenum > 0) fstWriterEmitEnumTableRef(shard.m_fst, shard.m_local2fstdtype[dtypenum]);
 
     fstVarDir varDir = FST_VD_IMPLICIT;
     switch (direction) {
@@ -244,44 +295,44 @@ void VerilatedFst::declare(uint32_t code, const char* name, int dtypenum,
     const auto it = vlstd::as_const(m_code2symbol).find(code);
     if (it == m_code2symbol.end()) {  // New
         m_code2symbol[code]
-            = fstWriterCreateVar(m_fst, varType, varDir, bits, name_str.c_str(), 0);
+            = fstWriterCreateVar(shard.m_fst, varType, varDir, bits, name_str.c_str(), 0);
     } else {  // Alias
-        fstWriterCreateVar(m_fst, varType, varDir, bits, name_str.c_str(), it->second);
+        fstWriterCreateVar(shard.m_fst, varType, varDir, bits, name_str.c_str(), it->second);
     }
 }
 
 void VerilatedFst::declEvent(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
                              VerilatedTraceSigDirection direction, VerilatedTraceSigKind kind,
                              VerilatedTraceSigType type, bool array, int arraynum) {
-    declare(code, name, dtypenum, direction, kind, type, array, arraynum, false, 0, 0);
+    declare(code, fidx, name, dtypenum, direction, kind, type, array, arraynum, false, 0, 0);
 }
 void VerilatedFst::declBit(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
                            VerilatedTraceSigDirection direction, VerilatedTraceSigKind kind,
                            VerilatedTraceSigType type, bool array, int arraynum) {
-    declare(code, name, dtypenum, direction, kind, type, array, arraynum, false, 0, 0);
+    declare(code, fidx, name, dtypenum, direction, kind, type, array, arraynum, false, 0, 0);
 }
 void VerilatedFst::declBus(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
                            VerilatedTraceSigDirection direction, VerilatedTraceSigKind kind,
                            VerilatedTraceSigType type, bool array, int arraynum, int msb,
                            int lsb) {
-    declare(code, name, dtypenum, direction, kind, type, array, arraynum, true, msb, lsb);
+    declare(code, fidx, name, dtypenum, direction, kind, type, array, arraynum, true, msb, lsb);
 }
 void VerilatedFst::declQuad(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
                             VerilatedTraceSigDirection direction, VerilatedTraceSigKind kind,
                             VerilatedTraceSigType type, bool array, int arraynum, int msb,
                             int lsb) {
-    declare(code, name, dtypenum, direction, kind, type, array, arraynum, true, msb, lsb);
+    declare(code, fidx, name, dtypenum, direction, kind, type, array, arraynum, true, msb, lsb);
 }
 void VerilatedFst::declArray(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
                              VerilatedTraceSigDirection direction, VerilatedTraceSigKind kind,
                              VerilatedTraceSigType type, bool array, int arraynum, int msb,
                              int lsb) {
-    declare(code, name, dtypenum, direction, kind, type, array, arraynum, true, msb, lsb);
+    declare(code, fidx, name, dtypenum, direction, kind, type, array, arraynum, true, msb, lsb);
 }
 void VerilatedFst::declDouble(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
                               VerilatedTraceSigDirection direction, VerilatedTraceSigKind kind,
                               VerilatedTraceSigType type, bool array, int arraynum) {
-    declare(code, name, dtypenum, direction, kind, type, array, arraynum, false, 63, 0);
+    declare(code, fidx, name, dtypenum, direction, kind, type, array, arraynum, false, 63, 0);
 }
 
 //=============================================================================
@@ -289,7 +340,11 @@ void VerilatedFst::declDouble(uint32_t code, uint32_t fidx, const char* name, in
 
 VerilatedFst::Buffer* VerilatedFst::getTraceBuffer(uint32_t fidx) {
     if (offload()) return new OffloadBuffer{*this};
-    return new Buffer{*this};
+    Buffer* const bufp = new Buffer{*this};
+    // Each trace function only dumps signals of its own shard, and with
+    // parallel tracing a given function always runs on the same thread
+    bufp->m_shardp = &m_shards[fidx % m_shards.size()];
+    return bufp;
 }
 
 void VerilatedFst::commitTraceBuffer(VerilatedFst::Buffer* bufp) {
@@ -309,6 +364,9 @@ void VerilatedFst::commitTraceBuffer(VerilatedFst::Buffer* bufp) {
 void VerilatedFst::configure(const VerilatedTraceConfig& config) {
     // If at least one model requests the FST writer thread, then use it
     m_useFstWriterThread |= config.m_useFstWriterThread;
+    // Use as many shards as the model with the most, so no shard is written
+    // by more than one trace function of a model
+    m_numShards = std::max(m_numShards, config.m_fstShards);
 }
 
 //=============================================================================
@@ -324,15 +382,15 @@ void VerilatedFst::configure(const VerilatedTraceConfig& config) {
 VL_ATTR_ALWINLINE
 void VerilatedFstBuffer::emitEvent(uint32_t code) {
     VL_DEBUG_IFDEF(assert(m_symbolp[code]););
-    m_owner.emitTimeChangeMaybe();
-    fstWriterEmitValueChange(m_fst, m_symbolp[code], "1");
+    m_shardp->emitTimeChangeMaybe();
+    fstWriterEmitValueChange(m_shardp->m_fst, m_symbolp[code], "1");
 }
 
 VL_ATTR_ALWINLINE
 void VerilatedFstBuffer::emitBit(uint32_t code, CData newval) {
     VL_DEBUG_IFDEF(assert(m_symbolp[code]););
-    m_owner.emitTimeChangeMaybe();
-    fstWriterEmitValueChange(m_fst, m_symbolp[code], newval ? "1" : "0");
+    m_shardp->emitTimeChangeMaybe();
+    fstWriterEmitValueChange(m_shardp->m_fst, m_symbolp[code], newval ? "1" : "0");
 }
 
 VL_ATTR_ALWINLINE
@@ -340,8 +398,8 @@ void VerilatedFstBuffer::emitCData(uint32_t code, CData newval, int bits) {
     char buf[VL_BYTESIZE];
     VL_DEBUG_IFDEF(assert(m_symbolp[code]););
     cvtCDataToStr(buf, newval << (VL_BYTESIZE - bits));
-    m_owner.emitTimeChangeMaybe();
-    fstWriterEmitValueChange(m_fst, m_symbolp[code], buf);
+    m_shardp->emitTimeChangeMaybe();
+    fstWriterEmitValueChange(m_shardp->m_fst, m_symbolp[code], buf);
 }
 
 VL_ATTR_ALWINLINE
@@ -349,8 +407,8 @@ void VerilatedFstBuffer::emitSData(uint32_t code, SData newval, int bits) {
     char buf[VL_SHORTSIZE];
     VL_DEBUG_IFDEF(assert(m_symbolp[code]););
     cvtSDataToStr(buf, newval << (VL_SHORTSIZE - bits));
-    m_owner.emitTimeChangeMaybe();
-    fstWriterEmitValueChange(m_fst, m_symbolp[code], buf);
+    m_shardp->emitTimeChangeMaybe();
+    fstWriterEmitValueChange(m_shardp->m_fst, m_symbolp[code], buf);
 }
 
 VL_ATTR_ALWINLINE
@@ -358,8 +416,8 @@ void VerilatedFstBuffer::emitIData(uint32_t code, IData newval, int bits) {
     char buf[VL_IDATASIZE];
     VL_DEBUG_IFDEF(assert(m_symbolp[code]););
     cvtIDataToStr(buf, newval << (VL_IDATASIZE - bits));
-    m_owner.emitTimeChangeMaybe();
-    fstWriterEmitValueChange(m_fst, m_symbolp[code], buf);
+    m_shardp->emitTimeChangeMaybe();
+    fstWriterEmitValueChange(m_shardp->m_fst, m_symbolp[code], buf);
 }
 
 VL_ATTR_ALWINLINE
@@ -367,14 +425,15 @@ void VerilatedFstBuffer::emitQData(uint32_t code, QData newval, int bits) {
     char buf[VL_QUADSIZE];
     VL_DEBUG_IFDEF(assert(m_symbolp[code]););
     cvtQDataToStr(buf, newval << (VL_QUADSIZE - bits));
-    m_owner.emitTimeChangeMaybe();
-    fstWriterEmitValueChange(m_fst, m_symbolp[code], buf);
+    m_shardp->emitTimeChangeMaybe();
+    fstWriterEmitValueChange(m_shardp->m_fst, m_symbolp[code], buf);
 }
 
 VL_ATTR_ALWINLINE
 void VerilatedFstBuffer::emitWData(uint32_t code, const WData* newvalp, int bits) {
     int words = VL_WORDS_I(bits);
-    char* wp = m_strbufp;
+    char* const strbufp = m_shardp->m_strbuf.data();
+    char* wp = strbufp;
     // Convert the most significant word
     const int bitsInMSW = VL_BITBIT_E(bits) ? VL_BITBIT_E(bits) : VL_EDATASIZE;
     cvtEDataToStr(wp, newvalp[--words] << (VL_EDATASIZE - bitsInMSW));
@@ -384,12 +443,12 @@ void VerilatedFstBuffer::emitWData(uint32_t code, const WData* newvalp, int bits
         cvtEDataToStr(wp, newvalp[--words]);
         wp += VL_EDATASIZE;
     }
-    m_owner.emitTimeChangeMaybe();
-    fstWriterEmitValueChange(m_fst, m_symbolp[code], m_strbufp);
+    m_shardp->emitTimeChangeMaybe();
+    fstWriterEmitValueChange(m_shardp->m_fst, m_symbolp[code], strbufp);
 }
 
 VL_ATTR_ALWINLINE
 void VerilatedFstBuffer::emitDouble(uint32_t code, double newval) {
-    m_owner.emitTimeChangeMaybe();
-    fstWriterEmitValueChange(m_fst, m_symbolp[code], &newval);
+    m_shardp->emitTimeChangeMaybe();
+    fstWriterEmitValueChange(m_shardp->m_fst, m_symbolp[code], &newval);
 }
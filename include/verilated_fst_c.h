@@ -51,14 +51,26 @@ private:
     //=========================================================================
     // FST-specific internals
 
-    fstWriterContext* m_fst = nullptr;
+    // One FST file. Normally there is a single shard, but with --trace-shards
+    // the signals are split over multiple files by the trace function that
+    // dumps them, so the parallel trace functions each write their own file.
+    struct Shard final {
+        fstWriterContext* m_fst = nullptr;  // The FST file handle
+        std::string m_filename;  // Name of the file
+        std::map<int, vlFstEnumHandle> m_local2fstdtype;
+        std::vector<char> m_strbuf;  // String buffer long enough to hold maxBits() chars
+        uint64_t m_timeui = 0;  // Time to emit, 0 = not needed
+        uint32_t m_numSignals = 0;  // Number of signals declared in this file
+
+        inline void emitTimeChangeMaybe();
+    };
+
+    std::vector<Shard> m_shards;  // The open files, empty when closed
     std::map<uint32_t, vlFstHandle> m_code2symbol;
-    std::map<int, vlFstEnumHandle> m_local2fstdtype;
     vlFstHandle* m_symbolp = nullptr;  // same as m_code2symbol, but as an array
-    char* m_strbufp = nullptr;  // String buffer long enough to hold maxBits() chars
-    uint64_t m_timeui = 0;  // Time to emit, 0 = not needed
 
     bool m_useFstWriterThread = false;  // Whether to use the separate FST writer thread
+    unsigned m_numShards = 1;  // Number of files to split the trace into
 
     // Prefixes to add to signal names/scope types
     std::vector<std::pair<std::string, VerilatedTracePrefixType>> m_prefixStack{
@@ -66,9 +78,10 @@ private:
 
     // CONSTRUCTORS
     VL_UNCOPYABLE(VerilatedFst);
-    void declare(uint32_t code, const char* name, int dtypenum, VerilatedTraceSigDirection,
-                 VerilatedTraceSigKind, VerilatedTraceSigType, bool array, int arraynum,
-                 bool bussed, int msb, int lsb);
+    void declare(uint32_t code, uint32_t fidx, const char* name, int dtypenum,
+                 VerilatedTraceSigDirection, VerilatedTraceSigKind, VerilatedTraceSigType,
+                 bool array, int arraynum, bool bussed, int msb, int lsb);
+    void writeManifest(const std::string& filename);
 
 protected:
     //=========================================================================
@@ -76,7 +89,6 @@ protected:
 
     // Called when the trace moves forward to a new time point
     void emitTimeChange(uint64_t timeui) override;
-    void emitTimeChangeMaybe();
 
     // Hooks called from VerilatedTrace
     bool preFullDump() override { return isOpen(); }
@@ -105,7 +117,7 @@ public:
     // Flush any remaining data to this file
     void flush() VL_MT_SAFE_EXCLUDES(m_mutex);
     // Return if file is open
-    bool isOpen() const VL_MT_SAFE { return m_fst != nullptr; }
+    bool isOpen() const VL_MT_SAFE { return !m_shards.empty(); }
 
     //=========================================================================
     // Internal interface to Verilator generated code
@@ -150,6 +162,8 @@ template <>
 void VerilatedFst::Super::set_time_resolution(const std::string& unit);
 template <>
 void VerilatedFst::Super::dumpvars(int level, const std::string& hier);
+template <>
+void VerilatedFst::Super::traceScopeEnable(const std::string& hier, bool enable);
 #endif
 
 //=============================================================================
@@ -164,12 +178,10 @@ class VerilatedFstBuffer VL_NOT_FINAL {
 
     VerilatedFst& m_owner;  // Trace file owning this buffer. Required by subclasses.
 
-    // The FST file handle
-    fstWriterContext* const m_fst = m_owner.m_fst;
+    // The file written, set by getTraceBuffer from the trace function index
+    VerilatedFst::Shard* m_shardp = &m_owner.m_shards.front();
     // code to fstHande map, as an array
     const vlFstHandle* const m_symbolp = m_owner.m_symbolp;
-    // String buffer long enough to hold maxBits() chars
-    char* const m_strbufp = m_owner.m_strbufp;
 
     // CONSTRUCTOR
     explicit VerilatedFstBuffer(VerilatedFst& owner)
@@ -254,6 +266,10 @@ public:
     void dumpvars(int level, const std::string& hier) VL_MT_SAFE {
         m_sptrace.dumpvars(level, hier);
     }
+    // Enable or disable dumping signals under a scope, at any time
+    void traceScopeEnable(const std::string& hier, bool enable) VL_MT_SAFE {
+        m_sptrace.traceScopeEnable(hier, enable);
+    }
 
     // Internal class access
     VerilatedFst* spTrace() { return &m_sptrace; }
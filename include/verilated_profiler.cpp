@@ -81,8 +81,11 @@ void VlExecutionProfiler::configure() {
 
 VerilatedVirtualBase* VlExecutionProfiler::construct(VerilatedContext& context) {
     VlExecutionProfiler* const selfp = new VlExecutionProfiler{context};
+    // Spin, park and yield times are only measured when dumped
+    VlMTaskVertex::profiling(true);
     if (VlThreadPool* const threadPoolp = static_cast<VlThreadPool*>(context.threadPoolp())) {
         for (int i = 0; i < threadPoolp->numThreads(); ++i) {
+            threadPoolp->workerp(i)->profiling(true);
             // Data to pass to worker thread initialization
             struct Data final {
                 VlExecutionProfiler* const selfp;
@@ -159,6 +162,21 @@ void VlExecutionProfiler::dump(const char* filenamep, uint64_t tickEnd)
     }
     fprintf(fp, "VLPROF stat threads %u\n", threads);
     fprintf(fp, "VLPROF stat yields %" PRIu64 "\n", VlMTaskVertex::yields());
+    fprintf(fp, "VLPROF stat yieldticks %" PRIu64 "\n", VlMTaskVertex::yieldTicks());
+    if (VlThreadPool* const threadPoolp
+        = static_cast<VlThreadPool*>(Verilated::threadContextp()->threadPoolp())) {
+        uint64_t spinTicks = 0;
+        uint64_t parkTicks = 0;
+        uint64_t parks = 0;
+        for (int i = 0; i < threadPoolp->numThreads(); ++i) {
+            spinTicks += threadPoolp->workerp(i)->spinTicks();
+            parkTicks += threadPoolp->workerp(i)->parkTicks();
+            parks += threadPoolp->workerp(i)->parks();
+        }
+        fprintf(fp, "VLPROF stat spinticks %" PRIu64 "\n", spinTicks);
+        fprintf(fp, "VLPROF stat parkticks %" PRIu64 "\n", parkTicks);
+        fprintf(fp, "VLPROF stat parks %" PRIu64 "\n", parks);
+    }
 
     // Copy /proc/cpuinfo into this output so verilator_gantt can be run on
     // a different machine
@@ -180,6 +180,8 @@ template <>
 void VerilatedSaif::Super::set_time_resolution(const std::string& unit);
 template <>
 void VerilatedSaif::Super::dumpvars(int level, const std::string& hier);
+template <>
+void VerilatedSaif::Super::traceScopeEnable(const std::string& hier, bool enable);
 #endif  // DOXYGEN
 
 //=============================================================================
@@ -284,6 +286,10 @@ public:
     void dumpvars(int level, const std::string& hier) VL_MT_SAFE {
         m_sptrace.dumpvars(level, hier);
     }
+    // Enable or disable dumping signals under a scope, at any time
+    void traceScopeEnable(const std::string& hier, bool enable) VL_MT_SAFE {
+        m_sptrace.traceScopeEnable(hier, enable);
+    }
 
     // Internal class access
     VerilatedSaif* spTrace() { return &m_sptrace; }
@@ -25,6 +25,9 @@
 
 #include "verilated_threads.h"
 
+#include "verilated_profiler.h"
+
+#include <algorithm>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
@@ -37,6 +40,8 @@
 // Internal note: Globals may multi-construct, see verilated.cpp top.
 
 std::atomic<uint64_t> VlMTaskVertex::s_yields;
+std::atomic<uint64_t> VlMTaskVertex::s_yieldTicks;
+std::atomic<bool> VlMTaskVertex::s_profiling;
 
 //=============================================================================
 // VlMTaskVertex
@@ -51,8 +56,7 @@ VlMTaskVertex::VlMTaskVertex(uint32_t upstreamDepCount)
 // VlWorkerThread
 
 VlWorkerThread::VlWorkerThread(VerilatedContext* contextp)
-    : m_ready_size{0}
-    , m_cthread{startWorker, this, contextp} {}
+    : m_cthread{startWorker, this, contextp} {}
 
 VlWorkerThread::~VlWorkerThread() {
     shutdown();
@@ -60,6 +64,19 @@ VlWorkerThread::~VlWorkerThread() {
     m_cthread.join();
 }
 
+void* VlWorkerThread::operator new(size_t size) {
+    // Over-allocate, and keep the pointer to free just below the aligned object
+    void* const rawp = ::operator new(size + VL_CACHE_LINE_BYTES);
+    const uintptr_t addr = (reinterpret_cast<uintptr_t>(rawp) + VL_CACHE_LINE_BYTES)
+                           & ~static_cast<uintptr_t>(VL_CACHE_LINE_BYTES - 1);
+    reinterpret_cast<void**>(addr)[-1] = rawp;
+    return reinterpret_cast<void*>(addr);
+}
+
+void VlWorkerThread::operator delete(void* objp) {
+    if (objp) ::operator delete(static_cast<void**>(objp)[-1]);
+}
+
 static void shutdownTask(void*, bool) {  // LCOV_EXCL_LINE
     // Deliberately empty, we use the address of this function as a magic number
 }
@@ -79,25 +96,225 @@ void VlWorkerThread::wait() {
     while (!flag.load()) std::this_thread::yield();
 }
 
-void VlWorkerThread::workerLoop() {
+void VlWorkerThread::workerLoop(const VerilatedContext* contextp) {
     ExecRec work;
 
     // Wait for the first task without spinning, in case the thread is never actually used.
-    dequeWork</* SpinWait: */ false>(&work);
+    dequeWork</* SpinWait: */ false>(&work, false);
 
     while (true) {
         if (VL_UNLIKELY(work.m_fnp == shutdownTask)) break;
         work.m_fnp(work.m_selfp, work.m_evenCycle);
         // Wait for next task with spinning.
-        dequeWork</* SpinWait: */ true>(&work);
+        dequeWork</* SpinWait: */ true>(&work, contextp->threadsSpin());
     }
 }
 
 void VlWorkerThread::startWorker(VlWorkerThread* workerp, VerilatedContext* contextp) {
     Verilated::threadContextp(contextp);
-    workerp->workerLoop();
+    workerp->workerLoop(contextp);
+}
+
+void VlWorkerThread::adaptSpinBudget(unsigned spins, uint64_t spinTicks, uint64_t parkTicks) {
+    // Length of the idle gap that just ended, in spins. If we parked, the gap outlasted
+    // the budget; convert the parked time using what a spin cost this time round.
+    uint64_t gap = spins;
+    if (parkTicks) {
+        gap = (spins && spinTicks) ? spins + static_cast<uint64_t>(static_cast<double>(parkTicks)
+                                                                  * spins / spinTicks)
+                                   : 2 * static_cast<uint64_t>(m_spinBudget);
+    }
+    // Gaps longer than the cap are the application doing something else, not eval
+    gap = std::min<uint64_t>(gap, VL_SPIN_BUDGET_MAX);
+    // Spin for twice the running average gap, so typical gaps are covered
+    m_idleGap = (7 * m_idleGap + gap) / 8;
+    m_spinBudget = static_cast<unsigned>(
+        std::max<uint64_t>(VL_LOCK_SPINS, std::min<uint64_t>(2 * m_idleGap, VL_SPIN_BUDGET_MAX)));
 }
 
+//=============================================================================
+// VlExecGraphRun - State for dynamic executions of a VlExecGraph, reused across them
+
+class VlExecGraphRun final {
+    // TYPES
+    // Each thread taking part owns a Chase-Lev work-stealing deque of ready mtasks. Only
+    // the owner pushes and takes, at the bottom, usually what its own work just enabled;
+    // thieves take the oldest entry at the top. An mtask is pushed at most once per
+    // execution, so a buffer the size of the graph never wraps. Padded, not alignas, as
+    // these are heap allocated and over-aligned 'new' needs C++17.
+    struct Participant final {
+        std::atomic<int64_t> m_top{0};  // Oldest entry; advanced by thieves and the owner
+        char m_topPad[VL_CACHE_LINE_BYTES - sizeof(std::atomic<int64_t>)];
+        std::atomic<int64_t> m_bottom{0};  // One past the newest entry; owner writes
+        std::atomic<uint32_t>* m_bufp = nullptr;  // Ready mtask indexes
+        VlExecGraphRun* m_runp = nullptr;  // State this is part of
+        uint32_t m_index = 0;  // Index of this participant
+        char m_endPad[VL_CACHE_LINE_BYTES];
+    };
+
+    // MEMBERS
+    const VlExecGraph& m_graph;  // Graph being executed
+    const uint32_t m_nParticipants;  // Workers plus the calling thread
+    const std::unique_ptr<std::atomic<uint32_t>[]> m_pendingDeps;  // Upstream mtasks not done
+    const std::unique_ptr<std::atomic<uint32_t>[]> m_buffers;  // Storage of all deques
+    const std::unique_ptr<Participant[]> m_participants;  // Per-thread ready deques
+    // Current execution
+    VlSelfP m_selfp = nullptr;  // Symbol table to execute
+    bool m_evenCycle = false;  // Even/odd for flag alternation
+    VlExecutionProfiler* m_profilerp = nullptr;  // Profiler to record waits with, if any
+    std::atomic<size_t> m_remaining{0};  // Mtasks not yet completed
+    std::atomic<uint32_t> m_workersActive{0};  // Workers not yet finished with this execution
+
+public:
+    // CONSTRUCTORS
+    VlExecGraphRun(const VlExecGraph& graph, uint32_t nParticipants)
+        : m_graph{graph}
+        , m_nParticipants{nParticipants}
+        , m_pendingDeps{new std::atomic<uint32_t>[graph.tasks().size()]}
+        , m_buffers{new std::atomic<uint32_t>[graph.tasks().size() * nParticipants]}
+        , m_participants{new Participant[nParticipants]} {
+        for (uint32_t i = 0; i < m_nParticipants; ++i) {
+            m_participants[i].m_bufp = &m_buffers[i * graph.tasks().size()];
+            m_participants[i].m_runp = this;
+            m_participants[i].m_index = i;
+        }
+    }
+    ~VlExecGraphRun() = default;
+
+    // METHODS
+    uint32_t nParticipants() const { return m_nParticipants; }
+    // Prepare an execution; called before handing participants to the workers
+    void start(VlSelfP selfp, bool evenCycle, VlExecutionProfiler* profilerp) {
+        m_selfp = selfp;
+        m_evenCycle = evenCycle;
+        m_profilerp = profilerp;
+        for (uint32_t i = 0; i < m_nParticipants; ++i) {
+            m_participants[i].m_top.store(0, std::memory_order_relaxed);
+            m_participants[i].m_bottom.store(0, std::memory_order_relaxed);
+        }
+        // Seed the deques with the initially ready mtasks on the threads the static
+        // schedule chose, in reverse so each thread starts with its first scheduled mtask
+        const std::vector<VlExecGraph::Task>& tasks = m_graph.tasks();
+        for (size_t i = tasks.size(); i-- > 0;) {
+            const VlExecGraph::Task& task = tasks[i];
+            m_pendingDeps[i].store(task.m_upstreamDepCount, std::memory_order_relaxed);
+            if (!task.m_upstreamDepCount) {
+                push(m_participants[task.m_hint % m_nParticipants], static_cast<uint32_t>(i));
+            }
+        }
+        m_remaining.store(tasks.size(), std::memory_order_relaxed);
+        m_workersActive.store(m_nParticipants - 1, std::memory_order_relaxed);
+    }
+    static void workerEntry(VlSelfP participantp, bool) {
+        Participant* const partp = static_cast<Participant*>(participantp);
+        VlExecGraphRun* const runp = partp->m_runp;
+        runp->participate(partp->m_index);
+        runp->m_workersActive.fetch_sub(1, std::memory_order_release);
+    }
+    Participant* participantp(uint32_t index) { return &m_participants[index]; }
+
+    // Run ready mtasks, stealing when out of own work, until the whole graph completed
+    void participate(uint32_t self) {
+        Participant& part = m_participants[self];
+        const bool profiling = m_profilerp && VL_UNLIKELY(m_profilerp->enabled());
+        bool waiting = false;
+        unsigned ct = 0;
+        while (m_remaining.load(std::memory_order_acquire)) {
+            uint32_t index;
+            if (take(part, index) || stealAny(self, index)) {
+                if (VL_UNLIKELY(waiting)) {
+                    waiting = false;
+                    VlExecutionProfiler::addRecord().threadScheduleWaitEnd();
+                }
+                execute(part, index);
+                ct = 0;
+                continue;
+            }
+            if (VL_UNLIKELY(profiling && !waiting)) {
+                waiting = true;
+                VlExecutionProfiler::addRecord().threadScheduleWaitBegin();
+            }
+            VL_CPU_RELAX();
+            if (VL_UNLIKELY(++ct > VL_LOCK_SPINS)) {
+                ct = 0;
+                VlMTaskVertex::yieldThread();
+            }
+        }
+        if (VL_UNLIKELY(waiting)) VlExecutionProfiler::addRecord().threadScheduleWaitEnd();
+    }
+    // The calling thread must not start another execution while a worker is in this one
+    void waitForWorkers() const {
+        unsigned ct = 0;
+        while (m_workersActive.load(std::memory_order_acquire)) {
+            VL_CPU_RELAX();
+            if (VL_UNLIKELY(++ct > VL_LOCK_SPINS)) {
+                ct = 0;
+                VlMTaskVertex::yieldThread();
+            }
+        }
+    }
+
+private:
+    void execute(Participant& part, uint32_t index) {
+        const VlExecGraph::Task& task = m_graph.tasks()[index];
+        task.m_fnp(m_selfp, m_evenCycle);
+        for (const uint32_t nextIndex : task.m_downstream) {
+            if (m_pendingDeps[nextIndex].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                // Keep it here, its inputs are likely in our cache; idle threads steal it
+                push(part, nextIndex);
+            }
+        }
+        m_remaining.fetch_sub(1, std::memory_order_release);
+    }
+    // Owner only
+    static void push(Participant& part, uint32_t index) {
+        const int64_t bottom = part.m_bottom.load(std::memory_order_relaxed);
+        part.m_bufp[bottom].store(index, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        part.m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    // Owner only
+    static bool take(Participant& part, uint32_t& index) {
+        const int64_t bottom = part.m_bottom.load(std::memory_order_relaxed) - 1;
+        part.m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = part.m_top.load(std::memory_order_relaxed);
+        if (top > bottom) {  // Empty
+            part.m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        index = part.m_bufp[bottom].load(std::memory_order_relaxed);
+        if (top != bottom) return true;
+        // Last entry, race the thieves for it
+        const bool won = part.m_top.compare_exchange_strong(
+            top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        part.m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return won;
+    }
+    static bool steal(Participant& part, uint32_t& index) {
+        int64_t top = part.m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = part.m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom) return false;
+        index = part.m_bufp[top].load(std::memory_order_relaxed);
+        return part.m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed);
+    }
+    bool stealAny(uint32_t self, uint32_t& index) {
+        for (uint32_t i = 1; i < m_nParticipants; ++i) {
+            if (steal(m_participants[(self + i) % m_nParticipants], index)) return true;
+        }
+        return false;
+    }
+
+    VL_UNCOPYABLE(VlExecGraphRun);
+};
+
+//=============================================================================
+// VlExecGraph
+
+VlExecGraph::~VlExecGraph() { delete m_idleRunp.load(std::memory_order_acquire); }
+
 //=============================================================================
 // VlThreadPool
 
@@ -114,6 +331,27 @@ VlThreadPool::~VlThreadPool() {
     for (auto& i : m_workers) delete i;
 }
 
+void VlThreadPool::executeGraph(const VlExecGraph& graph, VlSelfP selfp, bool evenCycle,
+                                unsigned nThreads, VlExecutionProfiler* profilerp) {
+    // The calling thread takes part as the last participant, like the last thread of a
+    // static schedule
+    const uint32_t nWorkers = nThreads - 1;
+    assert(nWorkers <= m_workers.size());
+    // Take the state kept from the previous execution, so none is allocated per eval
+    VlExecGraphRun* runp = graph.m_idleRunp.exchange(nullptr, std::memory_order_acquire);
+    if (VL_UNLIKELY(!runp)) runp = new VlExecGraphRun{graph, nThreads};
+    assert(runp->nParticipants() == nThreads);
+    runp->start(selfp, evenCycle, profilerp);
+    for (uint32_t i = 0; i < nWorkers; ++i) {
+        m_workers[i]->addTask(VlExecGraphRun::workerEntry, runp->participantp(i));
+    }
+    runp->participate(nWorkers);
+    runp->waitForWorkers();
+    // Keep it for next time. If another context executed the graph meanwhile, it may
+    // have left its own; keep only one.
+    delete graph.m_idleRunp.exchange(runp, std::memory_order_acq_rel);
+}
+
 bool VlThreadPool::isNumactlRunning() {
     // We assume if current thread is CPU-masked, then under numactl, otherwise not.
     // This shows that numactl is visible through the affinity mask
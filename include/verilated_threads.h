@@ -34,6 +34,10 @@
 #include <thread>
 #include <vector>
 
+#ifndef VL_SPIN_BUDGET_MAX
+#define VL_SPIN_BUDGET_MAX (16 * VL_LOCK_SPINS)  /// Most spins of a hot worker before parking
+#endif
+
 class VlExecutionProfiler;
 class VlThreadPool;
 
@@ -48,6 +52,8 @@ using VlExecFnp = void (*)(VlSelfP, bool);
 class VlMTaskVertex final {
     // MEMBERS
     static std::atomic<uint64_t> s_yields;  // Statistics
+    static std::atomic<uint64_t> s_yieldTicks;  // Statistics, CPU ticks spent yielding
+    static std::atomic<bool> s_profiling;  // Collect s_yieldTicks, set by --prof-exec
 
     // On even cycles, _upstreamDepsDone increases as upstream
     // dependencies complete. When it reaches _upstreamDepCount,
@@ -78,9 +84,20 @@ public:
     ~VlMTaskVertex() = default;
 
     static uint64_t yields() { return s_yields; }
+    static uint64_t yieldTicks() { return s_yieldTicks; }
+    static void profiling(bool flag) { s_profiling.store(flag, std::memory_order_relaxed); }
     static void yieldThread() {
         ++s_yields;  // Statistics
+        if (VL_LIKELY(!s_profiling.load(std::memory_order_relaxed))) {
+            std::this_thread::yield();
+            return;
+        }
+        uint64_t startTick;
+        VL_GET_CPU_TICK(startTick);
         std::this_thread::yield();
+        uint64_t endTick;
+        VL_GET_CPU_TICK(endTick);
+        s_yieldTicks.fetch_add(endTick - startTick, std::memory_order_relaxed);
     }
 
     // Upstream mtasks must call this when they complete.
@@ -105,11 +122,18 @@ public:
     }
     void waitUntilUpstreamDone(bool evenCycle) const {
         unsigned ct = 0;
+        unsigned rounds = 0;
         while (VL_UNLIKELY(!areUpstreamDepsDone(evenCycle))) {
             VL_CPU_RELAX();
             ++ct;
             if (VL_UNLIKELY(ct > VL_LOCK_SPINS)) {
                 ct = 0;
+                // With hot workers, give up the CPU only every VL_SPIN_BUDGET_MAX spins
+                if (Verilated::threadContextp()->threadsSpin()
+                    && ++rounds < VL_SPIN_BUDGET_MAX / VL_LOCK_SPINS) {
+                    continue;
+                }
+                rounds = 0;
                 yieldThread();
             }
         }
@@ -130,18 +154,35 @@ private:
             , m_evenCycle{evenCycle} {}
     };
 
+    // Tasks are handed over through a single-producer, single-consumer ring: only the
+    // thread driving the model (eval, trace, shutdown) adds tasks to a worker, and
+    // only the worker takes them. Queues are short, a few tasks per eval at most; a
+    // full ring makes the producer wait for the worker to catch up.
+    static constexpr size_t RING_SIZE = 64;  // Power of 2
+
     // MEMBERS
+    ExecRec m_ring[RING_SIZE];  // Pending tasks, from m_head up to m_tail (mod RING_SIZE)
+    // Count of tasks taken; written by the worker only
+    alignas(VL_CACHE_LINE_BYTES) std::atomic<size_t> m_head{0};
+    // Count of tasks added; written by the producer only
+    alignas(VL_CACHE_LINE_BYTES) std::atomic<size_t> m_tail{0};
+    // The worker found the ring empty after spinning and is parked on m_cv. Parking
+    // only goes through the mutex, so the common handoff never takes it.
+    std::atomic<bool> m_sleeping{false};
+#ifdef VL_DEBUG
+    std::atomic<bool> m_adding{false};  // A producer is in addTask, to catch a second one
+#endif
     mutable VerilatedMutex m_mutex;
     std::condition_variable_any m_cv;
-    // Only notify the condition_variable if the worker is waiting
-    bool m_waiting VL_GUARDED_BY(m_mutex) = false;
 
-    // Why a vector? We expect the pending list to be very short, typically
-    // 0 or 1 or 2, so popping from the front shouldn't be
-    // expensive. Revisit if we ever have longer queues...
-    std::vector<ExecRec> m_ready VL_GUARDED_BY(m_mutex);
-    // Store the size atomically, so we can spin wait
-    std::atomic<size_t> m_ready_size;
+    // Spin policy, see VerilatedContext::threadsSpin; written by the worker only
+    unsigned m_spinBudget = VL_LOCK_SPINS;  // Spins before parking when hot, adapted
+    uint64_t m_idleGap = 0;  // Running average of recent idle gaps, in spins
+    // Statistics; collected only when hot or profiling, written by the worker only
+    std::atomic<bool> m_profiling{false};  // Collect statistics, set by --prof-exec
+    std::atomic<uint64_t> m_spinTicks{0};  // CPU ticks spent spinning for work
+    std::atomic<uint64_t> m_parkTicks{0};  // CPU ticks spent parked waiting for work
+    std::atomic<uint64_t> m_parks{0};  // Number of times parked waiting for work
 
     std::thread m_cthread;  // Underlying C++ thread record
 
@@ -155,46 +196,133 @@ public:
     // CONSTRUCTORS
     explicit VlWorkerThread(VerilatedContext* contextp);
     ~VlWorkerThread();
+    // Workers are heap allocated, and before C++17 'new' ignores the over-alignment of
+    // m_head and m_tail, so align the allocation here
+    static void* operator new(size_t size);
+    static void operator delete(void* objp);
 
     // METHODS
+    // Hot workers ('hot' true) spin for an adaptive budget learned from recent idle
+    // gaps instead of the fixed VL_LOCK_SPINS, so they rarely park between evals
     template <bool N_SpinWait>
-    void dequeWork(ExecRec* workp) VL_MT_SAFE_EXCLUDES(m_mutex) {
+    void dequeWork(ExecRec* workp, bool hot) VL_MT_SAFE_EXCLUDES(m_mutex) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        // Only pay for reading the CPU tick when the spin policy or profiling needs it
+        const bool timed = hot || VL_UNLIKELY(m_profiling.load(std::memory_order_relaxed));
+        uint64_t startTick = 0;
+        if (timed) VL_GET_CPU_TICK(startTick);
         // Spin for a while, waiting for new data
+        unsigned spins = 0;
         if VL_CONSTEXPR_CXX17 (N_SpinWait) {
-            for (unsigned i = 0; i < VL_LOCK_SPINS; ++i) {
-                if (VL_LIKELY(m_ready_size.load(std::memory_order_relaxed))) break;
+            const unsigned budget = hot ? m_spinBudget : VL_LOCK_SPINS;
+            for (; spins < budget; ++spins) {
+                if (VL_LIKELY(m_tail.load(std::memory_order_acquire) != head)) break;
                 VL_CPU_RELAX();
             }
         }
-        VerilatedLockGuard lock{m_mutex};
-        while (m_ready.empty()) {
-            m_waiting = true;
-            m_cv.wait(m_mutex);
+        uint64_t parkTick = 0;
+        if (timed) VL_GET_CPU_TICK(parkTick);
+        uint64_t parkTicks = 0;
+        if (m_tail.load(std::memory_order_acquire) == head) {
+            {
+                VerilatedLockGuard lock{m_mutex};
+                // Pairs with addTask: either the producer sees m_sleeping, or we see its task
+                m_sleeping.store(true, std::memory_order_seq_cst);
+                while (m_tail.load(std::memory_order_seq_cst) == head) m_cv.wait(m_mutex);
+                m_sleeping.store(false, std::memory_order_relaxed);
+            }
+            if (timed) {
+                uint64_t endTick;
+                VL_GET_CPU_TICK(endTick);
+                parkTicks = endTick - parkTick;
+                statAdd(m_parkTicks, parkTicks);
+                statAdd(m_parks, 1);
+            }
+        }
+        *workp = m_ring[head % RING_SIZE];
+        m_head.store(head + 1, std::memory_order_release);
+        if VL_CONSTEXPR_CXX17 (N_SpinWait) {
+            if (timed) statAdd(m_spinTicks, parkTick - startTick);
+            if (hot) adaptSpinBudget(spins, parkTick - startTick, parkTicks);
         }
-        m_waiting = false;
-        // As noted above this is inefficient if our ready list is ever
-        // long (but it shouldn't be)
-        *workp = m_ready.front();
-        m_ready.erase(m_ready.begin());
-        m_ready_size.fetch_sub(1, std::memory_order_relaxed);
     }
     void addTask(VlExecFnp fnp, VlSelfP selfp, bool evenCycle = false)
         VL_MT_SAFE_EXCLUDES(m_mutex) {
-        bool notify;
-        {
+#ifdef VL_DEBUG
+        // Single producer: another thread adding tasks at the same time would race on m_tail
+        const bool otherAdding = m_adding.exchange(true, std::memory_order_acquire);
+        assert(!otherAdding);
+        static_cast<void>(otherAdding);
+#endif
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        while (VL_UNLIKELY(tail - m_head.load(std::memory_order_acquire) >= RING_SIZE)) {
+            VlMTaskVertex::yieldThread();
+        }
+        m_ring[tail % RING_SIZE] = ExecRec{fnp, selfp, evenCycle};
+        m_tail.store(tail + 1, std::memory_order_seq_cst);
+        if (VL_UNLIKELY(m_sleeping.load(std::memory_order_seq_cst))) {
+            // Taking the mutex waits for the worker to be inside m_cv.wait
             const VerilatedLockGuard lock{m_mutex};
-            m_ready.emplace_back(fnp, selfp, evenCycle);
-            m_ready_size.fetch_add(1, std::memory_order_relaxed);
-            notify = m_waiting;
+            m_cv.notify_one();
         }
-        if (notify) m_cv.notify_one();
+#ifdef VL_DEBUG
+        m_adding.store(false, std::memory_order_release);
+#endif
     }
 
     void shutdown();  // Finish current tasks, then terminate thread
     void wait();  // Blocks calling thread until all tasks complete in this thread
 
-    void workerLoop();
+    void workerLoop(const VerilatedContext* contextp);
     static void startWorker(VlWorkerThread* workerp, VerilatedContext* contextp);
+
+    // Statistics
+    void profiling(bool flag) { m_profiling.store(flag, std::memory_order_relaxed); }
+    uint64_t spinTicks() const { return m_spinTicks.load(std::memory_order_relaxed); }
+    uint64_t parkTicks() const { return m_parkTicks.load(std::memory_order_relaxed); }
+    uint64_t parks() const { return m_parks.load(std::memory_order_relaxed); }
+
+private:
+    // Single writer, so no need for an atomic read-modify-write
+    static void statAdd(std::atomic<uint64_t>& stat, uint64_t value) {
+        stat.store(stat.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    void adaptSpinBudget(unsigned spins, uint64_t spinTicks, uint64_t parkTicks);
+};
+
+class VlExecGraphRun;
+
+// Description of an mtask graph for dynamic execution (--threads-dynamic).
+// Constant and shared by all instances of a model. The state of an execution is
+// allocated on first use and kept here for the next one, see VlThreadPool::executeGraph.
+class VlExecGraph final {
+public:
+    // TYPES
+    struct Task final {
+        VlExecFnp m_fnp;  // Function to execute
+        uint32_t m_hint;  // Thread the static schedule assigned this mtask to
+        uint32_t m_upstreamDepCount;  // Number of upstream mtasks
+        std::vector<uint32_t> m_downstream;  // Indexes of downstream mtasks
+    };
+
+private:
+    // MEMBERS
+    const std::vector<Task> m_tasks;  // In static schedule order
+    // Execution state not in use. Taken exclusively while executing, so models in
+    // different contexts may execute the graph at the same time.
+    mutable std::atomic<VlExecGraphRun*> m_idleRunp{nullptr};
+
+    friend class VlThreadPool;
+    VL_UNCOPYABLE(VlExecGraph);
+
+public:
+    // CONSTRUCTORS
+    explicit VlExecGraph(std::vector<Task> tasks)
+        : m_tasks{std::move(tasks)} {}
+    ~VlExecGraph();
+
+    // METHODS
+    const std::vector<Task>& tasks() const { return m_tasks; }
 };
 
 class VlThreadPool final : public VerilatedVirtualBase {
@@ -232,6 +360,11 @@ public:
     unsigned assignTaskIndex() { return m_assignedTasks++; }
     int numThreads() const { return static_cast<int>(m_workers.size()); }
     std::string numaStatus() const { return m_numaStatus; }
+    // Execute an mtask graph on the first 'nThreads' - 1 workers and the calling thread,
+    // scheduling mtasks dynamically with work stealing. Returns when all have completed.
+    // With 'profilerp', records the time threads wait for ready mtasks.
+    void executeGraph(const VlExecGraph& graph, VlSelfP selfp, bool evenCycle, unsigned nThreads,
+                      VlExecutionProfiler* profilerp = nullptr);
     VlWorkerThread* workerp(int index) {
         assert(index >= 0);
         assert(index < static_cast<int>(m_workers.size()));
@@ -31,6 +31,7 @@
 #include <memory>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <map>
 #include <set>
 #include <vector>
@@ -175,11 +176,14 @@ public:
     const bool m_useParallel;  // Use parallel tracing
     const bool m_useOffloading;  // Offloading trace rendering
     const bool m_useFstWriterThread;  // Use the separate FST writer thread
+    const unsigned m_fstShards;  // Number of FST files to split the trace into
 
-    VerilatedTraceConfig(bool useParallel, bool useOffloading, bool useFstWriterThread)
+    VerilatedTraceConfig(bool useParallel, bool useOffloading, bool useFstWriterThread,
+                         unsigned fstShards = 1)
         : m_useParallel{useParallel}
         , m_useOffloading{useOffloading}
-        , m_useFstWriterThread{useFstWriterThread} {}
+        , m_useFstWriterThread{useFstWriterThread}
+        , m_fstShards{fstShards} {}
 };
 
 //=============================================================================
@@ -275,6 +279,7 @@ private:
 protected:
     uint32_t* m_sigs_oldvalp = nullptr;  // Previous value store
     EData* m_sigs_enabledp = nullptr;  // Bit vector of enabled codes (nullptr = all on)
+    EData* m_groupEnabledp = nullptr;  // Bit vector of enabled group codes (nullptr = all on)
 private:
     std::vector<bool> m_sigs_enabledVec;  // Staging for m_sigs_enabledp
     std::vector<CallbackRecord> m_initCbs;  // Routines to initialize tracing
@@ -292,6 +297,13 @@ private:
     uint32_t m_maxBits = 0;  // Number of bits in the widest signal
     // TODO: Should keep this as a Trie, that is how it's accessed all the time.
     std::vector<std::pair<int, std::string>> m_dumpvars;  // dumpvar() entries
+    // Runtime scope enables, see traceScopeEnable()
+    std::vector<std::pair<uint32_t, uint32_t>> m_sigScopes;  // (code, scope index) of signals
+    std::vector<std::string> m_scopeNames;  // Scope of each scope index, space separated
+    std::unordered_map<std::string, uint32_t> m_scopeIndex;  // Scope to index, during traceInit
+    std::vector<std::pair<uint32_t, uint32_t>> m_groups;  // [code, endCode) of trace groups
+    std::vector<std::pair<std::string, bool>> m_scopeEnables;  // traceScopeEnable() entries
+    bool m_recordScopes = false;  // Record signal scopes in m_sigScopes, see recordScopes()
     double m_timeRes = 1e-9;  // Time resolution (ns/ms etc)
     double m_timeUnit = 1e-0;  // Time units (ns/ms etc)
     uint64_t m_timeLastDump = 0;  // Last time we did a dump
@@ -372,6 +384,9 @@ protected:
     void closeBase();
     void flushBase();
 
+    // Recompute m_sigs_enabledp and m_groupEnabledp from m_scopeEnables
+    void applyScopeEnables();
+
     bool offload() const { return m_offload; }
     bool parallel() const { return m_parallel; }
 
@@ -416,6 +431,13 @@ public:
     // Set variables to dump, using $dumpvars format
     // If level = 0, dump everything and hier is then ignored
     void dumpvars(int level, const std::string& hier) VL_MT_SAFE;
+    // Enable or disable dumping of the values of all signals under the given
+    // scope, at any time, including while the trace is open. Later calls take
+    // precedence over earlier ones. An empty hier applies to everything and
+    // discards earlier calls. Only signals already declared (see dumpvars)
+    // can be enabled. To call it while open, it must also be called before
+    // open, or the model Verilated with --trace-scope-enable.
+    void traceScopeEnable(const std::string& hier, bool enable) VL_MT_SAFE_EXCLUDES(m_mutex);
 
     // Call
     void dump(uint64_t timeui) VL_MT_SAFE_EXCLUDES(m_mutex);
@@ -435,6 +457,11 @@ public:
     void addChgCb(dumpCb_t cb, uint32_t fidx, void* userp) VL_MT_SAFE;
     void addChgCb(dumpOffloadCb_t cb, uint32_t fidx, void* userp) VL_MT_SAFE;
     void addCleanupCb(cleanupCb_t cb, void* userp) VL_MT_SAFE;
+    // Declare codes [code, endCode) as a group dumped under one groupEnabled() check
+    void declGroup(uint32_t code, uint32_t endCode) VL_MT_UNSAFE;
+    // Record the scope of each signal when opened, so traceScopeEnable() may be called
+    // after open. Called for models Verilated with --trace-scope-enable.
+    void recordScopes() VL_MT_UNSAFE { m_recordScopes = true; }
 };
 
 //=============================================================================
@@ -457,6 +484,7 @@ protected:
 
     uint32_t* const m_sigs_oldvalp;  // Previous value store
     EData* const m_sigs_enabledp;  // Bit vector of enabled codes (nullptr = all on)
+    EData* const m_groupEnabledp;  // Bit vector of enabled group codes (nullptr = all on)
 
     explicit VerilatedTraceBuffer(Trace& owner);
     ~VerilatedTraceBuffer() override = default;
@@ -481,6 +509,11 @@ public:
 
     VL_ATTR_ALWINLINE uint32_t* oldp(uint32_t code) { return m_sigs_oldvalp + code; }
 
+    // Whether the group starting at the given code (see declGroup) has any enabled signal
+    VL_ATTR_ALWINLINE bool groupEnabled(uint32_t code) const {
+        return !m_groupEnabledp || VL_BITISSET_W(m_groupEnabledp, code);
+    }
+
     // Write to previous value buffer value and emit trace entry.
     void fullBit(uint32_t* oldp, CData newval);
     void fullCData(uint32_t* oldp, CData newval, int bits);
@@ -536,6 +569,14 @@ public:
         std::memcpy(&old, oldp, sizeof(old));
         if (VL_UNLIKELY(old != newval)) fullDouble(oldp, newval);
     }
+
+    // Check an unpacked array of 'elements' signals of at most 32 bits, whose
+    // previous values are consecutive words. Compares blocks of elements at once
+    // (SIMD where available) into a bitmask, and emits only the changed elements.
+    void chgBitArray(uint32_t* oldp, const CData* newvalp, int elements);
+    void chgCDataArray(uint32_t* oldp, const CData* newvalp, int elements, int bits);
+    void chgSDataArray(uint32_t* oldp, const SData* newvalp, int elements, int bits);
+    void chgIDataArray(uint32_t* oldp, const IData* newvalp, int elements, int bits);
 };
 
 //=============================================================================
@@ -293,6 +293,7 @@ template <>
 VerilatedTrace<VL_SUB_T, VL_BUF_T>::~VerilatedTrace() {
     if (m_sigs_oldvalp) VL_DO_CLEAR(delete[] m_sigs_oldvalp, m_sigs_oldvalp = nullptr);
     if (m_sigs_enabledp) VL_DO_CLEAR(delete[] m_sigs_enabledp, m_sigs_enabledp = nullptr);
+    if (m_groupEnabledp) VL_DO_CLEAR(delete[] m_groupEnabledp, m_groupEnabledp = nullptr);
     Verilated::removeFlushCb(VerilatedTrace<VL_SUB_T, VL_BUF_T>::onFlush, this);
     Verilated::removeExitCb(VerilatedTrace<VL_SUB_T, VL_BUF_T>::onExit, this);
     if (offload()) closeBase();
@@ -301,6 +302,47 @@ VerilatedTrace<VL_SUB_T, VL_BUF_T>::~VerilatedTrace() {
 //=========================================================================
 // Internals available to format-specific implementations
 
+template <>
+void VerilatedTrace<VL_SUB_T, VL_BUF_T>::applyScopeEnables() {
+    // Compute enable of each scope, the last matching traceScopeEnable entry wins
+    std::vector<bool> scopeEnabled(m_scopeNames.size(), true);
+    for (size_t idx = 0; idx < m_scopeNames.size(); ++idx) {
+        const std::string& scope = m_scopeNames[idx];
+        for (const auto& item : m_scopeEnables) {
+            const std::string& hier = item.first;
+            if (!hier.empty()
+                && (scope.compare(0, hier.size(), hier) != 0
+                    || (scope.size() > hier.size() && scope[hier.size()] != ' '))) {
+                continue;  // e.g. "t" isn't a match for "top"
+            }
+            scopeEnabled[idx] = item.second;
+        }
+    }
+    // Rebuild signal enables, starting from those signals declared by dumpvars
+    const size_t words = 1 + VL_WORDS_I(nextCode());
+    if (m_recordScopes) {
+        if (!m_sigs_enabledp) m_sigs_enabledp = new uint32_t[words];
+        std::fill_n(m_sigs_enabledp, words, 0);
+        for (const auto& item : m_sigScopes) {
+            if (scopeEnabled[item.second]) {
+                m_sigs_enabledp[VL_BITWORD_I(item.first)] |= 1U << VL_BITBIT_I(item.first);
+            }
+        }
+    }
+    // A group is enabled when any of its signals are
+    if (m_groups.empty() || !m_sigs_enabledp) return;
+    if (!m_groupEnabledp) m_groupEnabledp = new uint32_t[words];
+    std::fill_n(m_groupEnabledp, words, 0);
+    for (const auto& group : m_groups) {
+        for (uint32_t code = group.first; code < group.second; ++code) {
+            if (VL_BITISSET_W(m_sigs_enabledp, code)) {
+                m_groupEnabledp[VL_BITWORD_I(group.first)] |= 1U << VL_BITBIT_I(group.first);
+                break;
+            }
+        }
+    }
+}
+
 template <>
 void VerilatedTrace<VL_SUB_T, VL_BUF_T>::traceInit() VL_MT_UNSAFE {
     // Note: It is possible to re-open a trace file (VCD in particular),
@@ -311,6 +353,9 @@ void VerilatedTrace<VL_SUB_T, VL_BUF_T>::traceInit() VL_MT_UNSAFE {
     m_numSignals = 0;
     m_maxBits = 0;
     m_sigs_enabledVec.clear();
+    m_sigScopes.clear();
+    m_scopeNames.clear();
+    m_groups.clear();
 
     // Call all initialize callbacks, which will:
     // - Call decl* for each signal (these eventually call ::declCode)
@@ -342,6 +387,10 @@ void VerilatedTrace<VL_SUB_T, VL_BUF_T>::traceInit() VL_MT_UNSAFE {
         }
         m_sigs_enabledVec.clear();
     }
+    m_scopeIndex.clear();
+    if (m_groupEnabledp) VL_DO_CLEAR(delete[] m_groupEnabledp, m_groupEnabledp = nullptr);
+    // Also skips whole groups with no signals enabled by dumpvars
+    if (!m_scopeEnables.empty() || m_sigs_enabledp) applyScopeEnables();
 
     // Set callback so flush/abort will flush this file
     Verilated::addFlushCb(VerilatedTrace<VL_SUB_T, VL_BUF_T>::onFlush, this);
@@ -392,6 +441,14 @@ bool VerilatedTrace<VL_SUB_T, VL_BUF_T>::declCode(uint32_t code, const std::stri
         enabled = true;
         break;
     }
+    if (enabled && m_recordScopes) {
+        // Remember the scope, for traceScopeEnable
+        const size_t idx = declName.rfind(' ');
+        const std::string scope = idx == std::string::npos ? "" : declName.substr(0, idx);
+        const auto pair = m_scopeIndex.emplace(scope, m_scopeNames.size());
+        if (pair.second) m_scopeNames.push_back(scope);
+        m_sigScopes.emplace_back(code, pair.first->second);
+    }
 
     int codesNeeded = VL_WORDS_I(bits);
     m_nextCode = std::max(m_nextCode, code + codesNeeded);
@@ -441,6 +498,36 @@ void VerilatedTrace<VL_SUB_T, VL_BUF_T>::dumpvars(int level, const std::string&
     }
 }
 
+template <>
+void VerilatedTrace<VL_SUB_T, VL_BUF_T>::traceScopeEnable(const std::string& hier, bool enable)
+    VL_MT_SAFE_EXCLUDES(m_mutex) {
+    const VerilatedLockGuard lock{m_mutex};
+    // Convert Verilog . separators to trace space separators
+    std::string hierSpaced = hier;
+    for (auto& i : hierSpaced) {
+        if (i == '.') i = ' ';
+    }
+    if (hierSpaced.empty()) m_scopeEnables.clear();  // Overrides everything before
+    m_scopeEnables.emplace_back(hierSpaced, enable);
+    if (!nextCode()) {  // Not open yet, traceInit will apply
+        m_recordScopes = true;
+        return;
+    }
+    if (VL_UNLIKELY(!m_recordScopes)) {
+        VL_FATAL_MT(__FILE__, __LINE__, "",
+                    "traceScopeEnable() called after open() requires a call before open(), "
+                    "or a model Verilated with --trace-scope-enable");
+    }
+    // The offload worker reads the enables, so let it finish first
+    if (m_workerThread) flushBase();
+    applyScopeEnables();
+    if (enable) {
+        // Newly enabled signals have not been tracking their previous values
+        constDump(true);
+        fullDump(true);
+    }
+}
+
 template <>
 void VerilatedTrace<VL_SUB_T, VL_BUF_T>::parallelWorkerTask(void* datap, bool) {
     ParallelWorkerData* const wdp = reinterpret_cast<ParallelWorkerData*>(datap);
@@ -456,13 +543,13 @@ template <>
 VL_ATTR_NOINLINE void VerilatedTrace<VL_SUB_T, VL_BUF_T>::ParallelWorkerData::wait() {
     // Spin for a while, waiting for the buffer to become ready
     for (int i = 0; i < VL_LOCK_SPINS; ++i) {
-        if (VL_LIKELY(m_ready.load(std::memory_order_relaxed))) return;
+        if (VL_LIKELY(m_ready.load(std::memory_order_acquire))) return;
         VL_CPU_RELAX();
     }
     // We have been spinning for a while, so yield the thread
     VerilatedLockGuard lock{m_mutex};
     m_waiting = true;
-    m_cv.wait(m_mutex, [this] { return m_ready.load(std::memory_order_relaxed); });
+    m_cv.wait(m_mutex, [this] { return m_ready.load(std::memory_order_acquire); });
     m_waiting = false;
 }
 
@@ -473,8 +560,8 @@ void VerilatedTrace<VL_SUB_T, VL_BUF_T>::runCallbacks(const std::vector<Callback
         VlThreadPool* threadPoolp = static_cast<VlThreadPool*>(m_contextp->threadPoolp());
         // List of work items for thread (std::list, as ParallelWorkerData is not movable)
         std::list<ParallelWorkerData> workerData;
-        // We use the whole pool + the main thread
-        const unsigned threads = threadPoolp->numThreads() + 1;
+        // We use the whole pool + the main thread (there is no pool if single threaded)
+        const unsigned threads = threadPoolp ? threadPoolp->numThreads() + 1 : 1;
         // Main thread executes all jobs with index % threads == 0
         std::vector<ParallelWorkerData*> mainThreadWorkerData;
         // Enqueue all the jobs
@@ -717,6 +804,11 @@ template <>
 void VerilatedTrace<VL_SUB_T, VL_BUF_T>::addCleanupCb(cleanupCb_t cb, void* userp) VL_MT_SAFE {
     addCallbackRecord(m_cleanupCbs, CallbackRecord{cb, userp});
 }
+template <>
+void VerilatedTrace<VL_SUB_T, VL_BUF_T>::declGroup(uint32_t code, uint32_t endCode) VL_MT_UNSAFE {
+    // Called during traceInit, from the generated initialization functions
+    m_groups.emplace_back(code, endCode);
+}
 
 //=========================================================================
 // Primitives converting binary values to strings...
@@ -808,6 +900,73 @@ static inline void cvtQDataToStr(char* dstp, QData value) {
 
 #define cvtEDataToStr cvtIDataToStr
 
+//=========================================================================
+// Change detection over arrays of signals
+
+// Load 8 or 16 consecutive signals, zero extended to 32-bit lanes like the
+// previous value buffer
+#ifdef VL_HAVE_AVX2
+static inline __m256i traceLoad8(const CData* p) {
+    return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+static inline __m256i traceLoad8(const SData* p) {
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+static inline __m256i traceLoad8(const IData* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+#endif
+#ifdef VL_HAVE_AVX512
+// The zero-masked conversions, as the plain ones merge into an undefined vector, which
+// GCC reports as maybe uninitialized
+static inline __m512i traceLoad16(const CData* p) {
+    return _mm512_maskz_cvtepu8_epi32(0xffff,
+                                      _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+static inline __m512i traceLoad16(const SData* p) {
+    return _mm512_maskz_cvtepu16_epi32(
+        0xffff, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+}
+static inline __m512i traceLoad16(const IData* p) { return _mm512_loadu_si512(p); }
+#endif
+
+// Bitmask of which of 'n' (at most 32) signals differ from their previous values
+template <typename T_Elem>
+static inline uint32_t traceChangedMask(const uint32_t* oldp, const T_Elem* newvalp, int n) {
+    uint32_t mask = 0;
+    int i = 0;
+#if defined(VL_HAVE_AVX512)
+    for (; i + 16 <= n; i += 16) {
+        const __m512i old = _mm512_loadu_si512(oldp + i);
+        mask |= static_cast<uint32_t>(_mm512_cmpneq_epi32_mask(old, traceLoad16(newvalp + i)))
+                << i;
+    }
+#elif defined(VL_HAVE_AVX2)
+    for (; i + 8 <= n; i += 8) {
+        const __m256i old = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(oldp + i));
+        const __m256i eq = _mm256_cmpeq_epi32(old, traceLoad8(newvalp + i));
+        mask |= static_cast<uint32_t>(~_mm256_movemask_ps(_mm256_castsi256_ps(eq)) & 0xff) << i;
+    }
+#endif
+    // Branch free, so compilers can vectorize this too
+    for (; i < n; ++i) mask |= static_cast<uint32_t>(oldp[i] != newvalp[i]) << i;
+    return mask;
+}
+
+// Call 'full' for each element of the array that differs from its previous value
+template <typename T_Elem, typename T_Full>
+static inline void traceChgArray(uint32_t* oldp, const T_Elem* newvalp, int elements,
+                                 T_Full full) {
+    for (int base = 0; base < elements; base += 32) {
+        const int n = std::min(32, elements - base);
+        const uint32_t mask = traceChangedMask(oldp + base, newvalp + base, n);
+        if (VL_LIKELY(!mask)) continue;
+        for (int i = 0; i < n; ++i) {
+            if ((mask >> i) & 1) full(oldp + base + i, newvalp[base + i]);
+        }
+    }
+}
+
 //=========================================================================
 // VerilatedTraceBuffer
 
@@ -815,7 +974,8 @@ template <>
 VerilatedTraceBuffer<VL_BUF_T>::VerilatedTraceBuffer(Trace& owner)
     : VL_BUF_T{owner}
     , m_sigs_oldvalp{owner.m_sigs_oldvalp}
-    , m_sigs_enabledp{owner.m_sigs_enabledp} {}
+    , m_sigs_enabledp{owner.m_sigs_enabledp}
+    , m_groupEnabledp{owner.m_groupEnabledp} {}
 
 // These functions must write the new value back into the old value store,
 // and subsequently call the format-specific emit* implementations. Note
@@ -893,6 +1053,34 @@ void VerilatedTraceBuffer<VL_BUF_T>::fullDouble(uint32_t* oldp, double newval) {
     emitDouble(code, newval);
 }
 
+template <>
+void VerilatedTraceBuffer<VL_BUF_T>::chgBitArray(uint32_t* oldp, const CData* newvalp,
+                                                 int elements) {
+    traceChgArray(oldp, newvalp, elements,
+                  [this](uint32_t* elemOldp, CData newval) { fullBit(elemOldp, newval); });
+}
+template <>
+void VerilatedTraceBuffer<VL_BUF_T>::chgCDataArray(uint32_t* oldp, const CData* newvalp,
+                                                   int elements, int bits) {
+    traceChgArray(oldp, newvalp, elements, [this, bits](uint32_t* elemOldp, CData newval) {
+        fullCData(elemOldp, newval, bits);
+    });
+}
+template <>
+void VerilatedTraceBuffer<VL_BUF_T>::chgSDataArray(uint32_t* oldp, const SData* newvalp,
+                                                   int elements, int bits) {
+    traceChgArray(oldp, newvalp, elements, [this, bits](uint32_t* elemOldp, SData newval) {
+        fullSData(elemOldp, newval, bits);
+    });
+}
+template <>
+void VerilatedTraceBuffer<VL_BUF_T>::chgIDataArray(uint32_t* oldp, const IData* newvalp,
+                                                   int elements, int bits) {
+    traceChgArray(oldp, newvalp, elements, [this, bits](uint32_t* elemOldp, IData newval) {
+        fullIData(elemOldp, newval, bits);
+    });
+}
+
 //=========================================================================
 // VerilatedTraceOffloadBuffer
 
@@ -29,6 +29,8 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <csignal>
+#include <deque>
 #include <fcntl.h>
 
 #if defined(_WIN32) && !defined(__MINGW32__) && !defined(__CYGWIN__)
@@ -87,6 +89,81 @@ ssize_t VerilatedVcdFile::write(const char* bufp, ssize_t len) VL_MT_UNSAFE {
     return ::write(m_fd, bufp, len);
 }
 
+//=============================================================================
+// VerilatedVcdFlightFile
+// In-memory file used by the flight recorder. Each open() after the first
+// starts a new chunk, which the VerilatedVcd begins with a full dump
+// (keyframe); the oldest chunks are discarded to bound the memory used.
+
+class VerilatedVcdFlightFile final : public VerilatedVcdFile {
+    VerilatedVcdFile* const m_outp;  // File the window is written to
+    const size_t m_maxChunks;  // Maximum chunks to keep, including the one being written
+    const uint64_t m_maxBytes;  // Maximum bytes to keep
+    std::string m_filename;  // Filename from the first open
+    bool m_opened = false;  // Has been opened, so header is complete
+    std::string m_header;  // Declarations, written before the first keyframe
+    std::deque<std::string> m_chunks;  // Chunks starting with a keyframe, oldest first
+    uint64_t m_chunkBytes = 0;  // Total size of m_chunks
+
+public:
+    VerilatedVcdFlightFile(VerilatedVcdFile* outp, size_t maxChunks, uint64_t maxBytes)
+        : m_outp{outp}
+        , m_maxChunks{maxChunks}
+        , m_maxBytes{maxBytes} {}
+    ~VerilatedVcdFlightFile() override = default;
+    VerilatedVcdFile* outp() const { return m_outp; }
+    bool open(const std::string& name) override VL_MT_UNSAFE {
+        if (!m_opened) {
+            m_opened = true;
+            m_filename = name;
+            return true;
+        }
+        // Drop oldest chunks, always keeping the last complete one
+        while (m_chunks.size() > 1
+               && (m_chunks.size() >= m_maxChunks || m_chunkBytes > m_maxBytes)) {
+            m_chunkBytes -= m_chunks.front().size();
+            m_chunks.pop_front();
+        }
+        m_chunks.emplace_back();
+        return true;
+    }
+    void close() override VL_MT_UNSAFE {}
+    ssize_t write(const char* bufp, ssize_t len) override VL_MT_UNSAFE {
+        if (m_chunks.empty()) {
+            m_header.append(bufp, len);
+        } else {
+            m_chunks.back().append(bufp, len);
+            m_chunkBytes += len;
+        }
+        return len;
+    }
+    void writeWindow() VL_MT_UNSAFE {
+        if (!m_outp->open(m_filename)) return;
+        writeAll(m_header);
+        for (const std::string& chunk : m_chunks) writeAll(chunk);
+        m_outp->close();
+    }
+
+private:
+    void writeAll(const std::string& data) {
+        const char* wp = data.data();
+        const char* const endp = wp + data.size();
+        while (wp < endp) {
+            errno = 0;
+            const ssize_t got = m_outp->write(wp, endp - wp);
+            if (got > 0) {
+                wp += got;
+            } else if (VL_UNCOVERABLE(got < 0 && errno != EAGAIN && errno != EINTR)) {
+                // LCOV_EXCL_START
+                const std::string msg = "VerilatedVcd::flightDump: "s + std::strerror(errno);
+                VL_FATAL_MT("", 0, "", msg.c_str());
+                break;
+                // LCOV_EXCL_STOP
+            }
+        }
+    }
+};
+
 //=============================================================================
 //=============================================================================
 //=============================================================================
@@ -130,6 +207,8 @@ void VerilatedVcd::open(const char* filename) VL_MT_SAFE_EXCLUDES(m_mutex) {
 
     // When using rollover, the first chunk contains the header only.
     if (m_rolloverSize) openNextImp(true);
+    // Likewise with the flight recorder, which keeps the header
+    if (m_flightp) openNextImp(false);
 }
 
 void VerilatedVcd::openNext(bool incFilename) VL_MT_SAFE_EXCLUDES(m_mutex) {
@@ -183,11 +262,72 @@ void VerilatedVcd::openNextImp(bool incFilename) {
     m_wroteBytes = 0;
 }
 
+bool VerilatedVcd::preFullDump() {
+    if (VL_UNLIKELY(m_flightp)) flightStep();
+    return isOpen();
+}
+
 bool VerilatedVcd::preChangeDump() {
     if (VL_UNLIKELY(m_rolloverSize && m_wroteBytes > m_rolloverSize)) openNextImp(true);
+    if (VL_UNLIKELY(m_flightp)) flightStep();
     return isOpen();
 }
 
+//=============================================================================
+// Flight recorder
+
+std::atomic<uint32_t> VerilatedVcd::s_flightSignals{0};
+
+void VerilatedVcd::flightRecorder(uint64_t steps, uint64_t bytes) VL_MT_SAFE_EXCLUDES(m_mutex) {
+    const VerilatedLockGuard lock{m_mutex};
+    if (isOpen() || m_flightp || (!steps && !bytes)) return;
+    // Start a new chunk with a keyframe every quarter of the window, and keep
+    // enough chunks that at least the requested window is covered
+    m_flightKeyframeSteps = steps ? std::max<uint64_t>(1, steps / 4) : 0;
+    m_flightKeyframeBytes = bytes / 4;
+    m_flightp = new VerilatedVcdFlightFile{m_filep, steps ? 6 : SIZE_MAX,
+                                           bytes ? bytes : UINT64_MAX};
+    m_filep = m_flightp;
+    m_flightSignalsSeen = s_flightSignals;
+}
+
+void VerilatedVcd::flightStep() {
+    // Called before each dump, full or incremental
+    const uint32_t signals = s_flightSignals;
+    if (VL_UNLIKELY(signals != m_flightSignalsSeen)) {
+        m_flightSignalsSeen = signals;
+        flightWriteImp();
+    }
+    ++m_flightSteps;
+    const uint64_t bytes = m_wroteBytes + (m_writep - m_wrBufp);  // Including unflushed
+    if ((m_flightKeyframeSteps && m_flightSteps >= m_flightKeyframeSteps)
+        || (m_flightKeyframeBytes && bytes > m_flightKeyframeBytes)) {
+        m_flightSteps = 0;
+        openNextImp(false);  // New chunk, starting with a full dump
+    }
+}
+
+void VerilatedVcd::flightWriteImp() {
+    if (!isOpen()) return;
+    Super::flushBase();
+    bufferFlush();
+    m_flightp->writeWindow();
+}
+
+void VerilatedVcd::flightDump() VL_MT_SAFE_EXCLUDES(m_mutex) {
+    const VerilatedLockGuard lock{m_mutex};
+    if (m_flightp) flightWriteImp();
+}
+
+void VerilatedVcd::flightSignalHandler(int) {
+    // Only safe to count the signal here, the window is written at the next dump
+    ++s_flightSignals;
+}
+
+void VerilatedVcd::flightSignal(int signum) VL_MT_UNSAFE {
+    std::signal(signum, &VerilatedVcd::flightSignalHandler);
+}
+
 void VerilatedVcd::emitTimeChange(uint64_t timeui) {
     // Remember pointers when last emitted time stamp; if last output was
     // timestamp backup and overwrite it.
@@ -207,6 +347,10 @@ void VerilatedVcd::emitTimeChange(uint64_t timeui) {
 VerilatedVcd::~VerilatedVcd() {
     close();
     if (m_wrBufp) VL_DO_CLEAR(delete[] m_wrBufp, m_wrBufp = nullptr);
+    if (m_flightp) {
+        m_filep = m_flightp->outp();
+        VL_DO_CLEAR(delete m_flightp, m_flightp = nullptr);
+    }
     if (m_filep && m_fileNewed) VL_DO_CLEAR(delete m_filep, m_filep = nullptr);
     if (parallel()) {
         assert(m_numBuffers == m_freeBuffers.size());
@@ -239,6 +383,8 @@ void VerilatedVcd::close() VL_MT_SAFE_EXCLUDES(m_mutex) {
     // This function is on the flush() call path
     const VerilatedLockGuard lock{m_mutex};
     if (!isOpen()) return;
+    // A flight recorder only leaves a file behind on failure
+    if (m_flightp && Verilated::threadContextp()->gotError()) flightWriteImp();
     closePrev();
     // closePrev() called Super::flush(), so we just
     // need to shut down the tracing thread here.
@@ -249,6 +395,8 @@ void VerilatedVcd::flush() VL_MT_SAFE_EXCLUDES(m_mutex) {
     const VerilatedLockGuard lock{m_mutex};
     Super::flushBase();
     bufferFlush();
+    // Flushes after $stop, assertion failures and fatal errors write the window
+    if (m_flightp && Verilated::threadContextp()->gotError()) flightWriteImp();
 }
 
 void VerilatedVcd::printStr(const char* str) {
@@ -29,6 +29,7 @@
 
 class VerilatedVcdBuffer;
 class VerilatedVcdFile;
+class VerilatedVcdFlightFile;
 
 //=============================================================================
 // VerilatedVcd
@@ -61,6 +62,14 @@ private:
     size_t m_maxSignalBytes = 0;  // Upper bound on number of bytes a single signal can generate
     uint64_t m_wroteBytes = 0;  // Number of bytes written to this file
 
+    // Flight recorder, see flightRecorder()
+    VerilatedVcdFlightFile* m_flightp = nullptr;  // In-memory file, or nullptr if disabled
+    uint64_t m_flightKeyframeSteps = 0;  // Time steps between keyframes, 0 = by size only
+    uint64_t m_flightKeyframeBytes = 0;  // Bytes between keyframes, 0 = by steps only
+    uint64_t m_flightSteps = 0;  // Time steps since last keyframe
+    uint32_t m_flightSignalsSeen = 0;  // Value of s_flightSignals when last checked
+    static std::atomic<uint32_t> s_flightSignals;  // Count of flight recorder signals caught
+
     std::vector<char> m_suffixes;  // VCD line end string codes + metadata
 
     // Prefixes to add to signal names/scope types
@@ -79,6 +88,9 @@ private:
         if (VL_UNLIKELY(m_writep > m_wrFlushp)) bufferFlush();
     }
     void openNextImp(bool incFilename);
+    void flightStep();
+    void flightWriteImp();
+    static void flightSignalHandler(int);
     void closePrev();
     void closeErr();
     void printIndent(int level_change);
@@ -97,7 +109,7 @@ protected:
     void emitTimeChange(uint64_t timeui) override;
 
     // Hooks called from VerilatedTrace
-    bool preFullDump() override { return isOpen(); }
+    bool preFullDump() override;
     bool preChangeDump() override;
 
     // Trace buffer management
@@ -124,6 +136,12 @@ public:
     void open(const char* filename) VL_MT_SAFE_EXCLUDES(m_mutex);
     // Open next data-only file
     void openNext(bool incFilename) VL_MT_SAFE_EXCLUDES(m_mutex);
+    // Keep only the recent trace in memory, must be called before open()
+    void flightRecorder(uint64_t steps, uint64_t bytes) VL_MT_SAFE_EXCLUDES(m_mutex);
+    // Write the flight recorder's window to the file
+    void flightDump() VL_MT_SAFE_EXCLUDES(m_mutex);
+    // Install a signal handler that makes flight recorders write their window
+    static void flightSignal(int signum) VL_MT_UNSAFE;
     // Close the file
     void close() VL_MT_SAFE_EXCLUDES(m_mutex);
     // Flush any remaining data to this file
@@ -171,6 +189,8 @@ template <>
 void VerilatedVcd::Super::set_time_resolution(const std::string& unit);
 template <>
 void VerilatedVcd::Super::dumpvars(int level, const std::string& hier);
+template <>
+void VerilatedVcd::Super::traceScopeEnable(const std::string& hier, bool enable);
 #endif  // DOXYGEN
 
 //=============================================================================
@@ -284,6 +304,21 @@ public:
     /// alignment to a start of a given time's dump).  Any file but the
     /// first may be removed.  Cat files together to create viewable vcd.
     void rolloverSize(size_t size) VL_MT_SAFE { m_sptrace.rolloverSize(size); }
+    /// Flight recorder mode; must be called before open.  Rather than
+    /// writing to the file, keep the trace of at least the last 'steps' dump
+    /// calls in memory (if non-zero), using about at most 'bytes' of memory
+    /// (if non-zero).  The window, starting with a full dump of all signals,
+    /// is written as a complete VCD file by flightDump(), by a signal
+    /// registered with flightSignal(), or when the file is flushed or closed
+    /// after a $stop, assertion failure or other error.
+    void flightRecorder(uint64_t steps, uint64_t bytes = 0) VL_MT_SAFE {
+        m_sptrace.flightRecorder(steps, bytes);
+    }
+    /// Write the flight recorder window to the file now; recording continues
+    void flightDump() VL_MT_SAFE { m_sptrace.flightDump(); }
+    /// Make all flight recorders write their window at their next dump
+    /// after the given signal (e.g. SIGUSR1) is received
+    static void flightSignal(int signum) VL_MT_UNSAFE { VerilatedVcd::flightSignal(signum); }
     /// Close dump
     void close() VL_MT_SAFE {
         m_sptrace.close();
@@ -321,6 +356,10 @@ public:
     void dumpvars(int level, const std::string& hier) VL_MT_SAFE {
         m_sptrace.dumpvars(level, hier);
     }
+    // Enable or disable dumping signals under a scope, at any time
+    void traceScopeEnable(const std::string& hier, bool enable) VL_MT_SAFE {
+        m_sptrace.traceScopeEnable(hier, enable);
+    }
 
     // Internal class access
     VerilatedVcd* spTrace() { return &m_sptrace; }
@@ -861,6 +861,48 @@ class EmitCTrace final : EmitCFunc {
         puts(");\n");
     }
 
+    // Emit change detection of a whole unpacked array with one block-wise compare,
+    // if its elements are at most 32 bits, so take one previous value word each.
+    // Return false if not applicable.
+    bool emitTraceChangeArray(AstTraceInc* nodep) {
+        if (nodep->traceType() != VTraceType::CHANGE) return false;
+        if (v3Global.opt.useTraceOffload()) return false;
+        const AstVarRef* const varrefp = VN_CAST(nodep->valuep(), VarRef);
+        if (!varrefp || varrefp->varp()->isSc()) return false;
+        const AstBasicDType* const basicp = nodep->dtypep()->basicp();
+        if (!basicp || basicp->isDouble() || basicp->isEvent()) return false;
+        if (nodep->isWide() || nodep->isQuad()) return false;
+        // Elements must be stored as the C type chosen from the traced width
+        const AstUnpackArrayDType* const adtypep
+            = VN_CAST(varrefp->varp()->dtypep()->skipRefp(), UnpackArrayDType);
+        if (!adtypep || !VN_IS(adtypep->subDTypep()->skipRefp(), BasicDType)) return false;
+        const int elements = nodep->declp()->arrayRange().elements();
+        if (adtypep->elementsConst() != elements) return false;
+        const int width = nodep->declp()->widthMin();
+        if (adtypep->subDTypep()->widthMin() != width) return false;
+        // Short arrays are as fast unrolled
+        if (elements < 8) return false;
+
+        string stype;
+        if (width > 16) {
+            stype = "IData";
+        } else if (width > 8) {
+            stype = "SData";
+        } else if (width > 1) {
+            stype = "CData";
+        } else {
+            stype = "Bit";
+        }
+        putns(nodep, "bufp->chg" + stype + "Array(oldp+");
+        puts(cvtToStr(nodep->declp()->code() - nodep->baseCode()));
+        puts(",&");
+        emitTraceValue(nodep, 0);
+        puts("," + cvtToStr(elements));
+        if (stype != "Bit") puts("," + cvtToStr(width));
+        puts(");\n");
+        return true;
+    }
+
     void emitTraceValue(AstTraceInc* nodep, int arrayindex) {
         if (AstVarRef* const varrefp = VN_CAST(nodep->valuep(), VarRef)) {
             AstVar* const varp = varrefp->varp();
@@ -939,6 +981,7 @@ class EmitCTrace final : EmitCFunc {
     }
     void visit(AstTraceInc* nodep) override {
         if (nodep->declp()->arrayRange().ranged()) {
+            if (emitTraceChangeArray(nodep)) return;
             // It traces faster if we unroll the loop
             for (int i = 0; i < nodep->declp()->arrayRange().elements(); i++) {
                 emitTraceChangeOne(nodep, i);
@@ -522,6 +522,7 @@ class EmitCModel final : public EmitCFunc {
             puts(v3Global.opt.useTraceParallel() ? "true" : "false");
             puts(v3Global.opt.useTraceOffload() ? ", true" : ", false");
             puts(v3Global.opt.useFstWriterThread() ? ", true" : ", false");
+            if (v3Global.opt.useTraceShards()) puts(", " + cvtToStr(v3Global.opt.traceShards()));
             puts("}};\n");
             puts("};\n");
         }
@@ -587,6 +588,7 @@ class EmitCModel final : public EmitCFunc {
              + " and --trace-vcd with VerilatedVcd object\");\n");
         puts(/**/ "}\n");
         puts(/**/ "stfp->spTrace()->addModel(this);\n");
+        if (v3Global.opt.traceScopeEnable()) puts(/**/ "stfp->spTrace()->recordScopes();\n");
         puts(/**/ "stfp->spTrace()->addInitCb(&" + protect("trace_init")
              + ", &(vlSymsp->TOP));\n");
         puts(/**/ topModNameProtected + "__" + protect("trace_register")
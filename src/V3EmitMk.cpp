@@ -551,10 +551,15 @@ public:
         of.puts("VM_PARALLEL_BUILDS = ");
         of.puts(v3Global.useParallelBuild() ? "1" : "0");
         of.puts("\n");
-        of.puts("# Tracing output mode?  0/1 (from --trace-fst/--trace-saif/--trace-vcd)\n");
+        of.puts("# Tracing output mode?  0/1 (from --trace-bin/--trace-fst/--trace-saif/"
+                "--trace-vcd)\n");
         of.puts("VM_TRACE = ");
         of.puts(v3Global.opt.trace() ? "1" : "0");
         of.puts("\n");
+        of.puts("# Tracing output mode in binary format?  0/1 (from --trace-bin)\n");
+        of.puts("VM_TRACE_BIN = ");
+        of.puts(v3Global.opt.traceEnabledBin() ? "1" : "0");
+        of.puts("\n");
         of.puts("# Tracing output mode in FST format?  0/1 (from --trace-fst)\n");
         of.puts("VM_TRACE_FST = ");
         of.puts(v3Global.opt.traceEnabledFst() ? "1" : "0");
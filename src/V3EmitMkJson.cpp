@@ -204,6 +204,7 @@ class V3EmitMkJsonEmitter final {
                               .put("use_timing", v3Global.usesTiming())
                               .put("threads", v3Global.opt.threads())
                               .put("trace", v3Global.opt.trace())
+                              .put("trace_bin", v3Global.opt.traceEnabledBin())
                               .put("trace_fst", v3Global.opt.traceEnabledFst())
                               .put("trace_saif", v3Global.opt.traceEnabledSaif())
                               .put("trace_vcd", v3Global.opt.traceEnabledVcd())
@@ -705,6 +705,30 @@ void finalizeCosts(V3Graph* execMTaskGraphp) {
     }
 }
 
+void addMTaskBody(AstCFunc* funcp, const ExecMTask* mtaskp) {
+    FileLine* const fl = v3Global.rootp()->topModulep()->fileline();
+
+    // Helper function to make the code a bit more legible
+    const auto addStrStmt = [=](const string& stmt) -> void {  //
+        funcp->addStmtsp(new AstCStmt{fl, stmt});
+    };
+
+    if (v3Global.opt.profPgo()) {
+        // No lock around startCounter, as counter numbers are unique per thread
+        addStrStmt("vlSymsp->_vm_pgoProfiler.startCounter(" + std::to_string(mtaskp->id())
+                   + ");\n");
+    }
+
+    // Move the actual body into this function
+    funcp->addStmtsp(mtaskp->bodyp()->unlinkFrBack());
+
+    if (v3Global.opt.profPgo()) {
+        // No lock around stopCounter, as counter numbers are unique per thread
+        addStrStmt("vlSymsp->_vm_pgoProfiler.stopCounter(" + std::to_string(mtaskp->id())
+                   + ");\n");
+    }
+}
+
 void addMTaskToFunction(const ThreadSchedule& schedule, const uint32_t threadId, AstCFunc* funcp,
                         const ExecMTask* mtaskp) {
     AstNodeModule* const modp = v3Global.rootp()->topModulep();
@@ -735,20 +759,7 @@ void addMTaskToFunction(const ThreadSchedule& schedule, const uint32_t threadId,
         }
     }
 
-    if (v3Global.opt.profPgo()) {
-        // No lock around startCounter, as counter numbers are unique per thread
-        addStrStmt("vlSymsp->_vm_pgoProfiler.startCounter(" + std::to_string(mtaskp->id())
-                   + ");\n");
-    }
-
-    // Move the actual body into this function
-    funcp->addStmtsp(mtaskp->bodyp()->unlinkFrBack());
-
-    if (v3Global.opt.profPgo()) {
-        // No lock around stopCounter, as counter numbers are unique per thread
-        addStrStmt("vlSymsp->_vm_pgoProfiler.stopCounter(" + std::to_string(mtaskp->id())
-                   + ");\n");
-    }
+    addMTaskBody(funcp, mtaskp);
 
     // For any dependent mtask that's on another thread, signal one dependency completion.
     for (const V3GraphEdge& edge : mtaskp->outEdges()) {
@@ -964,6 +975,69 @@ void implementExecGraph(AstExecGraph* const execGraphp, const ThreadSchedule& sc
     addThreadStartToExecGraph(execGraphp, funcps, schedule.id());
 }
 
+void implementExecGraphDynamic(AstExecGraph* const execGraphp, const ThreadSchedule& schedule) {
+    // Nothing to be done if there are no MTasks in the graph at all.
+    if (execGraphp->depGraphp()->empty()) return;
+
+    AstNodeModule* const modp = v3Global.rootp()->topModulep();
+    FileLine* const fl = modp->fileline();
+    const string& tag = execGraphp->name();
+
+    const auto addTextStmt = [=](const string& text) -> void {
+        execGraphp->addStmtsp(new AstText{fl, text, /* tracking: */ true});
+    };
+
+    // Number the mtasks in static schedule order, which the run-time uses as a hint
+    std::vector<const ExecMTask*> mtasks;
+    std::unordered_map<const ExecMTask*, uint32_t> indexes;
+    for (const std::vector<const ExecMTask*>& thread : schedule.threads) {
+        for (const ExecMTask* const mtaskp : thread) {
+            indexes.emplace(mtaskp, static_cast<uint32_t>(mtasks.size()));
+            mtasks.push_back(mtaskp);
+        }
+    }
+
+    // Describe the graph to the run-time, with a function to run each mtask. The
+    // run-time tracks the dependencies, so the functions only hold the mtask bodies.
+    addTextStmt("{\nstatic const VlExecGraph graph{{\n");
+    for (const ExecMTask* const mtaskp : mtasks) {
+        const string name{"__Vmtask__" + tag + "__m" + cvtToStr(mtaskp->id()) + "__s"
+                          + cvtToStr(schedule.id())};
+        AstCFunc* const funcp = new AstCFunc{fl, name, nullptr, "void"};
+        modp->addStmtsp(funcp);
+        funcp->isStatic(true);  // Uses void self pointer, so static and hand rolled
+        funcp->isLoose(true);
+        funcp->entryPoint(true);
+        funcp->argTypes("void* voidSelf, bool even_cycle");
+        funcp->addStmtsp(new AstCStmt{fl, EmitCBase::voidSelfAssign(modp)});
+        funcp->addStmtsp(new AstCStmt{fl, EmitCBase::symClassAssign()});
+        addMTaskBody(funcp, mtaskp);
+
+        uint32_t nDependencies = 0;
+        for (const V3GraphEdge& edge : mtaskp->inEdges()) {
+            if (schedule.contains(edge.fromp()->as<ExecMTask>())) ++nDependencies;
+        }
+        string downstream;
+        for (const V3GraphEdge& edge : mtaskp->outEdges()) {
+            const ExecMTask* const nextp = edge.top()->as<ExecMTask>();
+            if (!schedule.contains(nextp)) continue;
+            if (!downstream.empty()) downstream += ", ";
+            downstream += cvtToStr(indexes.at(nextp));
+        }
+
+        addTextStmt("{");
+        execGraphp->addStmtsp(new AstAddrOfCFunc{fl, funcp});
+        addTextStmt(", " + cvtToStr(schedule.threadId(mtaskp)) + ", " + cvtToStr(nDependencies)
+                    + ", {" + downstream + "}},\n");
+    }
+    addTextStmt("}};\n");
+    // The run-time records the thread schedule waits itself, as they happen per mtask
+    const string profilerp = v3Global.opt.profExec() ? ", vlSymsp->__Vm_executionProfilerp" : "";
+    addTextStmt("vlSymsp->__Vm_threadPoolp->executeGraph(graph, vlSelf, vlSymsp->__Vm_even_cycle__"
+                + tag + ", " + cvtToStr(v3Global.opt.threads()) + profilerp + ");\n}\n");
+    V3Stats::addStatSum("Optimizations, Thread schedule dynamic", 1);
+}
+
 void implement(AstNetlist* netlistp) {
     // Called by Verilator top stage
     netlistp->topModulep()->foreach([&](AstExecGraph* execGraphp) {
@@ -988,9 +1062,16 @@ void implement(AstNetlist* netlistp) {
         // Wrap each MTask body into a CFunc for better profiling/debugging
         wrapMTaskBodies(execGraphp);
 
-        for (const ThreadSchedule& schedule : packed) {
-            // Replace the graph body with its multi-threaded implementation.
-            implementExecGraph(execGraphp, schedule);
+        // Dynamic scheduling needs the whole pool, so not with hierarchical blocks, which
+        // share it, nor with multi-threaded mtasks, which need separate schedules
+        if (v3Global.opt.threadsDynamic() && packed.size() == 1
+            && v3Global.opt.hierBlocks().empty() && !v3Global.opt.hierChild()) {
+            implementExecGraphDynamic(execGraphp, packed.front());
+        } else {
+            for (const ThreadSchedule& schedule : packed) {
+                // Replace the graph body with its multi-threaded implementation.
+                implementExecGraph(execGraphp, schedule);
+            }
         }
 
         addThreadEndWrapper(execGraphp);
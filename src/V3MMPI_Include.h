@@ -41,14 +41,23 @@ private:
         std::string sender_port_name;
     };
 
-    // Maps a port width to the appropriate C++ data type for the struct
+    // A parent wire that rank 0 broadcasts to several partitions instead of sending it
+    // in each rank pair's message
+    struct BroadcastGroup {
+        std::string wire;
+        int width = 0;
+        std::vector<std::pair<int, std::string>> members;  // {rank, receiving port}
+    };
+
+    // Maps a port width to the appropriate C++ data type for the struct.
+    // Ports wider than 64 bits are arrays of this type, see getWordCount().
     std::string getCppType(int width) {
         if (width == 1) return "bool";
         if (width <= 8) return "uint8_t";
         if (width <= 16) return "uint16_t";
         if (width <= 32) return "uint32_t";
         if (width <= 64) return "uint64_t";
-        return "uint64_t";  // Default for larger widths
+        return "uint32_t";  // Same word layout as VlWide and svBitVecVal
     }
 
     // Maps a port width to the corresponding MPI_Datatype
@@ -58,11 +67,962 @@ private:
         if (width <= 16) return "MPI_UINT16_T";
         if (width <= 32) return "MPI_UINT32_T";
         if (width <= 64) return "MPI_UINT64_T";
-        return "MPI_UINT64_T";
+        return "MPI_UINT32_T";
+    }
+
+    // Number of getCppType() elements needed to hold a port; 1 unless wider than 64 bits
+    int getWordCount(int width) { return (width <= 64) ? 1 : (width + 31) / 32; }
+
+    // Partition instances per MPI process (--mmpi-instances-per-rank)
+    int m_instancesPerRank = 1;
+
+    // MPI rank running partition id 'id'; rank 0 is always the testbench
+    int physicalRank(int id) const { return id == 0 ? 0 : 1 + (id - 1) / m_instancesPerRank; }
+
+    // Rank pairs inside one MPI process are exchanged through an in-memory queue
+    bool isColocated(const std::pair<int, int>& ranks) const {
+        return m_instancesPerRank > 1 && ranks.first != 0 && ranks.second != 0
+               && physicalRank(ranks.first) == physicalRank(ranks.second);
+    }
+
+    /**
+     * Assigns each link of a rank pair its bit offset in the packed wire buffer used with
+     * --mmpi-pack, and returns the offsets in link order. Links are laid out widest first, so
+     * ports wider than 64 bits (which occupy whole words and are block copied) and full
+     * 32/64-bit ports stay word aligned, and the narrow handshake signals fill the tail densely.
+     */
+    std::vector<int> computePackedOffsets(const std::vector<P2P_Link>& links, int& totalWords) {
+        std::vector<size_t> order(links.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return links[a].receiver_port_width > links[b].receiver_port_width;
+        });
+        std::vector<int> offsets(links.size());
+        int nextBit = 0;
+        for (size_t i : order) {
+            const int width = links[i].receiver_port_width;
+            offsets[i] = nextBit;
+            nextBit += (width > 64) ? getWordCount(width) * 32 : width;
+        }
+        totalWords = std::max(1, (nextBit + 31) / 32);
+        return offsets;
+    }
+
+    /**
+     * Emits the bit-field helpers and the per-rank-pair pack/unpack kernels for --mmpi-pack.
+     * The kernels convert between the message struct, which is what the send/receive API
+     * exposes, and the dense uint32_t wire buffer that is actually transferred.
+     */
+    void generatePackingKernels(
+        std::ofstream& outputFile,
+        const std::map<std::pair<int, int>, std::vector<P2P_Link>>& communication_graph) {
+        outputFile << "// --- Bit-packed wire format ---\n\n";
+        outputFile << "static inline void mpi_pack_bits(uint32_t* wire, int lsb, int width, uint64_t value) {\n";
+        outputFile << "    if (width < 64) value &= (1ULL << width) - 1;\n";
+        outputFile << "    int word = lsb / 32;\n";
+        outputFile << "    const int shift = lsb % 32;\n";
+        outputFile << "    wire[word] |= static_cast<uint32_t>(value << shift);\n";
+        outputFile << "    value >>= (32 - shift);\n";
+        outputFile << "    for (int done = 32 - shift; done < width; done += 32) {\n";
+        outputFile << "        wire[++word] |= static_cast<uint32_t>(value);\n";
+        outputFile << "        value >>= 32;\n";
+        outputFile << "    }\n";
+        outputFile << "}\n\n";
+        outputFile << "static inline uint64_t mpi_unpack_bits(const uint32_t* wire, int lsb, int width) {\n";
+        outputFile << "    int word = lsb / 32;\n";
+        outputFile << "    const int shift = lsb % 32;\n";
+        outputFile << "    uint64_t value = wire[word] >> shift;\n";
+        outputFile << "    for (int done = 32 - shift; done < width; done += 32) {\n";
+        outputFile << "        value |= static_cast<uint64_t>(wire[++word]) << done;\n";
+        outputFile << "    }\n";
+        outputFile << "    return (width < 64) ? (value & ((1ULL << width) - 1)) : value;\n";
+        outputFile << "}\n\n";
+
+        for (const auto& [ranks, links] : communication_graph) {
+            if (links.empty()) continue;
+            std::string suffix = std::to_string(ranks.first) + "_to_" + std::to_string(ranks.second);
+            std::string structName = "mpi_rank_" + suffix + "_t";
+            int totalWords = 0;
+            const std::vector<int> offsets = computePackedOffsets(links, totalWords);
+
+            int unpackedBytes = 0;
+            for (const auto& link : links) {
+                const int width = link.receiver_port_width;
+                unpackedBytes += (width <= 8) ? 1 : (width <= 16) ? 2
+                                 : (width <= 32) ? 4 : (width <= 64) ? 8 : getWordCount(width) * 4;
+            }
+            std::cout << "[Metro-MPI] Rank " << ranks.first << " -> " << ranks.second
+                      << ": packed " << links.size() << " ports into " << totalWords * 4
+                      << " bytes (" << unpackedBytes << " bytes unpacked, before padding)"
+                      << std::endl;
+
+            outputFile << "constexpr int mpi_words_rank_" << suffix << " = " << totalWords << ";\n\n";
+            outputFile << "static inline void mpi_pack_rank_" << suffix << "(const " << structName
+                       << "& message, uint32_t* wire) {\n";
+            outputFile << "    std::memset(wire, 0, sizeof(uint32_t) * mpi_words_rank_" << suffix << ");\n";
+            for (size_t i = 0; i < links.size(); ++i) {
+                const int width = links[i].receiver_port_width;
+                const std::string& field = links[i].sender_port_name;
+                if (width > 64) {
+                    outputFile << "    std::memcpy(wire + " << offsets[i] / 32 << ", message." << field
+                               << ", sizeof(message." << field << "));\n";
+                } else {
+                    outputFile << "    mpi_pack_bits(wire, " << offsets[i] << ", " << width
+                               << ", message." << field << ");\n";
+                }
+            }
+            outputFile << "}\n\n";
+            outputFile << "static inline void mpi_unpack_rank_" << suffix << "(const uint32_t* wire, "
+                       << structName << "& message) {\n";
+            for (size_t i = 0; i < links.size(); ++i) {
+                const int width = links[i].receiver_port_width;
+                const std::string& field = links[i].sender_port_name;
+                if (width > 64) {
+                    outputFile << "    std::memcpy(message." << field << ", wire + " << offsets[i] / 32
+                               << ", sizeof(message." << field << "));\n";
+                } else {
+                    outputFile << "    message." << field << " = static_cast<"
+                               << getCppType(width) << ">(mpi_unpack_bits(wire, " << offsets[i]
+                               << ", " << width << "));\n";
+                }
+            }
+            outputFile << "}\n\n";
+        }
+    }
+
+    /**
+     * Emits the per-rank-pair change-detection layer for --mmpi-delta. The encoder keeps a
+     * snapshot of the last message it sent and writes a dirty mask (one bit per field)
+     * followed by the raw bytes of only the fields that differ; an idle channel costs just
+     * the mask. The decoder applies the changed fields to its own snapshot and records
+     * in mpi_changed_rank_X_to_Y whether anything changed, so receivers can skip eval().
+     */
+    void generateDeltaKernels(
+        std::ofstream& outputFile,
+        const std::map<std::pair<int, int>, std::vector<P2P_Link>>& communication_graph) {
+        outputFile << "// --- Delta-encoded wire format ---\n\n";
+        for (const auto& [ranks, links] : communication_graph) {
+            if (links.empty()) continue;
+            std::string suffix = std::to_string(ranks.first) + "_to_" + std::to_string(ranks.second);
+            std::string structName = "mpi_rank_" + suffix + "_t";
+            std::string maskWords = "mpi_delta_mask_words_rank_" + suffix;
+
+            outputFile << "constexpr int " << maskWords << " = " << (links.size() + 31) / 32 << ";\n";
+            outputFile << "constexpr int mpi_delta_max_bytes_rank_" << suffix
+                       << " = sizeof(uint32_t) * " << maskWords << " + sizeof(" << structName << ");\n";
+            outputFile << "bool mpi_changed_rank_" << suffix << " = false;\n\n";
+
+            outputFile << "static int mpi_delta_encode_rank_" << suffix << "(const " << structName
+                       << "& message, unsigned char* wire) {\n";
+            outputFile << "    static " << structName << " last{};\n";
+            outputFile << "    static bool first = true;  // The first message carries every field\n";
+            outputFile << "    uint32_t mask[" << maskWords << "] = {};\n";
+            outputFile << "    int bytes = sizeof(mask);\n";
+            for (size_t i = 0; i < links.size(); ++i) {
+                const std::string& field = links[i].sender_port_name;
+                outputFile << "    if (first || std::memcmp(&message." << field << ", &last." << field
+                           << ", sizeof(message." << field << ")) != 0) {\n";
+                outputFile << "        mask[" << i / 32 << "] |= 1U << " << i % 32 << ";\n";
+                outputFile << "        std::memcpy(wire + bytes, &message." << field << ", sizeof(message."
+                           << field << "));\n";
+                outputFile << "        bytes += sizeof(message." << field << ");\n";
+                outputFile << "    }\n";
+            }
+            outputFile << "    std::memcpy(wire, mask, sizeof(mask));\n";
+            outputFile << "    last = message;\n";
+            outputFile << "    first = false;\n";
+            outputFile << "    return bytes;\n";
+            outputFile << "}\n\n";
+
+            outputFile << "static void mpi_delta_decode_rank_" << suffix << "(const unsigned char* wire, "
+                       << structName << "& message) {\n";
+            outputFile << "    static " << structName << " last{};\n";
+            outputFile << "    uint32_t mask[" << maskWords << "];\n";
+            outputFile << "    std::memcpy(mask, wire, sizeof(mask));\n";
+            outputFile << "    int bytes = sizeof(mask);\n";
+            outputFile << "    bool changed = false;\n";
+            for (size_t i = 0; i < links.size(); ++i) {
+                const std::string& field = links[i].sender_port_name;
+                outputFile << "    if (mask[" << i / 32 << "] & (1U << " << i % 32 << ")) {\n";
+                outputFile << "        std::memcpy(&last." << field << ", wire + bytes, sizeof(last."
+                           << field << "));\n";
+                outputFile << "        bytes += sizeof(last." << field << ");\n";
+                outputFile << "        changed = true;\n";
+                outputFile << "    }\n";
+            }
+            outputFile << "    message = last;\n";
+            outputFile << "    mpi_changed_rank_" << suffix << " = changed;\n";
+            outputFile << "}\n\n";
+        }
+    }
+
+    /**
+     * Emits the persistent-request transport used by partition ranks with --mmpi-nonblocking.
+     * Every rank pair gets a fixed send and receive buffer; the requests on them are created
+     * once by initialize_mpi_requests() and then only restarted, grouped per rank so a whole
+     * exchange is one MPI_Startall and one MPI_Waitall in each direction. Rank 0 keeps using
+     * the blocking functions, which match these requests like any other message. With a
+     * boundary clock the pairs to rank 0 get no send request, as partitions send them with
+     * the blocking functions after eval.
+     */
+    void generatePersistentRequests(
+        std::ofstream& outputFile,
+        const std::map<std::pair<int, int>, std::vector<P2P_Link>>& communication_graph,
+        bool pack, bool clocked) {
+        // Index of each pair's request in the per-rank request arrays
+        std::map<int, std::vector<std::pair<int, int>>> sendsOf;
+        std::map<int, std::vector<std::pair<int, int>>> receivesOf;
+        for (const auto& [ranks, links] : communication_graph) {
+            if (links.empty()) continue;
+            if (ranks.first != 0 && !(clocked && ranks.second == 0)) {
+                sendsOf[ranks.first].push_back(ranks);
+            }
+            if (ranks.second != 0) receivesOf[ranks.second].push_back(ranks);
+        }
+
+        outputFile << "// --- Persistent requests for non-blocking exchange ---\n\n";
+        outputFile << "#ifdef METRO_MPI_SHM\n";
+        outputFile << "#error \"--mmpi-nonblocking needs the MPI transport\"\n";
+        outputFile << "#endif\n\n";
+        for (const auto& [ranks, links] : communication_graph) {
+            if (links.empty()) continue;
+            std::string suffix = std::to_string(ranks.first) + "_to_" + std::to_string(ranks.second);
+            outputFile << "mpi_rank_" << suffix << "_t mpi_sendbuf_rank_" << suffix << ";\n";
+            outputFile << "mpi_rank_" << suffix << "_t mpi_recvbuf_rank_" << suffix << ";\n";
+            if (pack) {
+                // The requests are bound to the packed buffers; the structs above are
+                // converted at start and completion
+                outputFile << "uint32_t mpi_sendwire_rank_" << suffix << "[mpi_words_rank_" << suffix << "];\n";
+                outputFile << "uint32_t mpi_recvwire_rank_" << suffix << "[mpi_words_rank_" << suffix << "];\n";
+            }
+        }
+        for (const auto& [rank, pairs] : sendsOf) {
+            outputFile << "MPI_Request mpi_send_requests_rank_" << rank << "[" << pairs.size()
+                       << "];\n";
+        }
+        for (const auto& [rank, pairs] : receivesOf) {
+            outputFile << "MPI_Request mpi_recv_requests_rank_" << rank << "[" << pairs.size()
+                       << "];\n";
+        }
+        outputFile << "\n";
+
+        outputFile << "void initialize_mpi_requests() {\n";
+        outputFile << "    int rank;\n";
+        outputFile << "    MPI_Comm_rank(MPI_COMM_WORLD, &rank);\n";
+        outputFile << "    switch (rank) {\n";
+        std::set<int> ranks;
+        for (const auto& it : sendsOf) ranks.insert(it.first);
+        for (const auto& it : receivesOf) ranks.insert(it.first);
+        for (int r : ranks) {
+            outputFile << "        case " << r << ": {\n";
+            if (sendsOf.count(r)) {
+                const auto& pairs = sendsOf.at(r);
+                for (size_t i = 0; i < pairs.size(); ++i) {
+                    std::string suffix = std::to_string(pairs[i].first) + "_to_"
+                                         + std::to_string(pairs[i].second);
+                    outputFile << "            MPI_Send_init(" << (pack ? "mpi_sendwire_rank_" : "&mpi_sendbuf_rank_") << suffix
+                               << ", 1, mpi_type_rank_" << suffix << ", " << pairs[i].second
+                               << ", 0, MPI_COMM_WORLD, &mpi_send_requests_rank_" << r << "["
+                               << i << "]);\n";
+                }
+            }
+            if (receivesOf.count(r)) {
+                const auto& pairs = receivesOf.at(r);
+                for (size_t i = 0; i < pairs.size(); ++i) {
+                    std::string suffix = std::to_string(pairs[i].first) + "_to_"
+                                         + std::to_string(pairs[i].second);
+                    outputFile << "            MPI_Recv_init(" << (pack ? "mpi_recvwire_rank_" : "&mpi_recvbuf_rank_") << suffix
+                               << ", 1, mpi_type_rank_" << suffix << ", " << pairs[i].first
+                               << ", 0, MPI_COMM_WORLD, &mpi_recv_requests_rank_" << r << "["
+                               << i << "]);\n";
+                }
+            }
+            outputFile << "            break;\n";
+            outputFile << "        }\n";
+        }
+        outputFile << "        default: break;\n";
+        outputFile << "    }\n";
+        outputFile << "}\n\n";
+
+        outputFile << "void free_mpi_requests() {\n";
+        outputFile << "    int rank;\n";
+        outputFile << "    MPI_Comm_rank(MPI_COMM_WORLD, &rank);\n";
+        outputFile << "    switch (rank) {\n";
+        for (int r : ranks) {
+            outputFile << "        case " << r << ": {\n";
+            if (sendsOf.count(r)) {
+                outputFile << "            for (MPI_Request& request : mpi_send_requests_rank_"
+                           << r << ") MPI_Request_free(&request);\n";
+            }
+            if (receivesOf.count(r)) {
+                outputFile << "            for (MPI_Request& request : mpi_recv_requests_rank_"
+                           << r << ") MPI_Request_free(&request);\n";
+            }
+            outputFile << "            break;\n";
+            outputFile << "        }\n";
+        }
+        outputFile << "        default: break;\n";
+        outputFile << "    }\n";
+        outputFile << "}\n\n";
+
+        for (const auto& [rank, pairs] : sendsOf) {
+            outputFile << "extern void mpi_start_sends_rank_" << rank << "() {\n";
+            if (pack) {
+                for (const auto& ranksPair : pairs) {
+                    std::string suffix = std::to_string(ranksPair.first) + "_to_"
+                                         + std::to_string(ranksPair.second);
+                    outputFile << "    mpi_pack_rank_" << suffix << "(mpi_sendbuf_rank_" << suffix
+                               << ", mpi_sendwire_rank_" << suffix << ");\n";
+                }
+            }
+            outputFile << "    MPI_Startall(" << pairs.size() << ", mpi_send_requests_rank_"
+                       << rank << ");\n";
+            outputFile << "}\n\n";
+            outputFile << "extern void mpi_wait_sends_rank_" << rank << "() {\n";
+            outputFile << "    MPI_Waitall(" << pairs.size() << ", mpi_send_requests_rank_"
+                       << rank << ", MPI_STATUSES_IGNORE);\n";
+            outputFile << "}\n\n";
+        }
+        for (const auto& [rank, pairs] : receivesOf) {
+            outputFile << "extern void mpi_start_receives_rank_" << rank << "() {\n";
+            outputFile << "    MPI_Startall(" << pairs.size() << ", mpi_recv_requests_rank_"
+                       << rank << ");\n";
+            outputFile << "}\n\n";
+            outputFile << "extern void mpi_wait_receives_rank_" << rank << "() {\n";
+            outputFile << "    MPI_Waitall(" << pairs.size() << ", mpi_recv_requests_rank_"
+                       << rank << ", MPI_STATUSES_IGNORE);\n";
+            if (pack) {
+                for (const auto& ranksPair : pairs) {
+                    std::string suffix = std::to_string(ranksPair.first) + "_to_"
+                                         + std::to_string(ranksPair.second);
+                    outputFile << "    mpi_unpack_rank_" << suffix << "(mpi_recvwire_rank_" << suffix
+                               << ", mpi_recvbuf_rank_" << suffix << ");\n";
+                }
+            }
+            outputFile << "}\n\n";
+        }
     }
 
 public:
     // Main function to generate the MPI source file from a JSON report
+    /**
+     * Gives every partition a rank pair to and from rank 0, and adds the metro_mpi_ctrl
+     * field to those pairs. Termination rides on it instead of a separate message: rank 0
+     * sets STOP in its last message to each partition, and a partition that ran $finish
+     * sets STOP towards rank 0, which then ends the testbench loop. Partitions without
+     * boundary ports to rank 0 get pairs holding only this field.
+     */
+    void addControlLinks(const json& data,
+                         std::map<std::pair<int, int>, std::vector<P2P_Link>>& communication_graph) {
+        for (auto const& [partitionName, ports] : data["partitions"].items()) {
+            if (ports.empty()) continue;
+            const int rank = ports.front()["mpi_rank"];
+            communication_graph[{0, rank}].push_back(
+                {partitionName, rank, "metro_mpi_ctrl", 2, "system", 0, "metro_mpi_ctrl"});
+            communication_graph[{rank, 0}].push_back(
+                {"system", 0, "metro_mpi_ctrl", 2, partitionName, rank, "metro_mpi_ctrl"});
+        }
+    }
+
+    /**
+     * Emits the shared-memory transport selected with -DMETRO_MPI_SHM, for runs where every
+     * rank is on one host. Each rank pair that crosses processes (and each member of a
+     * rank 0 broadcast) gets a lock-free
+     * single-producer/single-consumer ring in one POSIX shared-memory segment, and the
+     * send/receive functions push and pop the same wire bytes they would hand to MPI.
+     * Processes are started without mpirun, each with METRO_MPI_RANK and METRO_MPI_SIZE in
+     * its environment.
+     */
+    void generateShmTransport(std::ofstream& outputFile,
+                              const std::vector<std::pair<std::string, std::string>>& rings,
+                              int numRanks, int lookahead) {
+        outputFile << "#ifdef METRO_MPI_SHM\n";
+        outputFile << "// --- Shared-memory transport (-DMETRO_MPI_SHM) ---\n\n";
+        outputFile << "constexpr int mpi_shm_ranks = " << numRanks << ";\n";
+        // Lookahead keeps up to 'lookahead' messages in flight on top of the regular one
+        outputFile << "constexpr size_t mpi_shm_slots = " << lookahead + 16 << ";\n\n";
+
+        outputFile << "struct mpi_shm_control_t {\n";
+        outputFile << "    std::atomic<uint32_t> ready;  // Set by rank 0 once the segment is sized\n";
+        outputFile << "    std::atomic<uint32_t> barrier_count;\n";
+        outputFile << "    std::atomic<uint32_t> barrier_generation;\n";
+        outputFile << "};\n\n";
+        outputFile << "struct mpi_shm_ring_t {\n";
+        outputFile << "    alignas(64) std::atomic<uint64_t> head;  // Messages published by the sender\n";
+        outputFile << "    alignas(64) std::atomic<uint64_t> tail;  // Messages consumed by the receiver\n";
+        outputFile << "};\n";
+        outputFile << "static_assert(std::atomic<uint64_t>::is_always_lock_free,\n";
+        outputFile << "              \"shared-memory rings need lock-free 64-bit atomics\");\n\n";
+        outputFile << "// A slot is the message length followed by the message, 8-byte aligned\n";
+        outputFile << "constexpr size_t mpi_shm_slot_bytes(size_t payload) {\n";
+        outputFile << "    return (sizeof(uint32_t) + payload + 7) & ~size_t(7);\n";
+        outputFile << "}\n";
+        outputFile << "constexpr size_t mpi_shm_ring_bytes(size_t payload) {\n";
+        outputFile << "    return (sizeof(mpi_shm_ring_t) + mpi_shm_slots * mpi_shm_slot_bytes(payload) + 63) & ~size_t(63);\n";
+        outputFile << "}\n\n";
+
+        // Rings are laid out back to back after the control block
+        outputFile << "// Payload size and segment offset of each ring\n";
+        std::string previous = "((sizeof(mpi_shm_control_t) + 63) & ~size_t(63))";
+        for (const auto& [suffix, payload] : rings) {
+            outputFile << "constexpr size_t mpi_shm_payload_" << suffix << " = " << payload << ";\n";
+            outputFile << "constexpr size_t mpi_shm_ring_" << suffix << " = " << previous << ";\n";
+            previous = "mpi_shm_ring_" + suffix + " + mpi_shm_ring_bytes(mpi_shm_payload_" + suffix + ")";
+        }
+        outputFile << "constexpr size_t mpi_shm_segment_bytes = " << previous << ";\n\n";
+
+        outputFile << "static unsigned char* mpi_shm_base = nullptr;\n\n";
+        outputFile << "static mpi_shm_control_t* mpi_shm_control() {\n";
+        outputFile << "    return reinterpret_cast<mpi_shm_control_t*>(mpi_shm_base);\n";
+        outputFile << "}\n\n";
+
+        outputFile << "static void mpi_shm_push(size_t ring, size_t payload, const void* data, uint32_t bytes) {\n";
+        outputFile << "    mpi_shm_ring_t* r = reinterpret_cast<mpi_shm_ring_t*>(mpi_shm_base + ring);\n";
+        outputFile << "    const uint64_t head = r->head.load(std::memory_order_relaxed);\n";
+        outputFile << "    while (head - r->tail.load(std::memory_order_acquire) == mpi_shm_slots) std::this_thread::yield();\n";
+        outputFile << "    unsigned char* slot = mpi_shm_base + ring + sizeof(mpi_shm_ring_t)\n";
+        outputFile << "                          + (head % mpi_shm_slots) * mpi_shm_slot_bytes(payload);\n";
+        outputFile << "    std::memcpy(slot, &bytes, sizeof(bytes));\n";
+        outputFile << "    std::memcpy(slot + sizeof(bytes), data, bytes);\n";
+        outputFile << "    r->head.store(head + 1, std::memory_order_release);\n";
+        outputFile << "}\n\n";
+
+        outputFile << "static uint32_t mpi_shm_pop(size_t ring, size_t payload, void* data) {\n";
+        outputFile << "    mpi_shm_ring_t* r = reinterpret_cast<mpi_shm_ring_t*>(mpi_shm_base + ring);\n";
+        outputFile << "    const uint64_t tail = r->tail.load(std::memory_order_relaxed);\n";
+        outputFile << "    while (r->head.load(std::memory_order_acquire) == tail) std::this_thread::yield();\n";
+        outputFile << "    const unsigned char* slot = mpi_shm_base + ring + sizeof(mpi_shm_ring_t)\n";
+        outputFile << "                                + (tail % mpi_shm_slots) * mpi_shm_slot_bytes(payload);\n";
+        outputFile << "    uint32_t bytes;\n";
+        outputFile << "    std::memcpy(&bytes, slot, sizeof(bytes));\n";
+        outputFile << "    std::memcpy(data, slot + sizeof(bytes), bytes);\n";
+        outputFile << "    r->tail.store(tail + 1, std::memory_order_release);\n";
+        outputFile << "    return bytes;\n";
+        outputFile << "}\n";
+        outputFile << "#endif  // METRO_MPI_SHM\n\n";
+    }
+
+    /**
+     * Emits the process lifecycle: rank and size queries, initialization and the start-up
+     * barrier, for both the MPI and the shared-memory transport.
+     */
+    void generateLifecycle(std::ofstream& outputFile, bool nonblocking, bool broadcasts,
+                           bool prof) {
+        outputFile << "#ifdef METRO_MPI_SHM\n";
+        outputFile << "int getRank()\n";
+        outputFile << "{\n";
+        outputFile << "    const char* rank = std::getenv(\"METRO_MPI_RANK\");\n";
+        outputFile << "    return rank ? std::atoi(rank) : 0;\n";
+        outputFile << "}\n\n";
+
+        outputFile << "int getSize()\n";
+        outputFile << "{\n";
+        outputFile << "    const char* size = std::getenv(\"METRO_MPI_SIZE\");\n";
+        outputFile << "    return size ? std::atoi(size) : mpi_shm_ranks;\n";
+        outputFile << "}\n\n";
+
+        outputFile << "static const char* mpi_shm_name() {\n";
+        outputFile << "    const char* name = std::getenv(\"METRO_MPI_SHM_NAME\");\n";
+        outputFile << "    return name ? name : \"/metro_mpi\";\n";
+        outputFile << "}\n\n";
+
+        outputFile << "extern void mpi_initialize() {\n";
+        outputFile << "    const int rank = getRank();\n";
+        outputFile << "    if (getSize() != mpi_shm_ranks) {\n";
+        outputFile << "        std::cerr << \"METRO_MPI_SIZE must be \" << mpi_shm_ranks << std::endl;\n";
+        outputFile << "        std::exit(1);\n";
+        outputFile << "    }\n";
+        outputFile << "    int fd;\n";
+        outputFile << "    if (rank == 0) {\n";
+        outputFile << "        // A segment left by a crashed run must be removed by hand, or another\n";
+        outputFile << "        // METRO_MPI_SHM_NAME used, rather than silently shared\n";
+        outputFile << "        fd = shm_open(mpi_shm_name(), O_CREAT | O_EXCL | O_RDWR, 0600);\n";
+        outputFile << "        if (fd < 0 || ftruncate(fd, mpi_shm_segment_bytes) != 0) {\n";
+        outputFile << "            std::cerr << \"Cannot create shared memory \" << mpi_shm_name() << std::endl;\n";
+        outputFile << "            std::exit(1);\n";
+        outputFile << "        }\n";
+        outputFile << "    } else {\n";
+        outputFile << "        struct stat st{};\n";
+        outputFile << "        while ((fd = shm_open(mpi_shm_name(), O_RDWR, 0600)) < 0\n";
+        outputFile << "               || fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < mpi_shm_segment_bytes) {\n";
+        outputFile << "            if (fd >= 0) close(fd);\n";
+        outputFile << "            std::this_thread::sleep_for(std::chrono::milliseconds(1));\n";
+        outputFile << "        }\n";
+        outputFile << "    }\n";
+        outputFile << "    void* base = mmap(nullptr, mpi_shm_segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);\n";
+        outputFile << "    close(fd);\n";
+        outputFile << "    if (base == MAP_FAILED) {\n";
+        outputFile << "        std::cerr << \"Cannot map shared memory \" << mpi_shm_name() << std::endl;\n";
+        outputFile << "        std::exit(1);\n";
+        outputFile << "    }\n";
+        outputFile << "    mpi_shm_base = static_cast<unsigned char*>(base);\n";
+        outputFile << "    // The segment starts zeroed, which is the initial state of every ring and flag\n";
+        outputFile << "    if (rank == 0) {\n";
+        outputFile << "        mpi_shm_control()->ready.store(1, std::memory_order_release);\n";
+        outputFile << "    } else {\n";
+        outputFile << "        while (!mpi_shm_control()->ready.load(std::memory_order_acquire)) std::this_thread::yield();\n";
+        outputFile << "    }\n";
+        if (prof) outputFile << "    mpi_prof_start();\n";
+        outputFile << "}\n\n";
+
+        outputFile << "extern void mpi_finalize() {\n";
+        if (prof) outputFile << "    metro_mpi_prof_report();\n";
+        outputFile << "    cout << \"Ending Communication from Rank \" << getRank() << endl;\n";
+        outputFile << "    munmap(mpi_shm_base, mpi_shm_segment_bytes);\n";
+        outputFile << "    mpi_shm_base = nullptr;\n";
+        outputFile << "    if (getRank() == 0) shm_unlink(mpi_shm_name());\n";
+        outputFile << "}\n\n";
+
+        outputFile << "extern void mpi_barrier() {\n";
+        outputFile << "    mpi_shm_control_t* control = mpi_shm_control();\n";
+        outputFile << "    const uint32_t generation = control->barrier_generation.load(std::memory_order_acquire);\n";
+        outputFile << "    if (control->barrier_count.fetch_add(1, std::memory_order_acq_rel) + 1 == mpi_shm_ranks) {\n";
+        outputFile << "        control->barrier_count.store(0, std::memory_order_relaxed);\n";
+        outputFile << "        control->barrier_generation.fetch_add(1, std::memory_order_release);\n";
+        outputFile << "    } else {\n";
+        outputFile << "        while (control->barrier_generation.load(std::memory_order_acquire) == generation) {\n";
+        outputFile << "            std::this_thread::yield();\n";
+        outputFile << "        }\n";
+        outputFile << "    }\n";
+        outputFile << "}\n\n";
+
+        outputFile << "#else\n";
+
+        outputFile << "int getRank()\n";
+        outputFile << "{\n";
+        outputFile << "    int rank;\n";
+        outputFile << "    MPI_Comm_rank(MPI_COMM_WORLD, &rank);\n";
+        outputFile << "    return rank;\n";
+        outputFile << "}\n\n";
+
+        outputFile << "int getSize()\n";
+        outputFile << "{\n";
+        outputFile << "    int size;\n";
+        outputFile << "    MPI_Comm_size(MPI_COMM_WORLD, &size);\n";
+        outputFile << "    return size;\n";
+        outputFile << "}\n\n";
+
+        outputFile << "extern void mpi_initialize() {\n";
+        outputFile << "    MPI_Init(NULL, NULL);\n";
+        outputFile << "    initialize_mpi_types();\n";
+        if (nonblocking) outputFile << "    initialize_mpi_requests();\n";
+        if (broadcasts) outputFile << "    initialize_mpi_broadcasts();\n";
+        if (prof) outputFile << "    mpi_prof_start();\n";
+        outputFile << "}\n\n";
+
+        outputFile << "extern void mpi_finalize() {\n";
+        if (prof) outputFile << "    metro_mpi_prof_report();\n";
+        outputFile << "    cout << \"Ending Communication from Rank \" << getRank() << endl;\n";
+        if (nonblocking) outputFile << "    free_mpi_requests();\n";
+        if (broadcasts) outputFile << "    finalize_mpi_broadcasts();\n";
+        outputFile << "    MPI_Finalize();\n";
+        outputFile << "}\n\n";
+
+        outputFile << "extern void mpi_barrier() { MPI_Barrier(MPI_COMM_WORLD); }\n";
+        outputFile << "#endif  // METRO_MPI_SHM\n";
+    }
+
+    /**
+     * Emits the counters of --mmpi-prof: messages and bytes sent on every rank pair, the
+     * time receivers wait for them, and a bounded list of timeline events. Partition mains
+     * add their eval time per instance and per exchange; metro_mpi_prof_report() merges
+     * them at mpi_finalize().
+     */
+    void generateProfCounters(std::ofstream& outputFile,
+                              const std::map<std::pair<int, int>, int>& profLinks) {
+        outputFile << "// --- Eval and communication profile ---\n\n";
+        outputFile << "struct mpi_prof_link_t {\n";
+        outputFile << "    uint64_t messages = 0;\n";
+        outputFile << "    uint64_t bytes = 0;\n";
+        outputFile << "    uint64_t wait_ns = 0;  // Receiver blocked until the message was there\n";
+        outputFile << "};\n\n";
+        outputFile << "struct mpi_prof_event_t {\n";
+        outputFile << "    const char* name;\n";
+        outputFile << "    int track;  // 0: eval, 1: communication\n";
+        outputFile << "    uint64_t start_ns;\n";
+        outputFile << "    uint64_t end_ns;\n";
+        outputFile << "};\n\n";
+        outputFile << "static const char* const mpi_prof_link_names[" << std::max<size_t>(1, profLinks.size()) << "] = {";
+        for (const auto& [ranks, index] : profLinks) {
+            outputFile << (index ? ", " : "") << "\"" << ranks.first << "_to_" << ranks.second << "\"";
+        }
+        outputFile << "};\n";
+        outputFile << "static mpi_prof_link_t mpi_prof_links[" << std::max<size_t>(1, profLinks.size()) << "];\n";
+        outputFile << "static std::vector<mpi_prof_event_t> mpi_prof_events;\n";
+        outputFile << "static size_t mpi_prof_max_events = 100000;\n";
+        outputFile << "// Eval time of each model of a partition process, by hierarchical instance name\n";
+        outputFile << "static std::vector<std::pair<std::string, uint64_t>> mpi_prof_evals;\n";
+        outputFile << "static uint64_t mpi_prof_exchange_ns = 0;  // In the Metro-MPI exchange\n";
+        outputFile << "static uint64_t mpi_prof_iterations = 0;\n";
+        outputFile << "static std::chrono::steady_clock::time_point mpi_prof_origin = std::chrono::steady_clock::now();\n\n";
+
+        outputFile << "// Time since mpi_initialize(), which is where the timelines of all ranks line up\n";
+        outputFile << "static inline uint64_t mpi_prof_now() {\n";
+        outputFile << "    return std::chrono::duration_cast<std::chrono::nanoseconds>(\n";
+        outputFile << "               std::chrono::steady_clock::now() - mpi_prof_origin).count();\n";
+        outputFile << "}\n\n";
+        outputFile << "static void mpi_prof_start() {\n";
+        outputFile << "    if (const char* events = std::getenv(\"METRO_MPI_PROF_EVENTS\")) {\n";
+        outputFile << "        mpi_prof_max_events = std::strtoull(events, nullptr, 10);\n";
+        outputFile << "    }\n";
+        outputFile << "    mpi_prof_origin = std::chrono::steady_clock::now();\n";
+        outputFile << "}\n\n";
+        outputFile << "// Only the first METRO_MPI_PROF_EVENTS events of a rank go to the timeline\n";
+        outputFile << "static inline void mpi_prof_event(const char* name, int track, uint64_t start_ns, uint64_t end_ns) {\n";
+        outputFile << "    if (mpi_prof_events.size() < mpi_prof_max_events) {\n";
+        outputFile << "        mpi_prof_events.push_back({name, track, start_ns, end_ns});\n";
+        outputFile << "    }\n";
+        outputFile << "}\n\n";
+        outputFile << "void metro_mpi_prof_report();\n\n";
+    }
+
+    /**
+     * Emits metro_mpi_prof_report(), called by every rank from mpi_finalize(). Each rank
+     * writes its counters as text lines, which rank 0 gathers (MPI_Gatherv, or files next to
+     * the report under METRO_MPI_SHM) into <prefix>.txt, a per-rank summary with the eval
+     * imbalance, <prefix>.json, a Chrome trace / Perfetto timeline, and <prefix>.weights,
+     * the eval time per instance in the --mmpi-profile format. METRO_MPI_PROF sets the
+     * prefix (default metro_mpi_prof).
+     */
+    void generateProfReport(std::ofstream& outputFile, int numLinks) {
+        outputFile << "\nvoid metro_mpi_prof_report() {\n";
+        outputFile << "    const uint64_t wall = mpi_prof_now();\n";
+        outputFile << "    const char* prefixEnv = std::getenv(\"METRO_MPI_PROF\");\n";
+        outputFile << "    const std::string prefix = prefixEnv ? prefixEnv : \"metro_mpi_prof\";\n";
+        outputFile << "    std::ostringstream part;\n";
+        outputFile << "    part << \"R \" << wall << ' ' << mpi_prof_iterations << ' ' << mpi_prof_exchange_ns << '\\n';\n";
+        outputFile << "    for (const auto& eval : mpi_prof_evals) part << \"E \" << eval.first << ' ' << eval.second << '\\n';\n";
+        outputFile << "    for (int i = 0; i < " << numLinks << "; ++i) {\n";
+        outputFile << "        const mpi_prof_link_t& link = mpi_prof_links[i];\n";
+        outputFile << "        if (!link.messages && !link.wait_ns) continue;\n";
+        outputFile << "        part << \"L \" << mpi_prof_link_names[i] << ' ' << link.messages << ' ' << link.bytes << ' '\n";
+        outputFile << "             << link.wait_ns << '\\n';\n";
+        outputFile << "    }\n";
+        outputFile << "    for (const mpi_prof_event_t& event : mpi_prof_events) {\n";
+        outputFile << "        part << \"T \" << event.name << ' ' << event.track << ' ' << event.start_ns << ' '\n";
+        outputFile << "             << event.end_ns << '\\n';\n";
+        outputFile << "    }\n\n";
+
+        outputFile << "    std::vector<std::string> parts;\n";
+        outputFile << "#ifdef METRO_MPI_SHM\n";
+        outputFile << "    std::ofstream(prefix + \".\" + std::to_string(getRank()) + \".part\") << part.str();\n";
+        outputFile << "    mpi_barrier();\n";
+        outputFile << "    if (getRank() != 0) return;\n";
+        outputFile << "    for (int r = 0; r < getSize(); ++r) {\n";
+        outputFile << "        const std::string file = prefix + \".\" + std::to_string(r) + \".part\";\n";
+        outputFile << "        std::ifstream in(file);\n";
+        outputFile << "        parts.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());\n";
+        outputFile << "        std::remove(file.c_str());\n";
+        outputFile << "    }\n";
+        outputFile << "#else\n";
+        outputFile << "    const std::string text = part.str();\n";
+        outputFile << "    const int bytes = static_cast<int>(text.size());\n";
+        outputFile << "    std::vector<int> counts(getSize()), displs(getSize());\n";
+        outputFile << "    MPI_Gather(&bytes, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);\n";
+        outputFile << "    std::vector<char> all;\n";
+        outputFile << "    if (getRank() == 0) {\n";
+        outputFile << "        for (int r = 1; r < getSize(); ++r) displs[r] = displs[r - 1] + counts[r - 1];\n";
+        outputFile << "        all.resize(displs.back() + counts.back());\n";
+        outputFile << "    }\n";
+        outputFile << "    MPI_Gatherv(text.data(), bytes, MPI_CHAR, all.data(), counts.data(), displs.data(), MPI_CHAR, 0,\n";
+        outputFile << "                MPI_COMM_WORLD);\n";
+        outputFile << "    if (getRank() != 0) return;\n";
+        outputFile << "    for (int r = 0; r < getSize(); ++r) parts.emplace_back(all.data() + displs[r], counts[r]);\n";
+        outputFile << "#endif\n\n";
+
+        outputFile << "    std::ofstream summary(prefix + \".txt\");\n";
+        outputFile << "    std::ofstream trace(prefix + \".json\");\n";
+        outputFile << "    std::ofstream weights(prefix + \".weights\");\n";
+        outputFile << "    // Messages and bytes are counted by the sender, the wait by the receiver\n";
+        outputFile << "    std::map<std::string, mpi_prof_link_t> links;\n";
+        outputFile << "    summary << \"# Metro-MPI profile, times in ms\\n\";\n";
+        outputFile << "    summary << \"# rank       wall       eval   exchange      other  iterations\\n\";\n";
+        outputFile << "    weights << \"# Eval ns per instance, input for --mmpi-profile\\n\";\n";
+        outputFile << "    trace << \"{\\\"traceEvents\\\": [\\n\";\n";
+        outputFile << "    double maxEval = 0;\n";
+        outputFile << "    double sumEval = 0;\n";
+        outputFile << "    int maxEvalRank = 0;\n";
+        outputFile << "    for (int r = 0; r < static_cast<int>(parts.size()); ++r) {\n";
+        outputFile << "        trace << (r ? \",\\n\" : \"\") << \"{\\\"name\\\": \\\"process_name\\\", \\\"ph\\\": \\\"M\\\", \\\"pid\\\": \" << r\n";
+        outputFile << "              << \", \\\"args\\\": {\\\"name\\\": \\\"Rank \" << r << \"\\\"}}\";\n";
+        outputFile << "        std::istringstream in(parts[r]);\n";
+        outputFile << "        std::string line;\n";
+        outputFile << "        uint64_t rankWall = 0, iterations = 0, exchange = 0, eval = 0;\n";
+        outputFile << "        while (std::getline(in, line)) {\n";
+        outputFile << "            std::istringstream fields(line.substr(2));\n";
+        outputFile << "            std::string name;\n";
+        outputFile << "            if (line[0] == 'R') {\n";
+        outputFile << "                fields >> rankWall >> iterations >> exchange;\n";
+        outputFile << "            } else if (line[0] == 'E') {\n";
+        outputFile << "                uint64_t ns = 0;\n";
+        outputFile << "                fields >> name >> ns;\n";
+        outputFile << "                eval += ns;\n";
+        outputFile << "                weights << name << ' ' << ns << '\\n';\n";
+        outputFile << "            } else if (line[0] == 'L') {\n";
+        outputFile << "                mpi_prof_link_t counts;\n";
+        outputFile << "                fields >> name >> counts.messages >> counts.bytes >> counts.wait_ns;\n";
+        outputFile << "                mpi_prof_link_t& link = links[name];\n";
+        outputFile << "                link.messages += counts.messages;\n";
+        outputFile << "                link.bytes += counts.bytes;\n";
+        outputFile << "                link.wait_ns += counts.wait_ns;\n";
+        outputFile << "            } else if (line[0] == 'T') {\n";
+        outputFile << "                int track = 0;\n";
+        outputFile << "                uint64_t start = 0, end = 0;\n";
+        outputFile << "                fields >> name >> track >> start >> end;\n";
+        outputFile << "                trace << \",\\n{\\\"name\\\": \\\"\" << name << \"\\\", \\\"ph\\\": \\\"X\\\", \\\"pid\\\": \" << r\n";
+        outputFile << "                      << \", \\\"tid\\\": \" << track << \", \\\"ts\\\": \" << start / 1e3\n";
+        outputFile << "                      << \", \\\"dur\\\": \" << (end - start) / 1e3 << \"}\";\n";
+        outputFile << "            }\n";
+        outputFile << "        }\n";
+        outputFile << "        const double other = static_cast<double>(rankWall) - static_cast<double>(eval + exchange);\n";
+        outputFile << "        char row[128];\n";
+        outputFile << "        std::snprintf(row, sizeof(row), \"%6d %10.3f %10.3f %10.3f %10.3f %11llu\\n\", r, rankWall / 1e6,\n";
+        outputFile << "                      eval / 1e6, exchange / 1e6, other / 1e6, static_cast<unsigned long long>(iterations));\n";
+        outputFile << "        summary << row;\n";
+        outputFile << "        if (r == 0) continue;  // Rank 0's own model is not measured\n";
+        outputFile << "        sumEval += eval;\n";
+        outputFile << "        if (eval > maxEval) {\n";
+        outputFile << "            maxEval = eval;\n";
+        outputFile << "            maxEvalRank = r;\n";
+        outputFile << "        }\n";
+        outputFile << "    }\n";
+        outputFile << "    trace << \"\\n]}\\n\";\n";
+        outputFile << "    for (const auto& [name, link] : links) {\n";
+        outputFile << "        summary << \"# link \" << name << \": \" << link.messages << \" messages, \" << link.bytes\n";
+        outputFile << "                << \" bytes, \" << link.wait_ns / 1e6 << \" ms waited by the receiver\\n\";\n";
+        outputFile << "    }\n";
+        outputFile << "    if (parts.size() > 1 && sumEval > 0) {\n";
+        outputFile << "        // 1.0 is a perfect balance; the slowest rank sets the pace of all others\n";
+        outputFile << "        summary << \"# eval imbalance (max / mean over partition ranks): \"\n";
+        outputFile << "                << maxEval / (sumEval / (parts.size() - 1)) << \", slowest rank \" << maxEvalRank << '\\n';\n";
+        outputFile << "    }\n";
+        outputFile << "    std::cout << \"[Rank 0] Wrote profile \" << prefix << \".txt, .json and .weights\" << std::endl;\n";
+        outputFile << "}\n";
+    }
+
+    /**
+     * Emits the file side of --mmpi-checkpoint. Each process serializes its models into
+     * memory; under MPI the states then go into one file with collective MPI-IO, behind a
+     * header holding the process count and the size of every state, while under
+     * METRO_MPI_SHM every process writes its own <file>.<rank>. METRO_MPI_CHECKPOINT names
+     * the file written (default metro_mpi.ckpt), METRO_MPI_RESTORE the one read at start-up.
+     */
+    void generateCheckpointIo(std::ofstream& outputFile) {
+        outputFile << "\n// --- Coordinated checkpoints ---\n\n";
+        outputFile << "// VerilatedSerialize into memory, so a process writes its state in one go\n";
+        outputFile << "class MetroMpiSaveBuffer final : public VerilatedSerialize {\n";
+        outputFile << "    std::vector<uint8_t> m_data;\n";
+        outputFile << "public:\n";
+        outputFile << "    MetroMpiSaveBuffer() {\n";
+        outputFile << "        m_isOpen = true;\n";
+        outputFile << "        header();\n";
+        outputFile << "    }\n";
+        outputFile << "    void flush() override {\n";
+        outputFile << "        m_data.insert(m_data.end(), m_bufp, m_cp);\n";
+        outputFile << "        m_cp = m_bufp;\n";
+        outputFile << "    }\n";
+        outputFile << "    const std::vector<uint8_t>& finish() {\n";
+        outputFile << "        trailer();\n";
+        outputFile << "        flush();\n";
+        outputFile << "        m_isOpen = false;\n";
+        outputFile << "        return m_data;\n";
+        outputFile << "    }\n";
+        outputFile << "};\n\n";
+
+        outputFile << "// VerilatedDeserialize from the state one process read back\n";
+        outputFile << "class MetroMpiRestoreBuffer final : public VerilatedDeserialize {\n";
+        outputFile << "    std::vector<uint8_t> m_data;\n";
+        outputFile << "    size_t m_pos = 0;\n";
+        outputFile << "public:\n";
+        outputFile << "    explicit MetroMpiRestoreBuffer(std::vector<uint8_t> data)\n";
+        outputFile << "        : m_data{std::move(data)} {\n";
+        outputFile << "        m_isOpen = true;\n";
+        outputFile << "        m_endp = m_bufp;\n";
+        outputFile << "        header();\n";
+        outputFile << "    }\n";
+        outputFile << "    void fill() override {\n";
+        outputFile << "        uint8_t* rp = m_bufp;\n";
+        outputFile << "        for (uint8_t* sp = m_cp; sp < m_endp; *rp++ = *sp++) {}  // Overlaps\n";
+        outputFile << "        m_endp = m_bufp + (m_endp - m_cp);\n";
+        outputFile << "        m_cp = m_bufp;\n";
+        outputFile << "        const size_t room = bufferSize() - (m_endp - m_bufp);\n";
+        outputFile << "        const size_t bytes = std::min(room, m_data.size() - m_pos);\n";
+        outputFile << "        std::memcpy(m_endp, m_data.data() + m_pos, bytes);\n";
+        outputFile << "        m_pos += bytes;\n";
+        outputFile << "        m_endp += bytes;\n";
+        outputFile << "    }\n";
+        outputFile << "    void finish() {\n";
+        outputFile << "        trailer();\n";
+        outputFile << "        m_isOpen = false;\n";
+        outputFile << "    }\n";
+        outputFile << "};\n\n";
+
+        outputFile << "static const char* metro_mpi_checkpoint_path() {\n";
+        outputFile << "    const char* path = std::getenv(\"METRO_MPI_CHECKPOINT\");\n";
+        outputFile << "    return path ? path : \"metro_mpi.ckpt\";\n";
+        outputFile << "}\n\n";
+        outputFile << "// Set for every process when the job starts from a checkpoint\n";
+        outputFile << "static const char* metro_mpi_restore_path() { return std::getenv(\"METRO_MPI_RESTORE\"); }\n\n";
+
+        outputFile << "// Writes this process' state into the checkpoint; every process calls it\n";
+        outputFile << "void metro_mpi_write_checkpoint(const std::vector<uint8_t>& state) {\n";
+        outputFile << "    const char* path = metro_mpi_checkpoint_path();\n";
+        outputFile << "#ifdef METRO_MPI_SHM\n";
+        outputFile << "    const std::string file = std::string{path} + \".\" + std::to_string(getRank());\n";
+        outputFile << "    std::ofstream out(file, std::ios::binary | std::ios::trunc);\n";
+        outputFile << "    out.write(reinterpret_cast<const char*>(state.data()), state.size());\n";
+        outputFile << "    if (!out) {\n";
+        outputFile << "        std::cerr << \"Cannot write checkpoint \" << file << std::endl;\n";
+        outputFile << "        std::exit(1);\n";
+        outputFile << "    }\n";
+        outputFile << "#else\n";
+        outputFile << "    std::vector<uint64_t> header(getSize() + 1);\n";
+        outputFile << "    header[0] = getSize();\n";
+        outputFile << "    const uint64_t bytes = state.size();\n";
+        outputFile << "    MPI_Allgather(&bytes, 1, MPI_UINT64_T, header.data() + 1, 1, MPI_UINT64_T, MPI_COMM_WORLD);\n";
+        outputFile << "    MPI_Offset offset = sizeof(uint64_t) * header.size();\n";
+        outputFile << "    for (int r = 0; r < getRank(); ++r) offset += header[r + 1];\n";
+        outputFile << "    MPI_File file;\n";
+        outputFile << "    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file)\n";
+        outputFile << "        != MPI_SUCCESS) {\n";
+        outputFile << "        std::cerr << \"Cannot write checkpoint \" << path << std::endl;\n";
+        outputFile << "        MPI_Abort(MPI_COMM_WORLD, 1);\n";
+        outputFile << "    }\n";
+        outputFile << "    MPI_File_set_size(file, 0);\n";
+        outputFile << "    if (getRank() == 0) {\n";
+        outputFile << "        MPI_File_write_at(file, 0, header.data(), header.size(), MPI_UINT64_T, MPI_STATUS_IGNORE);\n";
+        outputFile << "    }\n";
+        outputFile << "    MPI_File_write_at_all(file, offset, state.data(), static_cast<int>(state.size()), MPI_BYTE,\n";
+        outputFile << "                          MPI_STATUS_IGNORE);\n";
+        outputFile << "    MPI_File_close(&file);\n";
+        outputFile << "#endif\n";
+        outputFile << "    mpi_barrier();  // Complete once every process has written\n";
+        outputFile << "}\n\n";
+
+        outputFile << "// Reads this process' state back from the METRO_MPI_RESTORE checkpoint\n";
+        outputFile << "std::vector<uint8_t> metro_mpi_read_checkpoint() {\n";
+        outputFile << "    const char* path = metro_mpi_restore_path();\n";
+        outputFile << "#ifdef METRO_MPI_SHM\n";
+        outputFile << "    const std::string file = std::string{path} + \".\" + std::to_string(getRank());\n";
+        outputFile << "    std::ifstream in(file, std::ios::binary);\n";
+        outputFile << "    if (!in) {\n";
+        outputFile << "        std::cerr << \"Cannot read checkpoint \" << file << std::endl;\n";
+        outputFile << "        std::exit(1);\n";
+        outputFile << "    }\n";
+        outputFile << "    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), {});\n";
+        outputFile << "#else\n";
+        outputFile << "    MPI_File file;\n";
+        outputFile << "    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS) {\n";
+        outputFile << "        std::cerr << \"Cannot read checkpoint \" << path << std::endl;\n";
+        outputFile << "        MPI_Abort(MPI_COMM_WORLD, 1);\n";
+        outputFile << "    }\n";
+        outputFile << "    // The states are only valid on the rank layout that wrote them\n";
+        outputFile << "    std::vector<uint64_t> header(getSize() + 1);\n";
+        outputFile << "    MPI_File_read_at_all(file, 0, header.data(), header.size(), MPI_UINT64_T, MPI_STATUS_IGNORE);\n";
+        outputFile << "    if (header[0] != static_cast<uint64_t>(getSize())) {\n";
+        outputFile << "        std::cerr << \"Checkpoint \" << path << \" was written by \" << header[0]\n";
+        outputFile << "                  << \" ranks, this job has \" << getSize() << std::endl;\n";
+        outputFile << "        MPI_Abort(MPI_COMM_WORLD, 1);\n";
+        outputFile << "    }\n";
+        outputFile << "    MPI_Offset offset = sizeof(uint64_t) * header.size();\n";
+        outputFile << "    for (int r = 0; r < getRank(); ++r) offset += header[r + 1];\n";
+        outputFile << "    std::vector<uint8_t> state(header[getRank() + 1]);\n";
+        outputFile << "    MPI_File_read_at_all(file, offset, state.data(), static_cast<int>(state.size()), MPI_BYTE,\n";
+        outputFile << "                         MPI_STATUS_IGNORE);\n";
+        outputFile << "    MPI_File_close(&file);\n";
+        outputFile << "    return state;\n";
+        outputFile << "#endif\n";
+        outputFile << "}\n";
+    }
+
+    /**
+     * Emits one MPI_Ibcast per rank 0 fan-out group (ports with a "bcast_group" in the
+     * report), on a sub-communicator holding rank 0 and the group's partitions. Rank 0
+     * leaves its broadcast in flight and completes it only before the next one: members
+     * join the collective after receiving their own messages from rank 0, which rank 0 may
+     * not have sent yet. Under METRO_MPI_SHM the value is pushed into one ring per member.
+     */
+    void generateBroadcasts(std::ofstream& outputFile,
+                            const std::map<int, BroadcastGroup>& broadcastGroups) {
+        outputFile << "// --- Rank 0 fan-out broadcasts ---\n\n";
+        outputFile << "#ifndef METRO_MPI_SHM\n";
+        for (const auto& [group, bcast] : broadcastGroups) {
+            const std::string name = "mpi_bcast_" + std::to_string(group);
+            outputFile << "MPI_Comm " << name << "_comm = MPI_COMM_NULL;\n";
+            outputFile << "MPI_Datatype " << name << "_type;\n";
+            outputFile << "static MPI_Request " << name << "_request = MPI_REQUEST_NULL;\n";
+            outputFile << "static " << name << "_t " << name << "_buffer;\n";
+        }
+        outputFile << "\n";
+        outputFile << "void initialize_mpi_broadcasts() {\n";
+        outputFile << "    int rank;\n";
+        outputFile << "    MPI_Comm_rank(MPI_COMM_WORLD, &rank);\n";
+        for (const auto& [group, bcast] : broadcastGroups) {
+            const std::string name = "mpi_bcast_" + std::to_string(group);
+            outputFile << "    // " << bcast.wire << ": ranks 0";
+            std::string inGroup = "rank == 0";
+            for (const auto& member : bcast.members) {
+                outputFile << ", " << member.first;
+                inGroup += " || rank == " + std::to_string(member.first);
+            }
+            outputFile << "\n";
+            // Every rank takes part in the split; rank 0 has key 0 and so is the root
+            outputFile << "    MPI_Comm_split(MPI_COMM_WORLD, (" << inGroup
+                       << ") ? 0 : MPI_UNDEFINED, rank, &" << name << "_comm);\n";
+            outputFile << "    MPI_Type_contiguous(" << getWordCount(bcast.width) << ", "
+                       << getMpiType(bcast.width) << ", &" << name << "_type);\n";
+            outputFile << "    MPI_Type_commit(&" << name << "_type);\n";
+        }
+        outputFile << "}\n\n";
+        outputFile << "void finalize_mpi_broadcasts() {\n";
+        for (const auto& [group, bcast] : broadcastGroups) {
+            const std::string name = "mpi_bcast_" + std::to_string(group);
+            outputFile << "    MPI_Wait(&" << name << "_request, MPI_STATUS_IGNORE);\n";
+            outputFile << "    if (" << name << "_comm != MPI_COMM_NULL) MPI_Comm_free(&" << name
+                       << "_comm);\n";
+        }
+        outputFile << "}\n";
+        outputFile << "#endif\n\n";
+
+        for (const auto& [group, bcast] : broadcastGroups) {
+            const std::string name = "mpi_bcast_" + std::to_string(group);
+            outputFile << "extern void " << name << "_send(const " << name << "_t& message) {\n";
+            outputFile << "#ifdef METRO_MPI_SHM\n";
+            for (const auto& member : bcast.members) {
+                const std::string ring = "bcast_" + std::to_string(group) + "_to_"
+                                         + std::to_string(member.first);
+                outputFile << "    mpi_shm_push(mpi_shm_ring_" << ring << ", mpi_shm_payload_" << ring
+                           << ", &message, sizeof(message));\n";
+            }
+            outputFile << "#else\n";
+            outputFile << "    MPI_Wait(&" << name << "_request, MPI_STATUS_IGNORE);\n";
+            outputFile << "    " << name << "_buffer = message;\n";
+            outputFile << "    MPI_Ibcast(&" << name << "_buffer, 1, " << name << "_type, 0, " << name
+                       << "_comm, &" << name << "_request);\n";
+            outputFile << "#endif\n";
+            outputFile << "}\n\n";
+
+            for (const auto& member : bcast.members) {
+                const std::string ring = "bcast_" + std::to_string(group) + "_to_"
+                                         + std::to_string(member.first);
+                outputFile << "extern " << name << "_t " << name << "_receive_to_" << member.first
+                           << "() {\n";
+                outputFile << "    " << name << "_t message;\n";
+                outputFile << "#ifdef METRO_MPI_SHM\n";
+                outputFile << "    mpi_shm_pop(mpi_shm_ring_" << ring << ", mpi_shm_payload_" << ring
+                           << ", &message);\n";
+                outputFile << "#else\n";
+                outputFile << "    MPI_Request request;\n";
+                outputFile << "    MPI_Ibcast(&message, 1, " << name << "_type, 0, " << name
+                           << "_comm, &request);\n";
+                outputFile << "    MPI_Wait(&request, MPI_STATUS_IGNORE);\n";
+                outputFile << "#endif\n";
+                outputFile << "    return message;\n";
+                outputFile << "}\n\n";
+            }
+        }
+    }
+
     void generateMpiVerificationFile(const std::string& jsonFilePath) {
 
         std::ifstream inputFile(jsonFilePath);
@@ -79,14 +1039,38 @@ public:
             std::cerr << "JSON parsing error [MPICodeGenerator]: " << e.what() << std::endl;
             return;
         }
+        generateFromReport(data);
+    }
+
+    // Same as generateMpiVerificationFile(), from the analysis held in memory
+    void generateFromReport(const json& data) {
+        const json config = data.value("config", json::object());
+        const int lookahead = config.value("lookahead", 0);
+        const bool nonblocking = config.value("nonblocking", false);
+        const bool pack = config.value("pack", false);
+        const bool delta = config.value("delta", false);
+        const bool checkpoint = config.value("checkpoint", false);
+        const bool prof = config.value("prof", false);
+        const bool clocked = !config.value("boundary_clock", "").empty();
+        m_instancesPerRank = std::max(1, config.value("instances_per_rank", 1));
 
         // --- Data Structure to store all P2P links ---
         std::map<std::pair<int, int>, std::vector<P2P_Link>> communication_graph;
         std::set<std::tuple<int, int, std::string, std::string>> processed_physical_links;
+        std::map<int, BroadcastGroup> broadcastGroups;
 
         // --- PHASE 1: Populate the data structure from the JSON file ---
         for (auto const& [partitionName, ports] : data["partitions"].items()) {
             for (const auto& port : ports) {
+                // Rank 0 fan-out is carried by a broadcast, not by the rank pair message
+                const int bcastGroup = port.value("bcast_group", -1);
+                if (bcastGroup >= 0) {
+                    BroadcastGroup& bcast = broadcastGroups[bcastGroup];
+                    bcast.wire = port["connecting_wire"];
+                    bcast.width = port["width"];
+                    bcast.members.emplace_back(port["mpi_rank"], port["port_name"]);
+                    continue;
+                }
                 if (port["active"] == "Yes"
                     && (port["Comm"] == "P2P" || port["Comm"] == "broadcast")) {
                     for (const auto& commPartner : port["with_whom_is_it_communicating"]) {
@@ -140,16 +1124,61 @@ public:
             }
         }
 
+#ifndef EXCLUDE_RANK_ZERO
+        addControlLinks(data, communication_graph);
+#endif
+
         // --- PHASE 2: Generate the C++ MPI code file ---
         std::ofstream outputFile("metro_mpi/metro_mpi.cpp");
         outputFile << "// Generated by Metro-MPI Tool\n\n";
+        outputFile << "#ifdef METRO_MPI_SHM\n";
+        outputFile << "#include <atomic>\n";
+        outputFile << "#include <chrono>\n";
+        outputFile << "#include <cstdlib>\n";
+        outputFile << "#include <thread>\n";
+        outputFile << "#include <fcntl.h>\n";
+        outputFile << "#include <sys/mman.h>\n";
+        outputFile << "#include <sys/stat.h>\n";
+        outputFile << "#include <unistd.h>\n";
+        outputFile << "#else\n";
         outputFile << "#include <mpi.h>\n";
+        outputFile << "#endif\n";
         outputFile << "#include <cstdint>\n";
         outputFile << "#include <cstddef>\n";
+        outputFile << "#include <cstring>\n";
+        if (m_instancesPerRank > 1) outputFile << "#include <deque>\n";
+        if (prof) {
+            outputFile << "#include <chrono>\n";
+            outputFile << "#include <cstdio>\n";
+            outputFile << "#include <cstdlib>\n";
+            outputFile << "#include <fstream>\n";
+            outputFile << "#include <iterator>\n";
+            outputFile << "#include <map>\n";
+            outputFile << "#include <sstream>\n";
+            outputFile << "#include <string>\n";
+            outputFile << "#include <vector>\n";
+        }
+        if (checkpoint) {
+            outputFile << "#include <algorithm>\n";
+            outputFile << "#include <cstdlib>\n";
+            outputFile << "#include <fstream>\n";
+            outputFile << "#include <iterator>\n";
+            outputFile << "#include <string>\n";
+            outputFile << "#include <vector>\n";
+            outputFile << "#include \"verilated_save.h\"\n";
+        }
         // *** FIX: Add iostream and using declarations for cout/endl ***
         outputFile << "#include <iostream>\n\n";
         outputFile << "using std::cout;\n";
         outputFile << "using std::endl;\n\n";
+        // Every rank pair with rank 0 carries this field; see addControlLinks()
+        outputFile << "// Values of the metro_mpi_ctrl field of the messages to and from rank 0\n";
+        outputFile << "constexpr uint8_t METRO_MPI_CTRL_RUN = 0;\n";
+        outputFile << "constexpr uint8_t METRO_MPI_CTRL_STOP = 1;  // Last exchange of the run\n";
+        if (checkpoint) {
+            outputFile << "constexpr uint8_t METRO_MPI_CTRL_SAVE = 2;  // Checkpoint, then the exchange follows\n";
+        }
+        outputFile << "\n";
 
         // Generate structs and MPI Datatype variables
         for (const auto& [ranks, links] : communication_graph) {
@@ -159,16 +1188,79 @@ public:
             outputFile << "struct mpi_rank_" << ranks.first << "_to_" << ranks.second << "_t {\n";
             for (const auto& link : links) {
                 outputFile << "    " << getCppType(link.receiver_port_width) << " "
-                           << link.sender_port_name << "; // -> maps to receiver port "
-                           << link.receiver_port_name << "\n";
+                           << link.sender_port_name;
+                if (link.receiver_port_width > 64) {
+                    outputFile << "[" << getWordCount(link.receiver_port_width) << "]";
+                }
+                outputFile << "; // -> maps to receiver port " << link.receiver_port_name << "\n";
             }
             outputFile << "};\n\n";
+            outputFile << "#ifndef METRO_MPI_SHM\n";
             outputFile << "MPI_Datatype mpi_type_rank_" << ranks.first << "_to_" << ranks.second
-                       << ";\n\n";
+                       << ";\n";
+            outputFile << "#endif\n\n";
+        }
+
+        outputFile << "// Partition ids are packed " << m_instancesPerRank
+                   << " to an MPI rank (--mmpi-instances-per-rank)\n";
+        outputFile << "constexpr int mpi_instances_per_rank = " << m_instancesPerRank << ";\n";
+        outputFile << "inline int mpi_physical_rank(int partition_id) {\n";
+        outputFile << "    return partition_id == 0 ? 0 : 1 + (partition_id - 1) / mpi_instances_per_rank;\n";
+        outputFile << "}\n\n";
+
+        // When ranks are shared, several rank pairs map onto one pair of MPI processes and
+        // need their own tag to be told apart
+        std::map<std::pair<int, int>, int> pairTags;
+        for (const auto& [ranks, links] : communication_graph) {
+            pairTags[ranks] = m_instancesPerRank > 1 ? 1000 + static_cast<int>(pairTags.size()) : 0;
         }
 
+        // Profile slot of each rank pair
+        std::map<std::pair<int, int>, int> profLinks;
+        for (const auto& [ranks, links] : communication_graph) {
+            if (!links.empty()) profLinks.emplace(ranks, static_cast<int>(profLinks.size()));
+        }
+        if (prof) generateProfCounters(outputFile, profLinks);
+
+        for (const auto& [group, bcast] : broadcastGroups) {
+            outputFile << "// Broadcast of " << bcast.wire << " from rank 0\n";
+            outputFile << "struct mpi_bcast_" << group << "_t {\n";
+            outputFile << "    " << getCppType(bcast.width) << " value[" << getWordCount(bcast.width)
+                       << "];\n";
+            outputFile << "};\n\n";
+        }
+
+        if (pack) generatePackingKernels(outputFile, communication_graph);
+        if (delta) generateDeltaKernels(outputFile, communication_graph);
+
+        // Shared-memory rings with the largest wire image each must hold
+        std::vector<std::pair<std::string, std::string>> shmRings;
+        for (const auto& [ranks, links] : communication_graph) {
+            if (links.empty() || isColocated(ranks)) continue;
+            std::string suffix = std::to_string(ranks.first) + "_to_" + std::to_string(ranks.second);
+            shmRings.emplace_back("rank_" + suffix,
+                                  delta  ? "mpi_delta_max_bytes_rank_" + suffix
+                                  : pack ? "sizeof(uint32_t) * mpi_words_rank_" + suffix
+                                         : "sizeof(mpi_rank_" + suffix + "_t)");
+        }
+        for (const auto& [group, bcast] : broadcastGroups) {
+            for (const auto& member : bcast.members) {
+                shmRings.emplace_back("bcast_" + std::to_string(group) + "_to_"
+                                          + std::to_string(member.first),
+                                      "sizeof(mpi_bcast_" + std::to_string(group) + "_t)");
+            }
+        }
+        int numRanks = 1;
+        for (auto const& [partitionName, ports] : data["partitions"].items()) {
+            for (const auto& port : ports) {
+                numRanks = std::max(numRanks, physicalRank(port["mpi_rank"].get<int>()) + 1);
+            }
+        }
+        generateShmTransport(outputFile, shmRings, numRanks, lookahead);
+
         // Generate the initialize_mpi_types function
-        outputFile << "\nvoid initialize_mpi_types() {\n";
+        outputFile << "\n#ifndef METRO_MPI_SHM\n";
+        outputFile << "void initialize_mpi_types() {\n";
         for (const auto& [ranks, links] : communication_graph) {
             if (links.empty()) continue;
             std::string structName = "mpi_rank_" + std::to_string(ranks.first) + "_to_"
@@ -176,11 +1268,20 @@ public:
             std::string mpiTypeName = "mpi_type_rank_" + std::to_string(ranks.first) + "_to_"
                                       + std::to_string(ranks.second);
 
+            if (pack) {
+                // The packed wire buffer is a plain word array
+                outputFile << "    MPI_Type_contiguous(mpi_words_rank_" << ranks.first << "_to_"
+                           << ranks.second << ", MPI_UINT32_T, &" << mpiTypeName << ");\n";
+                outputFile << "    MPI_Type_commit(&" << mpiTypeName << ");\n";
+                continue;
+            }
+
             outputFile << "    {\n";
             outputFile << "        const int nitems = " << links.size() << ";\n";
             outputFile << "        int blocklengths[" << links.size() << "] = {";
             for (size_t i = 0; i < links.size(); ++i)
-                outputFile << "1" << (i == links.size() - 1 ? "" : ", ");
+                outputFile << getWordCount(links[i].receiver_port_width)
+                           << (i == links.size() - 1 ? "" : ", ");
             outputFile << "};\n";
 
             outputFile << "        MPI_Datatype types[" << links.size() << "] = {";
@@ -200,7 +1301,8 @@ public:
             outputFile << "        MPI_Type_commit(&" << mpiTypeName << ");\n";
             outputFile << "    }\n";
         }
-        outputFile << "}\n\n";
+        outputFile << "}\n";
+        outputFile << "#endif\n\n";
 
         // Generate specific send/receive functions for each link
         for (const auto& [ranks, links] : communication_graph) {
@@ -210,46 +1312,210 @@ public:
             std::string mpiTypeName = "mpi_type_rank_" + std::to_string(ranks.first) + "_to_"
                                       + std::to_string(ranks.second);
 
+            std::string suffix = std::to_string(ranks.first) + "_to_" + std::to_string(ranks.second);
+            // With --mmpi-pack the struct is converted to and from the wire buffer here
+            std::string wordsName = "mpi_words_rank_" + suffix;
+            // Destination, source and tag of this pair on MPI_COMM_WORLD
+            const std::string dest = std::to_string(physicalRank(ranks.second));
+            const std::string source = std::to_string(physicalRank(ranks.first));
+            const std::string tag = std::to_string(pairTags[ranks]);
+            const bool colocated = isColocated(ranks);
+            const std::string queueName = "mpi_local_queue_rank_" + suffix;
+            // The shared-memory ring replacing the MPI message, see generateShmTransport()
+            const std::string ring = "mpi_shm_ring_rank_" + suffix + ", mpi_shm_payload_rank_" + suffix;
+            const auto emitTransport = [&](const std::string& shmCall, const std::string& mpiCall) {
+                outputFile << "#ifdef METRO_MPI_SHM\n";
+                outputFile << shmCall;
+                outputFile << "#else\n";
+                outputFile << mpiCall;
+                outputFile << "#endif\n";
+            };
+            if (colocated) {
+                outputFile << "// Ranks " << ranks.first << " and " << ranks.second
+                           << " share MPI rank " << dest << "\n";
+                outputFile << "static std::deque<" << structName << "> " << queueName << ";\n\n";
+            }
+            // Partitions keep their last lookahead + 1 messages, which a checkpoint taken
+            // while they are still in flight has to carry
+            const bool keepSent = checkpoint && lookahead > 0 && ranks.first != 0;
+            const std::string sentName = "mpi_sent_rank_" + suffix;
+            const std::string sentSlot = sentName + "[" + sentName + "_count++ % "
+                                         + std::to_string(lookahead + 1) + "]";
+            if (keepSent) {
+                outputFile << "static " << structName << " " << sentName << "[" << lookahead + 1 << "];\n";
+                outputFile << "static unsigned long " << sentName << "_count = 0;\n\n";
+            }
+
+            const std::string profLink = prof ? "mpi_prof_links[" + std::to_string(profLinks.at(ranks)) + "]" : "";
+
             outputFile << "extern void mpi_send_rank_" << ranks.first << "_to_" << ranks.second
                        << "(" << structName << " message) {\n";
-            outputFile << "    MPI_Send(&message, 1, " << mpiTypeName << ", " << ranks.second
-                       << ", 0, MPI_COMM_WORLD);\n";
+            if (keepSent) outputFile << "    " << sentSlot << " = message;\n";
+            if (colocated) {
+                outputFile << "    " << queueName << ".push_back(message);\n";
+            } else if (delta) {
+                outputFile << "    unsigned char wire[mpi_delta_max_bytes_rank_" << suffix << "];\n";
+                outputFile << "    const int bytes = mpi_delta_encode_rank_" << suffix << "(message, wire);\n";
+                emitTransport("    mpi_shm_push(" + ring + ", wire, bytes);\n",
+                              "    MPI_Send(wire, bytes, MPI_BYTE, " + dest + ", " + tag
+                                  + ", MPI_COMM_WORLD);\n");
+            } else if (pack) {
+                outputFile << "    uint32_t wire[" << wordsName << "];\n";
+                outputFile << "    mpi_pack_rank_" << suffix << "(message, wire);\n";
+                emitTransport("    mpi_shm_push(" + ring + ", wire, sizeof(wire));\n",
+                              "    MPI_Send(wire, 1, " + mpiTypeName + ", " + dest + ", " + tag
+                                  + ", MPI_COMM_WORLD);\n");
+            } else {
+                emitTransport("    mpi_shm_push(" + ring + ", &message, sizeof(message));\n",
+                              "    MPI_Send(&message, 1, " + mpiTypeName + ", " + dest + ", " + tag
+                                  + ", MPI_COMM_WORLD);\n");
+            }
+            if (prof) {
+                // Size on the wire, after packing or delta encoding
+                outputFile << "    ++" << profLink << ".messages;\n";
+                outputFile << "    " << profLink << ".bytes += "
+                           << (colocated ? "sizeof(message)"
+                               : delta   ? "bytes"
+                               : pack    ? "sizeof(wire)"
+                                         : "sizeof(message)")
+                           << ";\n";
+            }
             outputFile << "}\n\n";
 
             // *** FIX: Make receive function name unique by including the receiver's rank ***
             outputFile << "extern " << structName << " mpi_receive_from_rank_" << ranks.first
                        << "_to_" << ranks.second << "() {\n";
+            // Time until the message is there, which is what the receiver waits for
+            const bool profWait = prof && !colocated;
+            if (profWait) outputFile << "    const uint64_t prof_start = mpi_prof_now();\n";
             outputFile << "    " << structName << " message;\n";
-            outputFile << "    MPI_Recv(&message, 1, " << mpiTypeName << ", " << ranks.first
-                       << ", 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);\n";
+            if (colocated) {
+                outputFile << "    message = " << queueName << ".front();\n";
+                outputFile << "    " << queueName << ".pop_front();\n";
+                // Not encoded, so every message counts as a change
+                if (delta) outputFile << "    mpi_changed_rank_" << suffix << " = true;\n";
+            } else if (delta) {
+                outputFile << "    unsigned char wire[mpi_delta_max_bytes_rank_" << suffix << "];\n";
+                emitTransport("    mpi_shm_pop(" + ring + ", wire);\n",
+                              "    MPI_Recv(wire, sizeof(wire), MPI_BYTE, " + source + ", " + tag
+                                  + ", MPI_COMM_WORLD, MPI_STATUS_IGNORE);\n");
+                outputFile << "    mpi_delta_decode_rank_" << suffix << "(wire, message);\n";
+            } else if (pack) {
+                outputFile << "    uint32_t wire[" << wordsName << "];\n";
+                emitTransport("    mpi_shm_pop(" + ring + ", wire);\n",
+                              "    MPI_Recv(wire, 1, " + mpiTypeName + ", " + source + ", " + tag
+                                  + ", MPI_COMM_WORLD, MPI_STATUS_IGNORE);\n");
+                outputFile << "    mpi_unpack_rank_" << suffix << "(wire, message);\n";
+            } else {
+                emitTransport("    mpi_shm_pop(" + ring + ", &message);\n",
+                              "    MPI_Recv(&message, 1, " + mpiTypeName + ", " + source + ", " + tag
+                                  + ", MPI_COMM_WORLD, MPI_STATUS_IGNORE);\n");
+            }
+            if (profWait) {
+                outputFile << "    const uint64_t prof_end = mpi_prof_now();\n";
+                outputFile << "    " << profLink << ".wait_ns += prof_end - prof_start;\n";
+                outputFile << "    mpi_prof_event(\"recv_" << suffix << "\", 1, prof_start, prof_end);\n";
+            }
             outputFile << "    return message;\n";
             outputFile << "}\n\n";
-        }
 
-        // Add final MPI lifecycle functions
-        outputFile << "int getRank()\n";
-        outputFile << "{\n";
-        outputFile << "    int rank;\n";
-        outputFile << "    MPI_Comm_rank(MPI_COMM_WORLD, &rank);\n";
-        outputFile << "    return rank;\n";
-        outputFile << "}\n\n";
+            if (lookahead > 0) {
+                // Puts 'count' copies of the message in flight ahead of the regular exchange,
+                // so the receiver consumes values that are 'count' messages old. The sends
+                // are non-blocking so priming cannot deadlock against the receiver's own
+                // sends; MPI-3 allows them to share one buffer.
+                outputFile << "extern void mpi_prime_rank_" << ranks.first << "_to_" << ranks.second
+                           << "(const " << structName << "& message, int count) {\n";
+                if (keepSent) outputFile << "    for (int i = 0; i < count; ++i) " << sentSlot << " = message;\n";
+                if (colocated) {
+                    outputFile << "    " << queueName << ".insert(" << queueName << ".end(), count, message);\n";
+                } else {
+                    std::string sendArgs = "&buffer, 1, " + mpiTypeName;
+                    std::string shmArgs = "&buffer, sizeof(buffer)";
+                    if (delta) {
+                        // Every primed copy is a full message, encoded once
+                        outputFile << "    static unsigned char buffer[mpi_delta_max_bytes_rank_" << suffix << "];\n";
+                        outputFile << "    const int bytes = mpi_delta_encode_rank_" << suffix << "(message, buffer);\n";
+                        sendArgs = "buffer, bytes, MPI_BYTE";
+                        shmArgs = "buffer, bytes";
+                    } else if (pack) {
+                        outputFile << "    static uint32_t buffer[" << wordsName << "];\n";
+                        outputFile << "    mpi_pack_rank_" << suffix << "(message, buffer);\n";
+                        sendArgs = "buffer, 1, " + mpiTypeName;
+                        shmArgs = "buffer, sizeof(buffer)";
+                    } else {
+                        outputFile << "    static " << structName << " buffer;\n";
+                        outputFile << "    buffer = message;\n";
+                    }
+                    outputFile << "    for (int i = 0; i < count; ++i) {\n";
+                    emitTransport("        mpi_shm_push(" + ring + ", " + shmArgs + ");\n",
+                                  "        MPI_Request request;\n"
+                                  "        MPI_Isend(" + sendArgs + ", " + dest + ", " + tag
+                                      + ", MPI_COMM_WORLD, &request);\n"
+                                  "        MPI_Request_free(&request);\n");
+                    outputFile << "    }\n";
+                }
+                outputFile << "}\n\n";
+            }
 
-        outputFile << "int getSize()\n";
-        outputFile << "{\n";
-        outputFile << "    int size;\n";
-        outputFile << "    MPI_Comm_size(MPI_COMM_WORLD, &size);\n";
-        outputFile << "    return size;\n";
-        outputFile << "}\n\n";
+            if (keepSent) {
+                const std::string count = std::to_string(lookahead);
+                outputFile << "// Writes the messages the receiver had not consumed when the checkpoint was\n";
+                outputFile << "// taken, except the newest, which the restored sender sends again itself\n";
+                outputFile << "extern void mpi_save_in_flight_rank_" << suffix << "(VerilatedSerialize& os) {\n";
+                outputFile << "    for (unsigned long i = " << sentName << "_count - " << lookahead + 1 << "; i < "
+                           << sentName << "_count - 1; ++i) {\n";
+                outputFile << "        os.write(&" << sentName << "[i % " << lookahead + 1 << "], sizeof(" << structName << "));\n";
+                outputFile << "    }\n";
+                outputFile << "}\n\n";
 
-        outputFile << "extern void mpi_initialize() {\n";
-        outputFile << "    MPI_Init(NULL, NULL);\n";
-        outputFile << "    initialize_mpi_types();\n";
-        outputFile << "}\n\n";
+                // Unlike priming, every message differs, so each gets its own send buffer
+                outputFile << "// Puts the saved messages back in flight, without blocking like priming\n";
+                outputFile << "extern void mpi_restore_in_flight_rank_" << suffix << "(VerilatedDeserialize& os) {\n";
+                outputFile << "    static " << structName << " messages[" << count << "];\n";
+                outputFile << "    for (int i = 0; i < " << count << "; ++i) {\n";
+                outputFile << "        os.read(&messages[i], sizeof(messages[i]));\n";
+                outputFile << "        " << sentSlot << " = messages[i];\n";
+                outputFile << "    }\n";
+                if (colocated) {
+                    outputFile << "    " << queueName << ".insert(" << queueName << ".end(), messages, messages + "
+                               << count << ");\n";
+                } else {
+                    std::string sendArgs = "&messages[i], 1, " + mpiTypeName;
+                    std::string shmArgs = "&messages[i], sizeof(messages[i])";
+                    if (delta) {
+                        outputFile << "    static unsigned char buffer[" << count << "][mpi_delta_max_bytes_rank_" << suffix << "];\n";
+                        sendArgs = "buffer[i], bytes, MPI_BYTE";
+                        shmArgs = "buffer[i], bytes";
+                    } else if (pack) {
+                        outputFile << "    static uint32_t buffer[" << count << "][" << wordsName << "];\n";
+                        sendArgs = "buffer[i], 1, " + mpiTypeName;
+                        shmArgs = "buffer[i], sizeof(buffer[i])";
+                    }
+                    outputFile << "    for (int i = 0; i < " << count << "; ++i) {\n";
+                    if (delta) {
+                        outputFile << "        const int bytes = mpi_delta_encode_rank_" << suffix << "(messages[i], buffer[i]);\n";
+                    } else if (pack) {
+                        outputFile << "        mpi_pack_rank_" << suffix << "(messages[i], buffer[i]);\n";
+                    }
+                    emitTransport("        mpi_shm_push(" + ring + ", " + shmArgs + ");\n",
+                                  "        MPI_Request request;\n"
+                                  "        MPI_Isend(" + sendArgs + ", " + dest + ", " + tag
+                                      + ", MPI_COMM_WORLD, &request);\n"
+                                  "        MPI_Request_free(&request);\n");
+                    outputFile << "    }\n";
+                }
+                outputFile << "}\n\n";
+            }
+        }
 
-        outputFile << "extern void mpi_finalize() {\n";
-        outputFile << "    cout << \"Ending Communication from Rank \" << getRank() << endl;\n";
-        outputFile << "    MPI_Finalize();\n";
-        outputFile << "}\n";
+        if (!broadcastGroups.empty()) generateBroadcasts(outputFile, broadcastGroups);
+        if (nonblocking) generatePersistentRequests(outputFile, communication_graph, pack, clocked);
+
+        // Add final MPI lifecycle functions
+        generateLifecycle(outputFile, nonblocking, !broadcastGroups.empty(), prof);
+        if (checkpoint) generateCheckpointIo(outputFile);
+        if (prof) generateProfReport(outputFile, static_cast<int>(profLinks.size()));
 
         outputFile.close();
         std::cout << "\n[Metro-MPI] Successfully generated metro_mpi/metro_mpi.cpp" << std::endl;
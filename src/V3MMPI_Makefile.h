@@ -3,6 +3,8 @@
 #ifndef V3METRO_MPI_MK_H
 #define V3METRO_MPI_MK_H
 
+#include "V3Blake2b.h"
+
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -48,6 +50,34 @@ private:
         return args;
     }
 
+    // Content key of the Verilated partition model: everything the partition's
+    // verilator and make steps read, but not the generated main, which is compiled
+    // on top of the model for each design. verilatorVersion carries the build revision
+    // (config_rev.h), so models of different Verilator builds never share an entry.
+    std::string modelKey(const std::string& partitionModuleName,
+                         const std::vector<std::string>& partitionVerilogFiles,
+                         const std::vector<std::string>& dependFiles,
+                         const std::string& verilatorFlags, const std::string& verilatorVersion) {
+        std::stringstream keyInput;
+        keyInput << "metro-mpi-model-2\n" << verilatorVersion << "\n" << partitionModuleName << "\n"
+                 << verilatorFlags << "\n";
+        std::set<std::string> files(partitionVerilogFiles.begin(), partitionVerilogFiles.end());
+        files.insert(dependFiles.begin(), dependFiles.end());
+        for (const auto& file : files) {
+            std::ifstream in(file, std::ios::binary);
+            if (!in.is_open()) {
+                // Still a valid key, only never shared with another path
+                keyInput << "unreadable " << file << "\n";
+                continue;
+            }
+            std::stringstream contents;
+            contents << in.rdbuf();
+            // Sources are keyed by content alone, so copies of a tile in other designs hit
+            keyInput << contents.str().size() << "\n" << contents.str();
+        }
+        return blake2b_128_hex(keyInput.str());
+    }
+
 
 public:
     /**
@@ -55,10 +85,15 @@ public:
      * @param originalCommand The original command line for the full design as a single string.
      * @param partitionModuleName The name of the top module for the partition.
      * @param partitionVerilogFiles A vector of strings with the full paths to the Verilog files for the partition.
+     * @param dependFiles Other files the partition's verilate step may read, e.g. includes;
+     * only part of the model cache key.
+     * @param verilatorVersion Version of the Verilator building the partition, part of the model cache key.
      */
     void generate(const std::string& originalCommand,
                   const std::string& partitionModuleName,
-                  const std::vector<std::string>& partitionVerilogFiles) {
+                  const std::vector<std::string>& partitionVerilogFiles,
+                  const std::vector<std::string>& dependFiles,
+                  const std::string& verilatorVersion) {
 
         std::vector<std::string> originalArgs = parseCommandString(originalCommand);
 
@@ -75,7 +110,7 @@ public:
             if (opt) {
                 // We only care about flags that should be passed through to the partition's verilate command.
                 if (opt->name == "-CFLAGS" || opt->name == "-LDFLAGS" || opt->name == "-D<var>[=<value>]" || opt->name == "-y" ||
-                    opt->name == "--timing" || opt->name == "--trace" || opt->name == "-Wall" || 
+                    opt->name == "--timing" || opt->name == "--trace" || opt->name == "-Wall" || opt->name == "--savable" ||
                     opt->name.rfind("-Wno-", 0) == 0 || opt->name == "--unroll-count") {
                     
                     verilatorFlags << currentArg;
@@ -109,6 +144,27 @@ public:
         makefileContent << "VERILATOR_FLAGS = " << verilatorFlags.str() << "\n";
         makefileContent << "LOG_FILE = build_library.log\n\n";
 
+        // The Verilated model only depends on the sources and flags, so a build of the same
+        // tile for another design or configuration can start from it
+        const std::string key = modelKey(partitionModuleName, partitionVerilogFiles, dependFiles,
+                                         verilatorFlags.str(), verilatorVersion);
+        makefileContent << "# Content-addressed cache of Verilated partition models, shared by all designs\n";
+        makefileContent << "# and runs using this tile; set METRO_MPI_CACHE empty to always rebuild\n";
+        makefileContent << "METRO_MPI_CACHE ?= $(HOME)/.cache/metro_mpi\n";
+        makefileContent << "MODEL_KEY = " << key << "\n";
+        makefileContent << "CACHE_DIR = $(METRO_MPI_CACHE)/$(top_mod)-$(MODEL_KEY)-$(METRO_MPI_TRANSPORT)\n\n";
+
+        // The generated transport is chosen when the partition is compiled
+        makefileContent << "# Transport between ranks: 'mpi', or 'shm' for single-node runs without MPI\n";
+        makefileContent << "METRO_MPI_TRANSPORT ?= mpi\n";
+        makefileContent << "ifeq ($(METRO_MPI_TRANSPORT),shm)\n";
+        makefileContent << "METRO_MPI_CXX ?= $(CXX)\n";
+        makefileContent << "METRO_MPI_CPPFLAGS = -DMETRO_MPI_SHM\n";
+        makefileContent << "METRO_MPI_LDLIBS = -lrt\n";
+        makefileContent << "else\n";
+        makefileContent << "METRO_MPI_CXX ?= mpic++\n";
+        makefileContent << "endif\n\n";
+
         // Targets
         makefileContent << ".PHONY: library verilate build clean\n\n";
 
@@ -119,16 +175,34 @@ public:
 
         makefileContent << "verilate:\n";
         makefileContent << "\t@echo \"Starting build at $$(date)\" > $(LOG_FILE)\n";
-        makefileContent << "\t@echo \"\\n== == == 4. Elaborating " << partitionModuleName << " with MPI...\" >> $(LOG_FILE) 2>&1\n";
-        makefileContent << "\t@(verilator -cc $(SRC_FILES) \\\n";
-        makefileContent << "\t\t--exe $(CXX_SOURCES) \\\n";
-        makefileContent << "\t\t--Mdir $(obj_dir) \\\n";
-        makefileContent << "\t\t--top-module $(top_mod) \\\n";
-        makefileContent << "\t\t$(VERILATOR_FLAGS)) >> $(LOG_FILE) 2>&1\n\n";
+        // A cached model comes with its objects; make then only compiles and links the main
+        makefileContent << "\t@if [ -n \"$(METRO_MPI_CACHE)\" ] && [ -f $(CACHE_DIR)/.complete ]; then \\\n";
+        makefileContent << "\t\techo \"\\n== == == 4. Reusing " << partitionModuleName << " from $(CACHE_DIR)\" >> $(LOG_FILE); \\\n";
+        makefileContent << "\t\tmkdir -p $(obj_dir) && cp -pR $(CACHE_DIR)/. $(obj_dir)/; \\\n";
+        makefileContent << "\telse \\\n";
+        makefileContent << "\t\techo \"\\n== == == 4. Elaborating " << partitionModuleName << " with MPI...\" >> $(LOG_FILE) 2>&1; \\\n";
+        makefileContent << "\t\t(verilator -cc $(SRC_FILES) \\\n";
+        makefileContent << "\t\t\t--exe $(CXX_SOURCES) \\\n";
+        makefileContent << "\t\t\t--Mdir $(obj_dir) \\\n";
+        makefileContent << "\t\t\t--top-module $(top_mod) \\\n";
+        makefileContent << "\t\t\t$(VERILATOR_FLAGS)) >> $(LOG_FILE) 2>&1; \\\n";
+        makefileContent << "\tfi\n\n";
 
         makefileContent << "build: verilate\n";
         makefileContent << "\t@echo \"\\n== == == 5. Making the library...\" >> $(LOG_FILE) 2>&1\n";
-        makefileContent << "\t@(make CXX=mpic++ LINK=mpic++ -C $(obj_dir) -f $(TOP).mk $(TOP)) >> $(LOG_FILE) 2>&1\n";
+        makefileContent << "\t@(make CXX=$(METRO_MPI_CXX) LINK=$(METRO_MPI_CXX) \\\n";
+        makefileContent << "\t\tUSER_CPPFLAGS=\"$(METRO_MPI_CPPFLAGS)\" USER_LDLIBS=\"$(METRO_MPI_LDLIBS)\" \\\n";
+        makefileContent << "\t\t-C $(obj_dir) -f $(TOP).mk $(TOP)) >> $(LOG_FILE) 2>&1\n";
+        // Stored without this design's main; renamed into place so concurrent builds
+        // never see a partial entry
+        makefileContent << "\t@if [ -n \"$(METRO_MPI_CACHE)\" ] && [ ! -f $(CACHE_DIR)/.complete ]; then \\\n";
+        makefileContent << "\t\tmkdir -p $(CACHE_DIR).tmp$$$$ && cp -pR $(obj_dir)/. $(CACHE_DIR).tmp$$$$/ && \\\n";
+        makefileContent << "\t\trm -f $(CACHE_DIR).tmp$$$$/$(TOP) $(CACHE_DIR).tmp$$$$/$(top_mod)_main.* && \\\n";
+        makefileContent << "\t\ttouch $(CACHE_DIR).tmp$$$$/.complete && \\\n";
+        makefileContent << "\t\t{ [ -d $(CACHE_DIR) ] || mv $(CACHE_DIR).tmp$$$$ $(CACHE_DIR); }; \\\n";
+        makefileContent << "\t\trm -rf $(CACHE_DIR).tmp$$$$; \\\n";
+        makefileContent << "\t\techo \"Stored " << partitionModuleName << " in $(CACHE_DIR)\" >> $(LOG_FILE); \\\n";
+        makefileContent << "\tfi\n";
         makefileContent << "\t@echo \"\\nBuild finished at $$(date)\" >> $(LOG_FILE)\n\n";
 
         makefileContent << "clean:\n";
@@ -142,7 +216,8 @@ public:
         if (outfile.is_open()) {
             outfile << makefileContent.str();
             outfile.close();
-            std::cout << "  --> Successfully wrote Makefile to '" << makefileName << "'\n";
+            std::cout << "  --> Successfully wrote Makefile to '" << makefileName << "' (model key "
+                      << key << ")\n";
         } else {
             std::cerr << "  --> ERROR: Could not open file to write Makefile: " << makefileName << "\n";
         }
@@ -189,6 +264,19 @@ void MakefileGenerator::VerilatorOptionsDb::initialize() {
     m_options = {
         {"--mmpi-o1", {}, "Custom Metro-MPI: Enable optimization level 1", false},
         {"--d1", {}, "Custom Metro-MPI: Enable debug level 1", false},
+        {"--mmpi-clock", {}, "Custom Metro-MPI: Boundary clock for cycle-batched exchange", true},
+        {"--mmpi-lookahead", {}, "Custom Metro-MPI: Cycles partitions may run ahead on latency-insensitive links", true},
+        {"--mmpi-latency-insensitive", {}, "Custom Metro-MPI: Partition output whose link may be primed for lookahead", true},
+        {"--mmpi-nonblocking", {}, "Custom Metro-MPI: Persistent non-blocking exchange on partition ranks", false},
+        {"--mmpi-pack", {}, "Custom Metro-MPI: Bit-pack boundary messages", false},
+        {"--mmpi-delta", {}, "Custom Metro-MPI: Send only changed boundary values", false},
+        {"--mmpi-checkpoint", {}, "Custom Metro-MPI: Coordinated checkpoint and restore of all ranks", false},
+        {"--mmpi-prof", {}, "Custom Metro-MPI: Per-rank eval and communication profile", false},
+        {"--mmpi-report", {}, "Custom Metro-MPI: Write the partition analysis to partition_report.json", false},
+        {"--mmpi-ranks", {}, "Custom Metro-MPI: Target number of MPI ranks including rank 0", true},
+        {"--mmpi-instances-per-rank", {}, "Custom Metro-MPI: Partition instances evaluated by one MPI rank", true},
+        {"--mmpi-ranks-per-node", {}, "Custom Metro-MPI: MPI ranks per node for rank placement", true},
+        {"--mmpi-profile", {}, "Custom Metro-MPI: Measured per-instance costs for partitioning", true},
         {"<file.v>", {}, "Verilog package, module, and top module filenames", false},
         {"<file.c/cc/cpp>", {}, "Optional C++ files to compile in", false},
         {"<file.a/o/so>", {}, "Optional C++ files to link in", false},
@@ -22,14 +22,30 @@
 
 class MPIFileGenerator {
 public:
+    /// A module the partitions are cut from, rewritten to instantiate their wrappers
+    struct ParentSite {
+        std::string moduleName;  ///< Names the rewritten file, modified_<moduleName>.v
+        std::string origName;  ///< Name of the module in its source
+        std::string filePath;  ///< Source file defining the module
+        std::map<std::string, std::string> instances;  ///< Partition -> instance name in it
+    };
+
+    /**
+     * @param instanceModuleOrigNames Maps each partition instance to the original name of its
+     * module. Partitions may be instances of different modules; one stub is generated per module.
+     * @param parents The modules holding the partitions, outermost first. Parents defined in
+     * one file are rewritten into one modified file, named after the first of them.
+     * @param timescale `timescale directive for the stub and wrappers, empty when the design
+     * has none; Verilog requires it on all modules or none.
+     */
     template<typename PortType>
     void generateAndModifyFiles(
-        const std::string& partitionModuleName,
-        const std::string& partitionModuleOrigName,
+        const std::map<std::string, std::string>& instanceModuleOrigNames,
         const std::map<std::string, std::vector<PortType>>& partitionData,
         const std::unordered_map<std::string, AstNodeModule*>& moduleNameToModulePtr,
-        const std::string& parentModuleFilePath,
-        const std::string& parentModuleName) {
+        const std::vector<ParentSite>& parents,
+        const std::string& boundaryClock = "",
+        const std::string& timescale = "") {
 
         if (partitionData.empty()) {
             std::cerr << "  --> ERROR: Partition data is empty, cannot generate files.\n";
@@ -40,83 +56,124 @@ public:
         // ...
         // (The code for Part 1 is identical to the previous version and is omitted for brevity)
         // ...
-        std::cout << "\n[INFO] Part 1: Generating generic DPI stub module for '" << partitionModuleOrigName << "'...\n";
+        // One representative instance per partition module provides the stub's ports
+        std::map<std::string, std::string> moduleRepresentatives;
+        for (const auto& pair : partitionData) {
+            moduleRepresentatives.emplace(instanceModuleOrigNames.at(pair.first), pair.first);
+        }
+        for (const auto& [partitionModuleOrigName, representative] : moduleRepresentatives) {
+            std::cout << "\n[INFO] Part 1: Generating generic DPI stub module for '" << partitionModuleOrigName << "'...\n";
         
-        const auto& ports = partitionData.begin()->second;
-        std::string stubModuleName = "modified_" + partitionModuleOrigName;
-        std::string outStubFileName = "metro_mpi/" + stubModuleName + ".v";
-        {
-            std::ofstream outStubFile(outStubFileName);
-            outStubFile << "`timescale 1ns / 1ps\n\n";
-            outStubFile << "module " << stubModuleName << " #(\n";
-            outStubFile << "  parameter integer PARTITION_ID = -1\n";
-            outStubFile << ") (\n";
-            for (size_t i = 0; i < ports.size(); ++i) {
-                outStubFile << "  " << ports[i].name << (i == ports.size() - 1 ? "" : ",\n");
-            }
-            outStubFile << ");\n\n";
-            for (const auto& port : ports) {
-                std::string directionKeyword;
-                if (port.direction == "in") directionKeyword = "input";
-                else if (port.direction == "out") directionKeyword = "output";
-                else if (port.direction == "input") directionKeyword = "input";
-                else if (port.direction == "output") directionKeyword = "output";
-                else if (port.direction == "Input") directionKeyword = "input";
-                else if (port.direction == "Output") directionKeyword = "output";
-                else directionKeyword = "inout";
-
-                // ================== MODIFICATION START ==================
-                // Conditionally choose data type based on port direction.
-                // Inputs and inouts are nets (wire), outputs from procedural
-                // blocks should be variables (reg).
-                std::string dataTypeKeyword;
-                if (directionKeyword == "input" || directionKeyword == "inout") {
-                    dataTypeKeyword = "wire";
-                } else { // output
-                    dataTypeKeyword = "reg";
+            const auto& ports = partitionData.at(representative);
+            std::string stubModuleName = "modified_" + partitionModuleOrigName;
+            std::string outStubFileName = "metro_mpi/" + stubModuleName + ".v";
+            {
+                std::ofstream outStubFile(outStubFileName);
+                if (!timescale.empty()) outStubFile << timescale << "\n\n";
+                outStubFile << "module " << stubModuleName << " #(\n";
+                outStubFile << "  parameter integer PARTITION_ID = -1\n";
+                outStubFile << ") (\n";
+                for (size_t i = 0; i < ports.size(); ++i) {
+                    outStubFile << "  " << ports[i].name << (i == ports.size() - 1 ? "" : ",\n");
                 }
-                // =================== MODIFICATION END ===================
+                outStubFile << ");\n\n";
+                for (const auto& port : ports) {
+                    std::string directionKeyword;
+                    if (port.direction == "in") directionKeyword = "input";
+                    else if (port.direction == "out") directionKeyword = "output";
+                    else if (port.direction == "input") directionKeyword = "input";
+                    else if (port.direction == "output") directionKeyword = "output";
+                    else if (port.direction == "Input") directionKeyword = "input";
+                    else if (port.direction == "Output") directionKeyword = "output";
+                    else directionKeyword = "inout";
 
-                if (port.width > 1) {
-                    // Use the new dataTypeKeyword instead of hardcoded "logic"
-                    outStubFile << "  " << directionKeyword << " " << dataTypeKeyword << " [" << port.width - 1 << ":0] " << port.name << ";\n";
+                    // ================== MODIFICATION START ==================
+                    // Conditionally choose data type based on port direction.
+                    // Inputs and inouts are nets (wire), outputs from procedural
+                    // blocks should be variables (reg).
+                    std::string dataTypeKeyword;
+                    if (directionKeyword == "input" || directionKeyword == "inout") {
+                        dataTypeKeyword = "wire";
+                    } else { // output
+                        dataTypeKeyword = "reg";
+                    }
+                    // =================== MODIFICATION END ===================
+
+                    if (port.width > 1) {
+                        // Use the new dataTypeKeyword instead of hardcoded "logic"
+                        outStubFile << "  " << directionKeyword << " " << dataTypeKeyword << " [" << port.width - 1 << ":0] " << port.name << ";\n";
+                    } else {
+                        // Use the new dataTypeKeyword instead of hardcoded "logic"
+                        outStubFile << "  " << directionKeyword << " " << dataTypeKeyword << " " << port.name << ";\n";
+                    }
+                }
+                outStubFile << "\n";
+                std::stringstream dpiImportSignature;
+                std::stringstream dpiFunctionCall;
+                std::stringstream dpiSampledCall;  // Outputs go to the _mmpi_q holding regs
+                std::string dpiFunctionName = "dpi_" + partitionModuleOrigName;
+                dpiImportSignature << "input int partition_id";
+                dpiFunctionCall << "PARTITION_ID";
+                dpiSampledCall << "PARTITION_ID";
+                // The rank 0 harness declares the DPI function with its ports sorted by name
+                std::vector<PortType> dpiPorts = ports;
+                std::sort(dpiPorts.begin(), dpiPorts.end(),
+                          [](const PortType& a, const PortType& b) { return a.name < b.name; });
+                for (const auto& port : dpiPorts) {
+                    dpiImportSignature << ", ";
+                    dpiFunctionCall << ", ";
+                    dpiSampledCall << ", ";
+                    std::string dpiDataType;
+                    // 2-state types throughout; wide ports are passed as svBitVecVal word arrays
+                    if (port.width == 1) dpiDataType = "bit";
+                    else if (port.width <= 32) dpiDataType = "int";
+                    else if (port.width <= 64) dpiDataType = "longint";
+                    else dpiDataType = "bit [" + std::to_string(port.width - 1) + ":0]";
+                    std::string directionKeyword;
+                    if (port.direction == "in") directionKeyword = "input";
+                    else if (port.direction == "out") directionKeyword = "output";
+                    else if (port.direction == "input") directionKeyword = "input";
+                    else if (port.direction == "output") directionKeyword = "output";
+                    else if (port.direction == "Input") directionKeyword = "input";
+                    else if (port.direction == "Output") directionKeyword = "output";
+                    else directionKeyword = "inout";
+                    dpiImportSignature << directionKeyword << " " << dpiDataType << " " << port.name;
+                    dpiFunctionCall << port.name;
+                    dpiSampledCall << port.name << (directionKeyword == "output" ? "_mmpi_q" : "");
+                }
+                outStubFile << "  import \"DPI-C\" function void " << dpiFunctionName << "(" << dpiImportSignature.str() << ");\n";
+                if (boundaryClock.empty()) {
+                    outStubFile << "\n  always @(*) begin\n";
+                    outStubFile << "    " << dpiFunctionName << "(" << dpiFunctionCall.str() << ");\n";
+                    outStubFile << "  end\n";
                 } else {
-                    // Use the new dataTypeKeyword instead of hardcoded "logic"
-                    outStubFile << "  " << directionKeyword << " " << dataTypeKeyword << " " << port.name << ";\n";
+                    // Cycle-batched exchange: the inputs are sampled once per edge of the
+                    // boundary clock, and the partition evaluates that edge before returning
+                    // its outputs. They are committed non-blocking, so registered partition
+                    // outputs change at the edge exactly as they did in place. Combinational
+                    // paths through the partition only see the inputs sampled before the
+                    // edge, held until the next one.
+                    outStubFile << "\n";
+                    for (const auto& port : ports) {
+                        if (port.direction != "out" && port.direction != "output"
+                            && port.direction != "Output") continue;
+                        outStubFile << "  reg ";
+                        if (port.width > 1) outStubFile << "[" << port.width - 1 << ":0] ";
+                        outStubFile << port.name << "_mmpi_q;\n";
+                    }
+                    outStubFile << "\n  always @(posedge " << boundaryClock << ") begin\n";
+                    outStubFile << "    " << dpiFunctionName << "(" << dpiSampledCall.str() << ");\n";
+                    for (const auto& port : ports) {
+                        if (port.direction != "out" && port.direction != "output"
+                            && port.direction != "Output") continue;
+                        outStubFile << "    " << port.name << " <= " << port.name << "_mmpi_q;\n";
+                    }
+                    outStubFile << "  end\n";
                 }
+                outStubFile << "endmodule\n";
+                outStubFile.close();
+                std::cout << "  --> Successfully wrote stub module to '" << outStubFileName << "'\n";
             }
-            outStubFile << "\n";
-            std::stringstream dpiImportSignature;
-            std::stringstream dpiFunctionCall;
-            std::string dpiFunctionName = "dpi_" + partitionModuleOrigName;
-            dpiImportSignature << "input int partition_id"; 
-            dpiFunctionCall << "PARTITION_ID";
-            for (const auto& port : ports) {
-                dpiImportSignature << ", ";
-                dpiFunctionCall << ", ";
-                std::string dpiDataType;
-                if (port.width == 1) dpiDataType = "bool";
-                else if (port.width <= 32) dpiDataType = "int";
-                else if (port.width <= 64) dpiDataType = "longint";
-                else dpiDataType = "logic [" + std::to_string(port.width - 1) + ":0]";
-                std::string directionKeyword;
-                if (port.direction == "in") directionKeyword = "input";
-                else if (port.direction == "out") directionKeyword = "output";
-                else if (port.direction == "input") directionKeyword = "input";
-                else if (port.direction == "output") directionKeyword = "output";
-                else if (port.direction == "Input") directionKeyword = "input";
-                else if (port.direction == "Output") directionKeyword = "output";
-                else directionKeyword = "inout";
-                dpiImportSignature << directionKeyword << " " << dpiDataType << " " << port.name;
-                dpiFunctionCall << port.name;
-            }
-            outStubFile << "  import \"DPI-C\" function void " << dpiFunctionName << "(" << dpiImportSignature.str() << ");\n";
-            outStubFile << "\n  always @(*) begin\n";
-            outStubFile << "    " << dpiFunctionName << "(" << dpiFunctionCall.str() << ");\n";
-            outStubFile << "  end\n";
-            outStubFile << "endmodule\n";
-            outStubFile.close();
-            std::cout << "  --> Successfully wrote stub module to '" << outStubFileName << "'\n";
         }
 
 
@@ -129,9 +186,12 @@ public:
             const std::string& instanceName = pair.first;
             const auto& instancePorts = pair.second;
             int mpiRank = instancePorts.front().mpi_rank;
+            const std::string& partitionModuleOrigName = instanceModuleOrigNames.at(instanceName);
+            std::string stubModuleName = "modified_" + partitionModuleOrigName;
             std::string wrapperModuleName = instanceName + "_" + partitionModuleOrigName + "_wrapper";
             std::string wrapperFileName = "metro_mpi/" + wrapperModuleName + ".v";
             std::ofstream outWrapperFile(wrapperFileName);
+            if (!timescale.empty()) outWrapperFile << timescale << "\n\n";
             outWrapperFile << "module " << wrapperModuleName << " (\n";
              for (size_t i = 0; i < instancePorts.size(); ++i) {
                 outWrapperFile << "  " << instancePorts[i].name << (i == instancePorts.size() - 1 ? "" : ",\n");
@@ -180,47 +240,78 @@ public:
 
 
         // =================================================================================
-        // Part 3: Generate the modified parent module (MODIFIED)
+        // Part 3: Generate the modified parent modules (MODIFIED)
         // This now uses a more robust regex to handle parameter overrides and comments.
         // =================================================================================
-        std::cout << "\n[INFO] Part 3: Generating modified parent module...\n";
-        std::cout << "  --> Reading original parent module from: " << parentModuleFilePath << "\n";
-        std::ifstream parentFile(parentModuleFilePath);
-        if (!parentFile.is_open()) {
-            std::cerr << "  --> ERROR: Could not open parent module file.\n";
-            return;
+        std::cout << "\n[INFO] Part 3: Generating modified parent modules...\n";
+        std::vector<std::string> parentFiles;  // In order of their first parent
+        for (const ParentSite& parent : parents) {
+            if (std::find(parentFiles.begin(), parentFiles.end(), parent.filePath)
+                == parentFiles.end()) {
+                parentFiles.push_back(parent.filePath);
+            }
         }
-        std::stringstream buffer;
-        buffer << parentFile.rdbuf();
-        std::string parentFileContent = buffer.str();
-        parentFile.close();
+        for (const std::string& parentModuleFilePath : parentFiles) {
+            std::cout << "  --> Reading original parent module from: " << parentModuleFilePath << "\n";
+            std::ifstream parentFile(parentModuleFilePath);
+            if (!parentFile.is_open()) {
+                std::cerr << "  --> ERROR: Could not open parent module file.\n";
+                return;
+            }
+            std::stringstream buffer;
+            buffer << parentFile.rdbuf();
+            std::string parentFileContent = buffer.str();
+            parentFile.close();
 
-        // Perform search-and-replace for each partition instance
-        for (const auto& pair : partitionData) {
-            const std::string& instanceName = pair.first;
-            std::string wrapperModuleName = instanceName + "_" + partitionModuleOrigName + "_wrapper";
+            std::string parentModuleName;
+            for (const ParentSite& parent : parents) {
+                if (parent.filePath != parentModuleFilePath) continue;
+                if (parentModuleName.empty()) parentModuleName = parent.moduleName;
+
+                // Only the parent's own body is rewritten, as other modules of the file may
+                // hold instances of the same name
+                size_t bodyStart = 0;
+                size_t bodyEnd = parentFileContent.size();
+                std::smatch match;
+                if (std::regex_search(parentFileContent, match,
+                                      std::regex("\\bmodule\\s+" + parent.origName + "\\b"))) {
+                    bodyStart = match.position(0);
+                    const std::string rest = parentFileContent.substr(bodyStart);
+                    if (std::regex_search(rest, match, std::regex("\\bendmodule\\b"))) {
+                        bodyEnd = bodyStart + match.position(0);
+                    }
+                }
+                std::string body = parentFileContent.substr(bodyStart, bodyEnd - bodyStart);
+
+                // Perform search-and-replace for each partition instance
+                for (const auto& [partitionName, instanceName] : parent.instances) {
+                    const std::string& partitionModuleOrigName = instanceModuleOrigNames.at(partitionName);
+                    std::string wrapperModuleName = partitionName + "_" + partitionModuleOrigName + "_wrapper";
+
+                    // This new, more robust regex finds the module type to replace.
+                    // It looks for:
+                    //   - The original module name (as a whole word: \b)
+                    //   - Then captures anything (parameters, comments, whitespace) up to...
+                    //   - The instance name (as a whole word) followed by an opening parenthesis.
+                    std::regex search_regex("(\\b" + partitionModuleOrigName + "\\b)(.*?\\b" + instanceName + "\\b\\s*\\()");
 
-            // This new, more robust regex finds the module type to replace.
-            // It looks for:
-            //   - The original module name (as a whole word: \b)
-            //   - Then captures anything (parameters, comments, whitespace) up to...
-            //   - The instance name (as a whole word) followed by an opening parenthesis.
-            std::regex search_regex("(\\b" + partitionModuleOrigName + "\\b)(.*?\\b" + instanceName + "\\b\\s*\\()");
+                    // The replacement will be:
+                    //   - The new wrapper module name
+                    //   - Followed by the captured middle part (the ".*?") and the instance name.
+                    std::string replace_string = wrapperModuleName + "$2";
 
-            // The replacement will be:
-            //   - The new wrapper module name
-            //   - Followed by the captured middle part (the ".*?") and the instance name.
-            std::string replace_string = wrapperModuleName + "$2";
+                    body = std::regex_replace(body, search_regex, replace_string);
+                }
+                parentFileContent.replace(bodyStart, bodyEnd - bodyStart, body);
+            }
 
-            parentFileContent = std::regex_replace(parentFileContent, search_regex, replace_string);
+            std::string outParentFileName = "metro_mpi/modified_" + parentModuleName + ".v";
+            std::ofstream outParentFile(outParentFileName);
+            outParentFile << "// Modified by Metro-MPI to use specialized wrappers\n\n";
+            outParentFile << parentFileContent;
+            outParentFile.close();
+            std::cout << "  --> Successfully wrote modified parent to '" << outParentFileName << "'\n";
         }
-        
-        std::string outParentFileName = "metro_mpi/modified_" + parentModuleName + ".v";
-        std::ofstream outParentFile(outParentFileName);
-        outParentFile << "// Modified by Metro-MPI to use specialized wrappers\n\n";
-        outParentFile << parentFileContent;
-        outParentFile.close();
-        std::cout << "  --> Successfully wrote modified parent to '" << outParentFileName << "'\n";
     }
 };
 
@@ -31,6 +31,8 @@ private:
         std::string name;
         int width;
         std::string direction;
+        std::string field;  ///< Member of the rank-pair message struct carrying this port
+        bool latencyInsensitive = false;  ///< Output annotated --mmpi-latency-insensitive
 
         bool operator<(const PortDetail& other) const {
             return name < other.name;
@@ -45,48 +47,79 @@ public:
     /**
      * @brief The main entry point for the generator.
      * @param jsonFilePath Path to the `partition_report.json` file.
-     * @param partitionModuleName The name of the module that has been partitioned.
+     * @param partitionModuleNames The modules that have been partitioned; one DPI function
+     * is generated for each.
      */
-    void generate(const std::string& jsonFilePath, const std::string& partitionModuleName) {
+    void generate(const std::string& jsonFilePath,
+                  const std::vector<std::string>& partitionModuleNames) {
         // Open and parse the JSON report which contains all analysis results.
         std::ifstream inputFile(jsonFilePath);
         if (!inputFile.is_open()) {
             throw std::runtime_error("Error [Rank0MainGenerator]: Could not open JSON file " + jsonFilePath);
         }
-        json data = json::parse(inputFile);
+        generateFromReport(json::parse(inputFile), partitionModuleNames);
+    }
 
+    /**
+     * @brief Same as generate(), from the analysis held in memory.
+     */
+    void generateFromReport(const json& data,
+                            const std::vector<std::string>& partitionModuleNames) {
         SystemCommMap sendsToSystem;
         SystemCommMap receivesFromSystem;
         std::set<int> partitionRanks;
-        std::vector<PortDetail> allPorts;
+        // Per partition module: the ranks running it and its ports
+        std::map<std::string, std::set<int>> moduleRanks;
+        std::map<std::string, std::vector<PortDetail>> modulePorts;
+        // Rank 0 fan-out: each broadcast is issued from the DPI call of its first member,
+        // which happens exactly once per cycle like those of the other members
+        std::map<int, int> broadcastLeaders;  // group -> rank
+        std::map<int, std::vector<std::pair<int, PortDetail>>> broadcastsOf;  // rank -> groups
 
         // --- Step 1: Parse the JSON report ---
-        bool allPortsCaptured = false;
         for (auto const& [instanceName, ports] : data["partitions"].items()) {
             int current_rank = -1;
+            if (ports.empty()) continue;
+            // Reports without module names come from a single partition module
+            const std::string moduleName
+                = ports.front().value("partition_module", partitionModuleNames.front());
+            const bool allPortsCaptured = modulePorts.count(moduleName);
+            std::vector<PortDetail>& allPorts = modulePorts[moduleName];
             for (const auto& port : ports) {
                 if (current_rank == -1) {
                     current_rank = port["mpi_rank"].get<int>();
                     partitionRanks.insert(current_rank);
+                    moduleRanks[moduleName].insert(current_rank);
                 }
                 if (!allPortsCaptured) {
-                    allPorts.push_back({port["port_name"], port["width"], port["direction"]});
+                    allPorts.push_back({port["port_name"], port["width"], port["direction"], ""});
+                }
+                // Inactive ports (constants, the boundary clock) are not in any message
+                if (port["active"] != "Yes") continue;
+                const int bcastGroup = port.value("bcast_group", -1);
+                if (bcastGroup >= 0) {
+                    if (broadcastLeaders.emplace(bcastGroup, current_rank).second) {
+                        broadcastsOf[current_rank].push_back(
+                            {bcastGroup, {port["port_name"], port["width"], port["direction"], "value"}});
+                    }
+                    continue;
                 }
                 for (const auto& commPartner : port["with_whom_is_it_communicating"]) {
                     if (commPartner["mpi_rank"] == 0) {
                         std::string dir = port["direction"];
+                        // Message members are named after the sending side's port
                         if (dir == "out" || dir == "Output") {
-                            sendsToSystem[current_rank].push_back({port["port_name"], port["width"], dir});
+                            sendsToSystem[current_rank].push_back({port["port_name"], port["width"], dir, port["port_name"],
+                                                                   port.value("latency_insensitive", "No") == "Yes"});
                         } else {
-                            receivesFromSystem[current_rank].push_back({port["port_name"], port["width"], dir});
+                            receivesFromSystem[current_rank].push_back({port["port_name"], port["width"], dir, commPartner["port"]});
                         }
                     }
                 }
             }
-            allPortsCaptured = true;
         }
         
-        std::sort(allPorts.begin(), allPorts.end());
+        for (auto& it : modulePorts) std::sort(it.second.begin(), it.second.end());
 
         // --- Step 2: Generate the `rank0_harness.h` file ---
         std::string outHarnessFileName = "metro_mpi/rank0_harness.h";
@@ -99,59 +132,159 @@ public:
         outHarnessFile << "// Include this file in your custom C++ testbench (e.g., sim.cpp)\n\n";
         outHarnessFile << "#ifndef METRO_MPI_RANK0_HARNESS_H\n";
         outHarnessFile << "#define METRO_MPI_RANK0_HARNESS_H\n\n";
-        outHarnessFile << "#include <mpi.h>\n";
+        const bool prof = data.value("config", json::object()).value("prof", false);
+        outHarnessFile << "#include <cstring>\n";
+        if (data.value("config", json::object()).value("checkpoint", false)) {
+            outHarnessFile << "#include <functional>\n";
+        }
+        outHarnessFile << "#include \"svdpi.h\"\n";
+        outHarnessFile << "#include \"verilated.h\"\n";
         outHarnessFile << "#include \"metro_mpi.cpp\"\n\n";
 
-        // Generate the DPI function implementation
-        outHarnessFile << "extern \"C\" void dpi_" << partitionModuleName << "(\n";
-        outHarnessFile << "    int partition_id";
-        for(const auto& port : allPorts) {
-            std::string c_type = (port.width > 32) ? "long long" : "int";
-            std::string direction_spec = (port.direction == "out" || port.direction == "Output") ? "* " : "";
-            outHarnessFile << ",\n    " << c_type << " " << direction_spec << port.name;
-        }
-        outHarnessFile << ") {\n";
-        outHarnessFile << "    switch (partition_id) {\n";
-        for (int rank : partitionRanks) {
-            outHarnessFile << "        case " << rank << ": {\n";
-            if (receivesFromSystem.count(rank)) {
-                outHarnessFile << "            mpi_rank_0_to_" << rank << "_t req;\n";
-                for (const auto& port : receivesFromSystem.at(rank)) {
-                    outHarnessFile << "            req." << port.name << " = " << port.name << ";\n";
+        outHarnessFile << "// A partition ran $finish: end the testbench loop as a local $finish would\n";
+        outHarnessFile << "static void metro_mpi_partition_finished() {\n";
+        outHarnessFile << "    if (!Verilated::threadContextp()->gotFinish()) {\n";
+        outHarnessFile << "        std::cout << \"[Rank 0] A partition finished the simulation.\" << std::endl;\n";
+        outHarnessFile << "    }\n";
+        outHarnessFile << "    Verilated::threadContextp()->gotFinish(true);\n";
+        outHarnessFile << "}\n\n";
+
+        // Generate the DPI function implementations, one per partition module
+        for (const std::string& partitionModuleName : partitionModuleNames) {
+            if (!modulePorts.count(partitionModuleName)) continue;
+            const std::vector<PortDetail>& allPorts = modulePorts.at(partitionModuleName);
+            outHarnessFile << "extern \"C\" void dpi_" << partitionModuleName << "(\n";
+            outHarnessFile << "    int partition_id";
+            for(const auto& port : allPorts) {
+                // Must match the DPI import in the generated stub module
+                const bool is_output = (port.direction == "out" || port.direction == "Output");
+                std::string c_type;
+                if (port.width == 1) c_type = "svBit";
+                else if (port.width <= 32) c_type = "int";
+                else if (port.width <= 64) c_type = "long long";
+                else c_type = is_output ? "svBitVecVal" : "const svBitVecVal";
+                std::string direction_spec = (is_output || port.width > 64) ? "* " : "";
+                outHarnessFile << ",\n    " << c_type << " " << direction_spec << port.name;
+            }
+            outHarnessFile << ") {\n";
+            outHarnessFile << "    switch (partition_id) {\n";
+            for (int rank : moduleRanks.at(partitionModuleName)) {
+                outHarnessFile << "        case " << rank << ": {\n";
+                if (prof) outHarnessFile << "            const uint64_t prof_start = mpi_prof_now();\n";
+                // Every partition has pairs to and from rank 0, if only for metro_mpi_ctrl
+                outHarnessFile << "            mpi_rank_0_to_" << rank << "_t req{};\n";
+                if (receivesFromSystem.count(rank)) {
+                    for (const auto& port : receivesFromSystem.at(rank)) {
+                        if (port.width > 64) {
+                            outHarnessFile << "            std::memcpy(req." << port.field << ", " << port.name << ", sizeof(req." << port.field << "));\n";
+                        } else {
+                            outHarnessFile << "            req." << port.field << " = " << port.name << ";\n";
+                        }
+                    }
                 }
+                outHarnessFile << "            req.metro_mpi_ctrl = METRO_MPI_CTRL_RUN;\n";
                 outHarnessFile << "            mpi_send_rank_0_to_" << rank << "(req);\n";
-            }
-            if (sendsToSystem.count(rank)) {
+                if (broadcastsOf.count(rank)) {
+                    for (const auto& [group, port] : broadcastsOf.at(rank)) {
+                        const std::string name = "mpi_bcast_" + std::to_string(group);
+                        outHarnessFile << "            {\n";
+                        outHarnessFile << "                " << name << "_t bcast;\n";
+                        if (port.width > 64) {
+                            outHarnessFile << "                std::memcpy(bcast.value, " << port.name << ", sizeof(bcast.value));\n";
+                        } else {
+                            outHarnessFile << "                bcast.value[0] = " << port.name << ";\n";
+                        }
+                        outHarnessFile << "                " << name << "_send(bcast);\n";
+                        outHarnessFile << "            }\n";
+                    }
+                }
                 outHarnessFile << "            mpi_rank_" << rank << "_to_0_t resp = mpi_receive_from_rank_" << rank << "_to_0();\n";
-                for (const auto& port : sendsToSystem.at(rank)) {
-                    outHarnessFile << "            *" << port.name << " = resp." << port.name << ";\n";
+                if (sendsToSystem.count(rank)) {
+                    for (const auto& port : sendsToSystem.at(rank)) {
+                        if (port.width > 64) {
+                            outHarnessFile << "            std::memcpy(" << port.name << ", resp." << port.field << ", sizeof(resp." << port.field << "));\n";
+                        } else {
+                            outHarnessFile << "            *" << port.name << " = resp." << port.field << ";\n";
+                        }
+                    }
                 }
+                outHarnessFile << "            if (resp.metro_mpi_ctrl == METRO_MPI_CTRL_STOP) metro_mpi_partition_finished();\n";
+                if (prof) {
+                    // Rank 0 is profiled by its exchanges only; its eval() is the testbench's
+                    outHarnessFile << "            const uint64_t prof_end = mpi_prof_now();\n";
+                    outHarnessFile << "            mpi_prof_exchange_ns += prof_end - prof_start;\n";
+                    outHarnessFile << "            mpi_prof_event(\"dpi_" << partitionModuleName << "\", 1, prof_start, prof_end);\n";
+                    outHarnessFile << "            ++mpi_prof_iterations;\n";
+                }
+                outHarnessFile << "            break;\n";
+                outHarnessFile << "        }\n";
             }
+            outHarnessFile << "        default: {\n";
             outHarnessFile << "            break;\n";
             outHarnessFile << "        }\n";
+            outHarnessFile << "    }\n";
+            outHarnessFile << "}\n\n";
         }
-        outHarnessFile << "        default: {\n";
-        outHarnessFile << "            break;\n";
-        outHarnessFile << "        }\n";
-        outHarnessFile << "    }\n";
-        outHarnessFile << "}\n\n";
 
         // Generate the shutdown helper function
         outHarnessFile << "void metro_mpi_broadcast_shutdown() {\n";
         outHarnessFile << "    std::cout << \"[Rank 0] Broadcasting shutdown signal.\" << std::endl;\n";
-        outHarnessFile << "    const int SHUTDOWN_TAG = 299;\n";
-        outHarnessFile << "    for (int rank : {";
-        bool first = true;
-        for(int rank : partitionRanks) {
-            if(!first) outHarnessFile << ", ";
-            outHarnessFile << rank;
-            first = false;
+        // The last exchange: STOP goes to every partition in the same round, together
+        // with the broadcasts they wait for, and their messages of that round are drained
+        // along with the lookahead still in flight on pairs they primed
+        const json config = data.value("config", json::object());
+        const int lookahead = config.value("lookahead", 0);
+        for (int rank : partitionRanks) {
+            outHarnessFile << "    {\n";
+            outHarnessFile << "        mpi_rank_0_to_" << rank << "_t req{};\n";
+            outHarnessFile << "        req.metro_mpi_ctrl = METRO_MPI_CTRL_STOP;\n";
+            outHarnessFile << "        mpi_send_rank_0_to_" << rank << "(req);\n";
+            outHarnessFile << "    }\n";
+        }
+        for (const auto& [group, rank] : broadcastLeaders) {
+            const std::string name = "mpi_bcast_" + std::to_string(group);
+            outHarnessFile << "    " << name << "_send(" << name << "_t{});\n";
+        }
+        for (int rank : partitionRanks) {
+            bool primed = lookahead > 0;
+            if (sendsToSystem.count(rank)) {
+                for (const auto& port : sendsToSystem.at(rank)) primed &= port.latencyInsensitive;
+            }
+            const int pending = primed ? 1 + lookahead : 1;
+            outHarnessFile << "    for (int i = 0; i < " << pending << "; ++i) (void)mpi_receive_from_rank_" << rank << "_to_0();\n";
         }
-        outHarnessFile << "}) {\n";
-        outHarnessFile << "        int dummy = 1;\n";
-        outHarnessFile << "        MPI_Send(&dummy, 1, MPI_INT, rank, SHUTDOWN_TAG, MPI_COMM_WORLD);\n";
-        outHarnessFile << "    }\n";
         outHarnessFile << "}\n\n";
+
+        if (config.value("checkpoint", false)) {
+            outHarnessFile << "// Checkpoints the whole job between two cycles. The partitions are waiting for\n";
+            outHarnessFile << "// the next cycle's message from rank 0; a SAVE in its place has them write the\n";
+            outHarnessFile << "// state of their last eval and wait again. 'save' writes rank 0's part, e.g.\n";
+            outHarnessFile << "// [&](VerilatedSerialize& os) { os << *top << cycle; }\n";
+            outHarnessFile << "void metro_mpi_checkpoint(const std::function<void(VerilatedSerialize&)>& save) {\n";
+            outHarnessFile << "    std::cout << \"[Rank 0] Writing checkpoint \" << metro_mpi_checkpoint_path() << std::endl;\n";
+            for (int rank : partitionRanks) {
+                outHarnessFile << "    {\n";
+                outHarnessFile << "        mpi_rank_0_to_" << rank << "_t req{};\n";
+                outHarnessFile << "        req.metro_mpi_ctrl = METRO_MPI_CTRL_SAVE;\n";
+                outHarnessFile << "        mpi_send_rank_0_to_" << rank << "(req);\n";
+                outHarnessFile << "    }\n";
+            }
+            outHarnessFile << "    MetroMpiSaveBuffer os;\n";
+            outHarnessFile << "    save(os);\n";
+            outHarnessFile << "    metro_mpi_write_checkpoint(os.finish());\n";
+            outHarnessFile << "}\n\n";
+
+            outHarnessFile << "// Restores the whole job from METRO_MPI_RESTORE, when it is set, through\n";
+            outHarnessFile << "// 'restore' for rank 0's part. Call it right after mpi_initialize().\n";
+            outHarnessFile << "bool metro_mpi_restore(const std::function<void(VerilatedDeserialize&)>& restore) {\n";
+            outHarnessFile << "    if (!metro_mpi_restore_path()) return false;\n";
+            outHarnessFile << "    std::cout << \"[Rank 0] Restoring checkpoint \" << metro_mpi_restore_path() << std::endl;\n";
+            outHarnessFile << "    MetroMpiRestoreBuffer os{metro_mpi_read_checkpoint()};\n";
+            outHarnessFile << "    restore(os);\n";
+            outHarnessFile << "    os.finish();\n";
+            outHarnessFile << "    return true;\n";
+            outHarnessFile << "}\n\n";
+        }
         outHarnessFile << "#endif // METRO_MPI_RANK0_HARNESS_H\n";
         outHarnessFile.close();
         std::cout << "[Metro-MPI] Successfully generated Rank 0 harness: " << outHarnessFileName << std::endl;
@@ -185,6 +318,9 @@ public:
         outReadmeFile << "    \n";
         outReadmeFile << "    metro_mpi_broadcast_shutdown(); // <-- ADD THIS LINE to signal other ranks to exit.\n";
         outReadmeFile << "    \n";
+        outReadmeFile << "    // A $finish inside a partition sets gotFinish() on rank 0's context, so a loop\n";
+        outReadmeFile << "    // testing contextp->gotFinish() also ends there.\n";
+        outReadmeFile << "    \n";
         outReadmeFile << "    top->final();\n";
         outReadmeFile << "    trace->close();\n";
         outReadmeFile << "    delete top;\n";
@@ -198,7 +334,70 @@ public:
         outReadmeFile << "------------------------------------------------\n";
         outReadmeFile << "When you build your final executable, you must use an MPI C++ compiler wrapper, such as 'mpic++'.\n";
         outReadmeFile << "Example Makefile rule:\n";
-        outReadmeFile << "    make CXX=mpic++ LINK=mpic++ -C $(OBJ_DIR) -f Vyour_top_module.mk\n";
+        outReadmeFile << "    make CXX=mpic++ LINK=mpic++ -C $(OBJ_DIR) -f Vyour_top_module.mk\n\n\n";
+
+        outReadmeFile << "5. OPTIONAL: SINGLE-NODE RUNS WITHOUT MPI:\n";
+        outReadmeFile << "------------------------------------------\n";
+        outReadmeFile << "Compiling everything with -DMETRO_MPI_SHM replaces MPI by shared-memory rings\n";
+        outReadmeFile << "(partitions: 'make -f metro_mpi/Makefile.<partition> METRO_MPI_TRANSPORT=shm').\n";
+        outReadmeFile << "Start every process yourself instead of through mpirun, with its rank and the\n";
+        outReadmeFile << "total process count in the environment, e.g. for one partition rank:\n";
+        outReadmeFile << "    METRO_MPI_SIZE=2 METRO_MPI_RANK=0 ./your_testbench &\n";
+        outReadmeFile << "    METRO_MPI_SIZE=2 METRO_MPI_RANK=1 ./obj_dir_<partition>/V<partition>\n";
+        outReadmeFile << "Concurrent runs need distinct METRO_MPI_SHM_NAME values (default /metro_mpi).\n";
+
+        int section = 6;  // The optional sections are numbered as they appear
+        if (config.value("checkpoint", false)) {
+            outReadmeFile << "\n\n" << section++ << ". CHECKPOINT AND RESTORE (--mmpi-checkpoint, build with --savable):\n";
+            outReadmeFile << "-------------------------------------------------------------------\n";
+            outReadmeFile << "Between two cycles, checkpoint every rank into $METRO_MPI_CHECKPOINT\n";
+            outReadmeFile << "(default metro_mpi.ckpt; one file per rank, <file>.<rank>, with METRO_MPI_SHM):\n";
+            outReadmeFile << "    metro_mpi_checkpoint([&](VerilatedSerialize& os) { os << *top; });\n";
+            outReadmeFile << "To resume, start the job on the same rank layout with METRO_MPI_RESTORE set\n";
+            outReadmeFile << "to that file for every process, and right after mpi_initialize() call:\n";
+            outReadmeFile << "    metro_mpi_restore([&](VerilatedDeserialize& os) { os >> *top; });\n";
+        }
+        if (prof) {
+            outReadmeFile << "\n\n" << section++ << ". PROFILE (--mmpi-prof):\n";
+            outReadmeFile << "---------------------\n";
+            outReadmeFile << "mpi_finalize() makes rank 0 write, under the $METRO_MPI_PROF prefix (default\n";
+            outReadmeFile << "metro_mpi_prof):\n";
+            outReadmeFile << "    <prefix>.txt      eval / exchange time per rank, traffic per link, eval imbalance\n";
+            outReadmeFile << "    <prefix>.json     timeline of every rank, for chrome://tracing or ui.perfetto.dev\n";
+            outReadmeFile << "    <prefix>.weights  eval time per partition instance; pass it to --mmpi-profile\n";
+            outReadmeFile << "                      to rebalance the next build\n";
+            outReadmeFile << "Each rank keeps its first $METRO_MPI_PROF_EVENTS timeline events (default 100000).\n";
+        }
+
+        // The partition ids were numbered so that consecutive ranks talk the most; a
+        // rankfile pins that order onto nodes, whatever the launcher's default mapping
+        const int ranksPerNode = config.value("ranks_per_node", 0);
+        if (ranksPerNode > 0) {
+            const int perRank = std::max(1, config.value("instances_per_rank", 1));
+            const int lastId = partitionRanks.empty() ? 0 : *partitionRanks.rbegin();
+            const int numRanks = 1 + (lastId ? 1 + (lastId - 1) / perRank : 0);
+            const std::string outRankfileName = "metro_mpi/rankfile";
+            std::ofstream outRankfile(outRankfileName);
+            if (!outRankfile.is_open()) {
+                throw std::runtime_error("Error [Rank0MainGenerator]: Could not open output file " + outRankfileName);
+            }
+            outRankfile << "# Open MPI rankfile: " << ranksPerNode << " ranks per node, in the order chosen\n";
+            outRankfile << "# by the Metro-MPI rank placement. +nK is the K-th host of the allocation.\n";
+            for (int r = 0; r < numRanks; ++r) {
+                outRankfile << "rank " << r << "=+n" << r / ranksPerNode << " slot=" << r % ranksPerNode << "\n";
+            }
+            outRankfile.close();
+            std::cout << "[Metro-MPI] Successfully generated rankfile: " << outRankfileName << std::endl;
+
+            outReadmeFile << "\n\n" << section++ << ". RANK PLACEMENT (--mmpi-ranks-per-node " << ranksPerNode << "):\n";
+            outReadmeFile << "--------------------------------------------\n";
+            outReadmeFile << "Partition ids were chosen so that most boundary traffic stays within a node\n";
+            outReadmeFile << "when every node runs " << ranksPerNode << " consecutive ranks. metro_mpi/rankfile pins\n";
+            outReadmeFile << "that layout (Open MPI):\n";
+            outReadmeFile << "    mpirun --hostfile <hosts> --rankfile metro_mpi/rankfile -np 1 ./your_testbench : \\\n";
+            outReadmeFile << "        -np " << numRanks - 1 << " ./obj_dir_<partition>/V<partition>\n";
+            outReadmeFile << "Other launchers need a by-slot / block mapping of ranks to nodes.\n";
+        }
 
         outReadmeFile.close();
         std::cout << "[Metro-MPI] Successfully generated integration instructions: " << outReadmeFileName << std::endl;
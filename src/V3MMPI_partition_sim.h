@@ -12,6 +12,10 @@
 #include <tuple>
 #include <stdexcept>
 #include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
 
 // This header requires the nlohmann/json library.
 // It is assumed to be available in your project's include path.
@@ -38,6 +42,7 @@ private:
         std::string sender_instance_name;
         int sender_rank;
         std::string sender_port_name;
+        bool latencyInsensitive;  // The sending port is annotated --mmpi-latency-insensitive
     };
 
     // Maps a {sender_rank, receiver_rank} pair to a list of connections
@@ -46,16 +51,47 @@ private:
     // Holds the initialization value for a single port.
     struct InitPortInfo {
         std::string port_name;
-        std::string init_value; // Stores a C++ compatible literal (e.g., "0xF")
+        std::string init_value; // Stores the Verilog literal (e.g., "4'hF")
+        int width;
     };
 
     // Holds all initialization info for a single partition instance.
     struct PartitionInfo {
         std::string instance_name;
+        std::string instance_hier;  // Hierarchical name in the design, for the profile
         int mpi_rank;
         std::vector<InitPortInfo> init_ports;
     };
 
+    // An input port fed by a rank 0 broadcast rather than the rank pair message
+    struct BroadcastInput {
+        int group;
+        std::string port_name;
+        int width;
+    };
+
+    // Parameter list of the generated per-instance functions, e.g. "Vtile* top"
+    std::string m_topParam;
+    // Broadcast inputs of each partition rank of this module
+    std::map<int, std::vector<BroadcastInput>> m_broadcastInputs;
+
+    /**
+     * @brief Generates the receives of the rank 0 broadcasts feeding rank 'r'.
+     * @details Called after the rank pair messages, which rank 0 always sends first.
+     */
+    void generateBroadcastReceives(std::ofstream& outFile, int r) {
+        const auto it = m_broadcastInputs.find(r);
+        if (it == m_broadcastInputs.end()) return;
+        for (const BroadcastInput& input : it->second) {
+            const std::string name = "mpi_bcast_" + std::to_string(input.group);
+            outFile << "    // Broadcast from Rank 0\n";
+            outFile << "    {\n";
+            outFile << "        " << name << "_t bcast = " << name << "_receive_to_" << r << "();\n";
+            outFile << "        " << fieldToPort(input.port_name, input.width > 64 ? "bcast.value" : "bcast.value[0]", input.width) << "\n";
+            outFile << "    }\n";
+        }
+    }
+
     /**
      * @brief Converts a Verilog-style string literal (e.g., "8'hF")
      * into a C++ compatible integer literal string (e.g., "0xF").
@@ -85,6 +121,145 @@ private:
         }
     }
 
+    /**
+     * @brief Generates the blocking send of a rank pair's message from the model's outputs.
+     */
+    void generateSend(std::ofstream& outFile, int sender, int receiver,
+                      const std::vector<P2P_Link>& links) {
+        const std::string var = "resp_to_" + std::to_string(receiver);
+        const std::string suffix = std::to_string(sender) + "_to_" + std::to_string(receiver);
+        outFile << "    // Send to Rank " << receiver << "\n";
+        outFile << "    {\n";
+        outFile << "        mpi_rank_" << suffix << "_t " << var << "{};\n";
+        for (const auto& link : links) {
+            outFile << "        " << portToField(var + "." + link.sender_port_name, link.sender_port_name, link.receiver_port_width) << "\n";
+        }
+        outFile << "        mpi_send_rank_" << suffix << "(" << var << ");\n";
+        outFile << "    }\n";
+    }
+
+    /**
+     * @brief Generates the statement copying a model port into a message struct field.
+     * @details Ports wider than 64 bits are VlWide<> in the model and uint32_t arrays in
+     * the message struct; both are contiguous 32-bit words, so they are block copied.
+     * Sending straight from the model (an hindexed datatype over MPI_BOTTOM) would save
+     * this copy, but packing, delta encoding, the shared-memory rings, colocated queues
+     * and checkpoints of in-flight messages all work on the message struct, so every
+     * port goes through it.
+     */
+    std::string portToField(const std::string& field, const std::string& port, int width) {
+        // The control field of the pair to rank 0 reports $finish instead of a port
+        if (port == "metro_mpi_ctrl") {
+            return field + " = top->contextp()->gotFinish() ? METRO_MPI_CTRL_STOP : METRO_MPI_CTRL_RUN;";
+        }
+        if (width > 64) {
+            return "std::memcpy(" + field + ", top->" + port + ".data(), sizeof(" + field + "));";
+        }
+        return field + " = top->" + port + ";";
+    }
+
+    /**
+     * @brief Generates the statement copying a message struct field into a model port.
+     */
+    std::string fieldToPort(const std::string& port, const std::string& field, int width) {
+        // The control field of the pair from rank 0 ends the run after this exchange
+        if (port == "metro_mpi_ctrl") {
+            return "if (" + field + " == METRO_MPI_CTRL_STOP) stop_received = true;";
+        }
+        if (width > 64) {
+            return "std::memcpy(top->" + port + ".data(), " + field + ", sizeof(" + field + "));";
+        }
+        return "top->" + port + " = " + field + ";";
+    }
+
+    /**
+     * @brief Splits a Verilog literal wider than 64 bits into VlWide word assignments.
+     * @details Hex, binary and octal digits are expanded bit by bit; decimal values are
+     * limited to 64 bits. Unknown digits (x/z) read as 0, as they do in the 2-state model.
+     */
+    std::vector<std::string> wide_init_words(const std::string& verilog_literal, int width) {
+        std::vector<uint32_t> words((width + 31) / 32, 0);
+        size_t apos_pos = verilog_literal.find('\'');
+        std::string val_part = (apos_pos == std::string::npos) ? "d" + verilog_literal
+                                                               : verilog_literal.substr(apos_pos + 1);
+        if (!val_part.empty() && (val_part[0] == 's' || val_part[0] == 'S')) val_part.erase(0, 1);
+        const char base_char = val_part.empty() ? 'd' : std::tolower(val_part[0]);
+        std::string digits;
+        for (char c : val_part.substr(1)) {
+            if (c != '_') digits += c;
+        }
+        const int bits_per_digit = (base_char == 'h') ? 4 : (base_char == 'o') ? 3 : (base_char == 'b') ? 1 : 0;
+        if (bits_per_digit == 0) {
+            const unsigned long long value = std::strtoull(digits.c_str(), nullptr, 10);
+            words[0] = static_cast<uint32_t>(value);
+            if (words.size() > 1) words[1] = static_cast<uint32_t>(value >> 32);
+        } else {
+            int bit = 0;
+            for (auto it = digits.rbegin(); it != digits.rend(); ++it) {
+                const int digit = std::isxdigit(*it) ? std::stoi(std::string(1, *it), nullptr, 16) : 0;
+                for (int b = 0; b < bits_per_digit; ++b, ++bit) {
+                    if (bit < width && ((digit >> b) & 1)) words[bit / 32] |= (1U << (bit % 32));
+                }
+            }
+        }
+        std::vector<std::string> result;
+        for (size_t i = 0; i < words.size(); ++i) {
+            std::ostringstream oss;
+            oss << "0x" << std::hex << words[i] << "U";
+            result.push_back(oss.str());
+        }
+        return result;
+    }
+
+    /**
+     * @brief Generates the per-rank exchange used with --mmpi-nonblocking.
+     * @details Receives are posted first, outputs are copied into the persistent send
+     * buffers and started, and only then does the rank block on its inputs. Sends are
+     * completed lazily at the start of the next exchange, so they progress while the
+     * partition evaluates instead of before it. With @p clocked the pair to rank 0 is left
+     * to send_system_outputs_from_rank_<r>(), after eval.
+     */
+    void generateNonBlockingExchange(std::ofstream& outFile, const CommunicationGraph& commGraph,
+                                     const std::set<int>& all_ranks, bool clocked) {
+        outFile << "// --- Non-blocking exchange functions for each rank ---\n\n";
+        for (int r : all_ranks) {
+            if (r == 0) continue;
+            bool receives_anything = false;
+            bool sends_anything = false;
+            for (const auto& [ranks, links] : commGraph) {
+                if (ranks.second == r) receives_anything = true;
+                if (ranks.first == r && !(clocked && ranks.second == 0)) sends_anything = true;
+            }
+            outFile << "void exchange_for_rank_" << r << "(" << m_topParam << ") {\n";
+            if (receives_anything) outFile << "    mpi_start_receives_rank_" << r << "();\n";
+            if (sends_anything) {
+                outFile << "    // The previous sends must be done before their buffers are refilled\n";
+                outFile << "    mpi_wait_sends_rank_" << r << "();\n";
+                for (const auto& [ranks, links] : commGraph) {
+                    if (ranks.first != r || (clocked && ranks.second == 0)) continue;
+                    std::string suffix = std::to_string(r) + "_to_" + std::to_string(ranks.second);
+                    for (const auto& link : links) {
+                        outFile << "    " << portToField("mpi_sendbuf_rank_" + suffix + "." + link.sender_port_name, link.sender_port_name, link.receiver_port_width) << "\n";
+                    }
+                }
+                outFile << "    mpi_start_sends_rank_" << r << "();\n";
+            }
+            if (receives_anything) {
+                outFile << "    mpi_wait_receives_rank_" << r << "();\n";
+                for (const auto& [ranks, links] : commGraph) {
+                    if (ranks.second != r) continue;
+                    std::string suffix = std::to_string(ranks.first) + "_to_" + std::to_string(r);
+                    for (const auto& link : links) {
+                        outFile << "    " << fieldToPort(link.receiver_port_name, "mpi_recvbuf_rank_" + suffix + "." + link.sender_port_name, link.receiver_port_width) << "\n";
+                    }
+                }
+            }
+            generateBroadcastReceives(outFile, r);
+            if (!receives_anything && !sends_anything && !m_broadcastInputs.count(r)) outFile << "    // This rank does not communicate with other partitions.\n";
+            outFile << "}\n\n";
+        }
+    }
+
     /**
      * @brief The core function that generates the standalone C++ main file.
      */
@@ -93,7 +268,18 @@ private:
         const std::map<std::string, PartitionInfo>& partitions,
         const CommunicationGraph& commGraph,
         const std::set<int>& all_ranks,
+        const std::string& boundaryClock,
+        int lookahead,
+        bool nonblocking,
+        bool delta,
+        bool checkpoint,
+        bool prof,
+        int instancesPerRank,
         const std::string& outputDir) {
+        const std::string modelType = "V" + partitionModuleName;
+        m_topParam = modelType + "* top";
+        // Ranks run a single instance unless --mmpi-instances-per-rank says otherwise
+        const bool threaded = instancesPerRank > 1;
 
         std::string outFileName = outputDir + "/" + partitionModuleName + "_main.cpp";
         std::ofstream outFile(outFileName);
@@ -102,20 +288,38 @@ private:
         }
 
         outFile << "// Generated by Metro-MPI\n\n";
-        outFile << "#include <mpi.h>\n";
         outFile << "#include <iostream>\n";
+        if (prof) outFile << "#include <algorithm>\n";
         outFile << "#include <csignal>\n";
+        outFile << "#include <cstring>\n";
         outFile << "#include \"V" << partitionModuleName << ".h\"\n";
         outFile << "#include \"verilated.h\"\n";
+        if (threaded) outFile << "#include \"verilated_threads.h\"\n";
+        outFile << "#include <memory>\n";
+        outFile << "#include <vector>\n";
         outFile << "#include \"metro_mpi.cpp\"\n\n";
 
-        outFile << "static V" << partitionModuleName << "* top = nullptr;\n";
+        outFile << "// Partition ids hosted by this rank, and the model evaluating each of them\n";
+        outFile << "static std::vector<int> local_ids;\n";
+        outFile << "static std::vector<std::unique_ptr<VerilatedContext>> contexts;\n";
+        outFile << "static std::vector<" << modelType << "*> tops;\n";
+        if (threaded) outFile << "static VlThreadPool* pool = nullptr;\n";
         outFile << "static int rank = -1;\n";
+        outFile << "static bool stop_received = false;  // Rank 0 sent its last message\n";
+        if (checkpoint) outFile << "static bool checkpoint_requested = false;  // Rank 0 sent SAVE instead of inputs\n";
         outFile << "static int size = -1;\n\n";
-        outFile << "const int SHUTDOWN_TAG = 299;\n\n";
+        // With delta encoding and no boundary clock the partition is purely driven by its
+        // inputs, so an exchange in which none of them changed needs no eval()
+        const bool skipIdleEval = delta && boundaryClock.empty();
+        if (skipIdleEval) {
+            outFile << "static bool inputs_changed = false;\n";
+            outFile << "static std::vector<bool> eval_pending;  // Per local instance\n\n";
+        }
 
         outFile << "void cleanup(int signum) {\n";
-        outFile << "    if (top) { top->final(); delete top; top = nullptr; }\n";
+        if (threaded) outFile << "    delete pool; pool = nullptr;\n";
+        outFile << "    for (" << modelType << "* top : tops) { top->final(); delete top; }\n";
+        outFile << "    tops.clear();\n";
         outFile << "    mpi_finalize();\n";
         outFile << "    exit(signum);\n";
         outFile << "}\n\n";
@@ -123,20 +327,33 @@ private:
         outFile << "// --- Initialization functions for each partition instance ---\n";
         for (const auto& pair : partitions) {
             const auto& partition = pair.second;
-            outFile << "void initialize_partition_" << partition.instance_name << "() {\n";
+            outFile << "void initialize_partition_" << partition.instance_name << "(" << m_topParam << ") {\n";
             outFile << "    std::cout << \"Initializing partition " << partition.instance_name 
                     << " for Rank " << partition.mpi_rank << "...\" << std::endl;\n";
             for (const auto& port : partition.init_ports) {
-                outFile << "    top->" << port.port_name << " = " << port.init_value << ";\n";
+                if (port.width > 64) {
+                    const auto words = wide_init_words(port.init_value, port.width);
+                    for (size_t i = 0; i < words.size(); ++i) {
+                        outFile << "    top->" << port.port_name << "[" << i << "] = " << words[i] << ";\n";
+                    }
+                } else {
+                    outFile << "    top->" << port.port_name << " = " << verilog_to_cpp_literal(port.init_value) << ";\n";
+                }
             }
             outFile << "}\n\n";
         }
 
-        outFile << "// --- Modular MPI Send/Receive functions for each rank ---\n\n";
+        // With a boundary clock, rank 0 gets the outputs of the edge it just sent the inputs
+        // of, so they are sent after eval. Partitions keep sending to each other first: they
+        // sample each other's outputs of the previous edge, and none waits for another's eval.
+        const bool clocked = !boundaryClock.empty();
+        if (nonblocking) generateNonBlockingExchange(outFile, commGraph, all_ranks, clocked);
+
+        if (!nonblocking) outFile << "// --- Modular MPI Send/Receive functions for each rank ---\n\n";
         for (int r : all_ranks) {
-            if (r == 0) continue;
+            if (r == 0 || nonblocking) continue;
 
-            outFile << "void receive_inputs_for_rank_" << r << "() {\n";
+            outFile << "void receive_inputs_for_rank_" << r << "(" << m_topParam << ") {\n";
             bool receives_anything = false;
             for (const auto& [ranks, links] : commGraph) {
                 if (ranks.second == r) {
@@ -146,83 +363,288 @@ private:
                     outFile << "    // Receive from Rank " << sender << "\n";
                     // *** FIX: Call the new unique receive function name ***
                     outFile << "    " << req_struct_type << " req_from_" << sender << " = mpi_receive_from_rank_" << sender << "_to_" << r << "();\n";
+                    if (checkpoint && sender == 0) {
+                        // The inputs of this exchange, and the other senders' messages, follow the checkpoint
+                        outFile << "    if (req_from_0.metro_mpi_ctrl == METRO_MPI_CTRL_SAVE) {\n";
+                        outFile << "        checkpoint_requested = true;\n";
+                        outFile << "        return;\n";
+                        outFile << "    }\n";
+                    }
                     for (const auto& link : links) {
-                        outFile << "    top->" << link.receiver_port_name << " = req_from_" << sender << "." << link.sender_port_name << ";\n";
+                        outFile << "    " << fieldToPort(link.receiver_port_name, "req_from_" + std::to_string(sender) + "." + link.sender_port_name, link.receiver_port_width) << "\n";
                     }
+                    if (skipIdleEval) outFile << "    inputs_changed |= mpi_changed_rank_" << sender << "_to_" << r << ";\n";
                 }
             }
-            if (!receives_anything) outFile << "    // This rank does not receive data from other partitions.\n";
+            generateBroadcastReceives(outFile, r);
+            if (!receives_anything && !m_broadcastInputs.count(r)) outFile << "    // This rank does not receive data from other partitions.\n";
             outFile << "}\n\n";
 
-            outFile << "void send_outputs_from_rank_" << r << "() {\n";
+            outFile << "void send_outputs_from_rank_" << r << "(" << m_topParam << ") {\n";
             bool sends_anything = false;
             for (const auto& [ranks, links] : commGraph) {
-                if (ranks.first == r) {
+                if (ranks.first == r && !(clocked && ranks.second == 0)) {
                     sends_anything = true;
+                    generateSend(outFile, r, ranks.second, links);
+                }
+            }
+            if (!sends_anything) outFile << "    // This rank does not send data to other partitions.\n";
+            outFile << "}\n\n";
+        }
+        if (clocked) {
+            outFile << "// --- Sends to rank 0 of the outputs after eval ---\n\n";
+            for (int r : all_ranks) {
+                if (r == 0) continue;
+                outFile << "void send_system_outputs_from_rank_" << r << "(" << m_topParam << ") {\n";
+                const auto it = commGraph.find({r, 0});
+                if (it != commGraph.end()) generateSend(outFile, r, 0, it->second);
+                outFile << "}\n\n";
+            }
+        }
+
+        const auto allLatencyInsensitive = [](const std::vector<P2P_Link>& links) {
+            return std::all_of(links.begin(), links.end(),
+                               [](const P2P_Link& link) { return link.latencyInsensitive; });
+        };
+        if (lookahead > 0) {
+            // Priming delays a link by 'lookahead' cycles, so only rank pairs whose outputs
+            // are all annotated latency insensitive are primed: the sender puts that many
+            // copies of its reset outputs in flight, so it can run that many cycles ahead of
+            // the receiver instead of waiting for it every step. Being registered is not
+            // enough, as the extra cycles change what the receiver sees.
+            outFile << "// --- Lookahead priming of latency-insensitive rank pairs ---\n\n";
+            for (int r : all_ranks) {
+                if (r == 0) continue;
+                outFile << "void prime_outputs_from_rank_" << r << "(" << m_topParam << ") {\n";
+                bool primes_anything = false;
+                for (const auto& [ranks, links] : commGraph) {
+                    if (ranks.first != r || !allLatencyInsensitive(links)) continue;
+                    primes_anything = true;
                     int receiver = ranks.second;
                     std::string resp_struct_type = "mpi_rank_" + std::to_string(r) + "_to_" + std::to_string(receiver) + "_t";
-                    outFile << "    // Send to Rank " << receiver << "\n";
+                    outFile << "    // Rank " << receiver << " may lag by up to " << lookahead << " cycles\n";
                     outFile << "    {\n";
                     outFile << "        " << resp_struct_type << " resp_to_" << receiver << "{};\n";
                     for (const auto& link : links) {
-                        outFile << "        resp_to_" << receiver << "." << link.sender_port_name << " = top->" << link.sender_port_name << ";\n";
+                        outFile << "        " << portToField("resp_to_" + std::to_string(receiver) + "." + link.sender_port_name, link.sender_port_name, link.receiver_port_width) << "\n";
                     }
-                    outFile << "        mpi_send_rank_" << r << "_to_" << receiver << "(resp_to_" << receiver << ");\n";
+                    outFile << "        mpi_prime_rank_" << r << "_to_" << receiver << "(resp_to_" << receiver << ", " << lookahead << ");\n";
                     outFile << "    }\n";
                 }
+                if (!primes_anything) outFile << "    // No rank pair of this rank is latency insensitive.\n";
+                outFile << "}\n\n";
             }
-            if (!sends_anything) outFile << "    // This rank does not send data to other partitions.\n";
+        }
+
+        if (checkpoint) {
+            // A checkpoint holds each instance's model and, on primed pairs, the messages
+            // it sent that are still in flight
+            outFile << "// --- Checkpoint of each partition instance ---\n\n";
+            for (int r : all_ranks) {
+                if (r == 0) continue;
+                outFile << "void save_partition_" << r << "(" << m_topParam << ", VerilatedSerialize& os) {\n";
+                outFile << "    os << *top;\n";
+                for (const auto& [ranks, links] : commGraph) {
+                    if (lookahead > 0 && ranks.first == r && allLatencyInsensitive(links)) {
+                        outFile << "    mpi_save_in_flight_rank_" << r << "_to_" << ranks.second << "(os);\n";
+                    }
+                }
+                outFile << "}\n\n";
+                outFile << "void restore_partition_" << r << "(" << m_topParam << ", VerilatedDeserialize& os) {\n";
+                outFile << "    os >> *top;\n";
+                for (const auto& [ranks, links] : commGraph) {
+                    if (lookahead > 0 && ranks.first == r && allLatencyInsensitive(links)) {
+                        outFile << "    mpi_restore_in_flight_rank_" << r << "_to_" << ranks.second << "(os);\n";
+                    }
+                }
+                outFile << "}\n\n";
+            }
+        }
+
+        // Dispatches a per-rank function to the partition id it was generated for
+        auto generateDispatch = [&](const std::string& name, const std::string& prefix,
+                                    const std::string& extraParam = "",
+                                    const std::string& extraArg = "") {
+            outFile << "void " << name << "(int id, " << m_topParam << extraParam << ") {\n";
+            outFile << "    switch (id) {\n";
+            for (int r : all_ranks) {
+                if (r == 0) continue;
+                outFile << "        case " << r << ": " << prefix << r << "(top" << extraArg << "); break;\n";
+            }
+            outFile << "        default: break;\n";
+            outFile << "    }\n";
+            outFile << "}\n\n";
+        };
+        if (nonblocking) {
+            generateDispatch("exchange", "exchange_for_rank_");
+        } else {
+            generateDispatch("send_outputs", "send_outputs_from_rank_");
+            generateDispatch("receive_inputs", "receive_inputs_for_rank_");
+        }
+        if (clocked) generateDispatch("send_system_outputs", "send_system_outputs_from_rank_");
+        if (lookahead > 0) generateDispatch("prime_outputs", "prime_outputs_from_rank_");
+        if (checkpoint) {
+            generateDispatch("save_partition", "save_partition_", ", VerilatedSerialize& os", ", os");
+            generateDispatch("restore_partition", "restore_partition_", ", VerilatedDeserialize& os", ", os");
+
+            outFile << "// Writes every local instance as of its last eval, then waits for the inputs again\n";
+            outFile << "static void save_checkpoint() {\n";
+            outFile << "    MetroMpiSaveBuffer os;\n";
+            outFile << "    for (size_t i = 0; i < tops.size(); ++i) save_partition(local_ids[i], tops[i], os);\n";
+            outFile << "    metro_mpi_write_checkpoint(os.finish());\n";
+            outFile << "    checkpoint_requested = false;\n";
+            outFile << "}\n\n";
+
+            outFile << "// Replaces the reset state by the METRO_MPI_RESTORE checkpoint, if there is one\n";
+            outFile << "static bool restore_checkpoint() {\n";
+            outFile << "    if (!metro_mpi_restore_path()) return false;\n";
+            outFile << "    MetroMpiRestoreBuffer os{metro_mpi_read_checkpoint()};\n";
+            outFile << "    for (size_t i = 0; i < tops.size(); ++i) restore_partition(local_ids[i], tops[i], os);\n";
+            outFile << "    os.finish();\n";
+            outFile << "    std::cout << \"Rank \" << rank << \": Restored from \" << metro_mpi_restore_path() << std::endl;\n";
+            outFile << "    return true;\n";
+            outFile << "}\n\n";
+        }
+
+        outFile << "// Advances one instance by one exchange step\n";
+        outFile << "static void eval_partition(" << m_topParam << ") {\n";
+        if (threaded) {
+            // $finish, $stop and errors go to the context of the current thread, which must
+            // be the instance's own for its metro_mpi_ctrl to see them
+            outFile << "    Verilated::threadContextp(top->contextp());\n";
+        }
+        if (prof) outFile << "    const uint64_t prof_start = mpi_prof_now();\n";
+        if (boundaryClock.empty()) {
+            outFile << "    top->eval();\n";
+        } else {
+            // One exchange per boundary clock cycle: the inputs sampled by rank 0 at the
+            // edge are held for a full local cycle.
+            outFile << "    top->" << boundaryClock << " = 0;\n";
+            outFile << "    top->eval();\n";
+            outFile << "    top->" << boundaryClock << " = 1;\n";
+            outFile << "    top->eval();\n";
+        }
+        if (prof) {
+            // Instances on pool workers each add to their own entry
+            outFile << "    mpi_prof_evals[std::find(tops.begin(), tops.end(), top) - tops.begin()].second\n";
+            outFile << "        += mpi_prof_now() - prof_start;\n";
+        }
+        outFile << "}\n\n";
+
+        if (threaded) {
+            // The main thread does all MPI calls and evaluates the first instance itself;
+            // the others go to one pool worker each
+            outFile << "static void eval_partition_task(VlSelfP selfp, bool) {\n";
+            outFile << "    eval_partition(static_cast<" << modelType << "*>(selfp));\n";
             outFile << "}\n\n";
         }
 
         outFile << "// High-level handler that coordinates the communication cycle\n";
         outFile << "void handle_requests() {\n";
-        outFile << "    switch (rank) {\n";
-        for (int r : all_ranks) {
-            if (r == 0) continue;
-            outFile << "        case " << r << ": {\n";
-            outFile << "            send_outputs_from_rank_" << r << "();\n";
-            // *** FIX: Corrected typo from 'from' to 'for' ***
-            outFile << "            receive_inputs_for_rank_" << r << "();\n";
-            outFile << "            top->eval();\n";
-            outFile << "            break;\n";
-            outFile << "        }\n";
-        }
-        outFile << "        default: break;\n";
-        outFile << "    }\n";
+        if (prof) outFile << "    const uint64_t prof_start = mpi_prof_now();\n";
+        if (nonblocking) {
+            outFile << "    for (size_t i = 0; i < tops.size(); ++i) exchange(local_ids[i], tops[i]);\n";
+        } else {
+            // All outputs to other partitions leave before any input is awaited, so instances
+            // sharing this rank find each other's messages already queued
+            outFile << "    for (size_t i = 0; i < tops.size(); ++i) send_outputs(local_ids[i], tops[i]);\n";
+            // A checkpoint is taken in the middle of the exchange, while every partition
+            // waits for rank 0; what it sent so far is in flight and stays so
+            const std::string indent = checkpoint ? "    " : "";
+            if (checkpoint) {
+                outFile << "    do {\n";
+                outFile << "        if (checkpoint_requested) save_checkpoint();\n";
+            }
+            outFile << indent << "    for (size_t i = 0; i < tops.size(); ++i) {\n";
+            outFile << indent << "        receive_inputs(local_ids[i], tops[i]);\n";
+            if (skipIdleEval) {
+                outFile << indent << "        eval_pending[i] = inputs_changed;\n";
+                outFile << indent << "        inputs_changed = false;\n";
+            }
+            outFile << indent << "    }\n";
+            if (checkpoint) outFile << "    } while (checkpoint_requested);\n";
+        }
+        if (prof) {
+            outFile << "    const uint64_t prof_exchanged = mpi_prof_now();\n";
+            outFile << "    mpi_prof_exchange_ns += prof_exchanged - prof_start;\n";
+            outFile << "    mpi_prof_event(\"exchange\", 1, prof_start, prof_exchanged);\n";
+        }
+        if (threaded) {
+            outFile << "    for (size_t i = 1; i < tops.size(); ++i) {\n";
+            outFile << "        " << (skipIdleEval ? "if (eval_pending[i]) " : "")
+                    << "pool->workerp(i - 1)->addTask(&eval_partition_task, tops[i]);\n";
+            outFile << "    }\n";
+            outFile << "    " << (skipIdleEval ? "if (eval_pending[0]) " : "")
+                    << "eval_partition(tops[0]);\n";
+            outFile << "    for (size_t i = 1; i < tops.size(); ++i) pool->workerp(i - 1)->wait();\n";
+        } else {
+            outFile << "    for (size_t i = 0; i < tops.size(); ++i) "
+                    << (skipIdleEval ? "if (eval_pending[i]) " : "") << "eval_partition(tops[i]);\n";
+        }
+        if (prof) {
+            outFile << "    const uint64_t prof_evaluated = mpi_prof_now();\n";
+            outFile << "    mpi_prof_event(\"eval\", 0, prof_exchanged, prof_evaluated);\n";
+        }
+        if (clocked) {
+            outFile << "    for (size_t i = 0; i < tops.size(); ++i) send_system_outputs(local_ids[i], tops[i]);\n";
+            if (prof) {
+                outFile << "    const uint64_t prof_sent = mpi_prof_now();\n";
+                outFile << "    mpi_prof_exchange_ns += prof_sent - prof_evaluated;\n";
+                outFile << "    mpi_prof_event(\"exchange\", 1, prof_evaluated, prof_sent);\n";
+            }
+        }
+        if (prof) outFile << "    ++mpi_prof_iterations;\n";
         outFile << "}\n\n";
 
         outFile << "int main(int argc, char** argv) {\n";
         outFile << "    mpi_initialize();\n\n";
-        outFile << "    top = new V" << partitionModuleName << ";\n\n";
         outFile << "    rank = getRank();\n";
         outFile << "    size = getSize();\n\n";
         outFile << "    std::cout << \"Partition '" << partitionModuleName << "' is alive on Rank \" << rank << \" of \" << size << std::endl;\n\n";
-        outFile << "    switch (rank) {\n";
+        outFile << "    // Every partition id mapped to this rank gets its own model and context\n";
         for (const auto& pair : partitions) {
             const auto& partition = pair.second;
-            outFile << "        case " << partition.mpi_rank << ": initialize_partition_" << partition.instance_name << "(); break;\n";
-        }
-        outFile << "        default: break;\n";
-        outFile << "    }\n\n";
-        outFile << "    top->eval();\n";
-        outFile << "    MPI_Barrier(MPI_COMM_WORLD);\n\n";
-
-        outFile << "    bool sim_end = false;\n";
-        outFile << "    while (!sim_end) {\n";
-        outFile << "        if (rank != 0) {\n";
-        outFile << "             handle_requests();\n";
-        outFile << "        }\n\n";
-        outFile << "        int shutdown_flag = 0;\n";
-        outFile << "        MPI_Status status;\n";
-        outFile << "        MPI_Iprobe(0, SHUTDOWN_TAG, MPI_COMM_WORLD, &shutdown_flag, &status);\n";
-        outFile << "        if (shutdown_flag) {\n";
-        outFile << "            int dummy;\n";
-        outFile << "            MPI_Recv(&dummy, 1, MPI_INT, 0, SHUTDOWN_TAG, MPI_COMM_WORLD, &status);\n";
-        outFile << "            sim_end = true;\n";
-        outFile << "        }\n";
-        // outFile << "        MPI_Barrier(MPI_COMM_WORLD);\n";    //Removing for now to debug
-        outFile << "    }\n\n";
+            outFile << "    if (mpi_physical_rank(" << partition.mpi_rank << ") == rank) {\n";
+            outFile << "        local_ids.push_back(" << partition.mpi_rank << ");\n";
+            outFile << "        contexts.emplace_back(new VerilatedContext);\n";
+            outFile << "        tops.push_back(new " << modelType << "{contexts.back().get()});\n";
+            outFile << "        initialize_partition_" << partition.instance_name << "(tops.back());\n";
+            if (prof) {
+                outFile << "        mpi_prof_evals.emplace_back(\"" << partition.instance_hier
+                        << "\", 0);\n";
+            }
+            outFile << "    }\n";
+        }
+        if (skipIdleEval) outFile << "    eval_pending.assign(tops.size(), false);\n";
+        if (threaded) {
+            // The pool's context only holds its profiling state; each task switches its
+            // thread to the context of the instance it evaluates
+            outFile << "    if (tops.size() > 1) {\n";
+            outFile << "        pool = new VlThreadPool{contexts.front().get(), static_cast<unsigned>(tops.size() - 1)};\n";
+            outFile << "    }\n";
+        }
+        outFile << "\n";
+        if (threaded) {
+            outFile << "    for (" << modelType << "* top : tops) {\n";
+            outFile << "        Verilated::threadContextp(top->contextp());\n";
+            outFile << "        top->eval();\n";
+            outFile << "    }\n";
+        } else {
+            outFile << "    for (" << modelType << "* top : tops) top->eval();\n";
+        }
+        // A restored job has its in-flight messages back instead of the primed reset outputs
+        if (checkpoint) outFile << "    const bool restored = restore_checkpoint();\n";
+        // No start-up barrier: rank 0 never joins one, and the transport holds every
+        // message until its receiver asks for it
+        outFile << "\n";
+        if (lookahead > 0) {
+            outFile << "    " << (checkpoint ? "if (!restored) " : "")
+                    << "for (size_t i = 0; i < tops.size(); ++i) prime_outputs(local_ids[i], tops[i]);\n\n";
+        }
+
+        // Shutdown arrives inside the regular messages from rank 0, and every partition gets
+        // it in the same exchange, so all messages of that last exchange are still matched
+        outFile << "    while (!stop_received) handle_requests();\n\n";
         outFile << "    std::cout << \"Rank \" << rank << \": Shutting down.\" << std::endl;\n\n";
         outFile << "    cleanup(0);\n";
         outFile << "    return 0;\n";
@@ -232,23 +654,43 @@ private:
 
 public:
     void generate(const std::string& jsonFilePath, const std::string& partitionModuleName) {
-        std::string outputDir = "metro_mpi";
         std::ifstream inputFile(jsonFilePath);
         if (!inputFile.is_open()) {
             std::cerr << "Error [MPIMainGenerator]: Could not open file " << jsonFilePath << std::endl;
             return;
         }
+        json data;
+        try {
+            data = json::parse(inputFile);
+        } catch (const std::exception& e) {
+            std::cerr << "An error occurred in MPIMainGenerator: " << e.what() << std::endl;
+            return;
+        }
+        generateFromReport(data, partitionModuleName);
+    }
 
+    // Same as generate(), from the analysis held in memory
+    void generateFromReport(const json& data, const std::string& partitionModuleName) {
+        std::string outputDir = "metro_mpi";
+        m_broadcastInputs.clear();
         try {
-            json data = json::parse(inputFile);
             std::map<std::string, PartitionInfo> partitions;
             CommunicationGraph commGraph;
             std::set<std::tuple<int, int, std::string, std::string>> processed_physical_links;
             std::set<int> all_ranks;
+            const json config = data.value("config", json::object());
 
             for (auto const& [instanceName, ports] : data["partitions"].items()) {
+                // Partitions of other modules are built from their own main file
+                if (!ports.empty()
+                    && ports.front().value("partition_module", partitionModuleName)
+                           != partitionModuleName) {
+                    continue;
+                }
                 PartitionInfo currentPartition;
                 currentPartition.instance_name = instanceName;
+                currentPartition.instance_hier = ports.empty() ? "" : ports.front().value(
+                    "instance_hier", config.value("parent_hier", "") + "." + instanceName);
                 bool rank_found = false;
                 for (const auto& port_json : ports) {
                     if (!rank_found) {
@@ -258,15 +700,21 @@ public:
                     if (port_json["type"] == "init") {
                         currentPartition.init_ports.push_back({
                             port_json["port_name"],
-                            verilog_to_cpp_literal(port_json["connecting_wire"])
+                            port_json["connecting_wire"],
+                            port_json["width"].get<int>()
                         });
                     }
                     all_ranks.insert(port_json["mpi_rank"].get<int>());
+                    const int bcastGroup = port_json.value("bcast_group", -1);
+                    if (bcastGroup >= 0) {
+                        m_broadcastInputs[currentPartition.mpi_rank].push_back(
+                            {bcastGroup, port_json["port_name"], port_json["width"].get<int>()});
+                        continue;
+                    }
                     if (port_json["active"] == "Yes") {
                         for (const auto& commPartner : port_json["with_whom_is_it_communicating"]) {
                             int current_rank = port_json["mpi_rank"].get<int>();
                             int partner_rank = commPartner["mpi_rank"].get<int>();
-                            all_ranks.insert(partner_rank);
                             std::string current_port_name = port_json["port_name"];
                             std::string partner_port_name = commPartner["port"];
                             auto key = (current_rank < partner_rank) ? 
@@ -276,20 +724,36 @@ public:
                             processed_physical_links.insert(key);
                             P2P_Link new_link;
                             if (port_json["direction"] == "in" || port_json["direction"] == "Input") {
-                                new_link = {instanceName, current_rank, current_port_name, port_json["width"].get<int>(), commPartner["instance"], partner_rank, partner_port_name};
+                                const bool insensitive = commPartner.value("latency_insensitive", "No") == "Yes";
+                                new_link = {instanceName, current_rank, current_port_name, port_json["width"].get<int>(), commPartner["instance"], partner_rank, partner_port_name, insensitive};
                             } else { 
-                                new_link = {commPartner["instance"], partner_rank, partner_port_name, port_json["width"].get<int>(), instanceName, current_rank, current_port_name};
+                                const bool insensitive = port_json.value("latency_insensitive", "No") == "Yes";
+                                new_link = {commPartner["instance"], partner_rank, partner_port_name, port_json["width"].get<int>(), instanceName, current_rank, current_port_name, insensitive};
                             }
                             commGraph[{new_link.sender_rank, new_link.receiver_rank}].push_back(new_link);
                         }
                     }
                 }
                 partitions[instanceName] = currentPartition;
+                // Control field of the pairs to and from rank 0, see MPICodeGenerator.
+                // It is constant while priming, so it does not stop lookahead.
+                if (rank_found) {
+                    const int rank = currentPartition.mpi_rank;
+                    commGraph[{0, rank}].push_back({instanceName, rank, "metro_mpi_ctrl", 2, "system", 0, "metro_mpi_ctrl", true});
+                    commGraph[{rank, 0}].push_back({"system", 0, "metro_mpi_ctrl", 2, instanceName, rank, "metro_mpi_ctrl", true});
+                }
             }
             if (partitions.empty()) {
                 throw std::runtime_error("No partitions found in the JSON file.");
             }
-            generateStandaloneMain(partitionModuleName, partitions, commGraph, all_ranks, outputDir);
+            generateStandaloneMain(partitionModuleName, partitions, commGraph, all_ranks,
+                                   config.value("boundary_clock", ""),
+                                   config.value("lookahead", 0),
+                                   config.value("nonblocking", false),
+                                   config.value("delta", false),
+                                   config.value("checkpoint", false),
+                                   config.value("prof", false),
+                                   config.value("instances_per_rank", 1), outputDir);
         } catch (const std::exception& e) {
             std::cerr << "An error occurred in MPIMainGenerator: " << e.what() << std::endl;
             return;
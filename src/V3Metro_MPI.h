@@ -6,22 +6,27 @@
 
 #include "V3Ast.h"
 #include "V3AstNodeOther.h"
-#include "V3Blake2b.h"
+#include "V3File.h"
+#include "V3InstrCount.h"
 #include "V3MMPI_Include.h"
 #include "V3MMPI_Makefile.h"
 #include "V3MMPI_Verilog.h"
 #include "V3MMPI_main_rank_0.h"
 #include "V3MMPI_partition_sim.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <queue>
 #include <set>
 #include <sstream>
 #include <stack>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <sys/stat.h>
@@ -104,6 +109,95 @@ static AstVar* findVarInModule(AstNodeModule* scope, const std::string& name) VL
     return foundVar;
 }
 
+/**
+ * @brief Checks whether a variable of a module is driven directly by a flop.
+ * @details The variable counts as registered when every write of it is a non-blocking
+ * assignment of the whole variable (`q <= d`) inside an edge-sensitive `always` block, or
+ * when it is continuously assigned from another variable that is (`assign out = q;`).
+ * Reads of the variable, e.g. as an index on the left-hand side, are not writes. Anything
+ * else, including a part-select write or a port driven by a sub-instance, is conservatively
+ * treated as combinational.
+ * @param modp The module in which the variable is declared.
+ * @param name The name of the variable (usually an output port).
+ * @param maxDepth The maximum number of `assign` aliases to follow.
+ * @return True if every driver of the variable is a flop.
+ */
+static bool isRegisteredVar(AstNodeModule* modp, const std::string& name,
+                            int maxDepth = 5) VL_MT_DISABLED {
+    if (!modp || maxDepth <= 0) return false;
+    std::unordered_set<const AstAssignDly*> clockedAssigns;
+    modp->foreach([&](const AstAlways* alwaysp) {
+        if (!alwaysp->sensesp() || !alwaysp->sensesp()->hasClocked()) return;
+        alwaysp->foreach(
+            [&](const AstAssignDly* assignp) { clockedAssigns.insert(assignp); });
+    });
+    bool sawDelayed = false;
+    bool sawOther = false;
+    std::string aliasName;
+    modp->foreach([&](AstNodeAssign* assignp) {
+        bool writesVar = false;
+        assignp->lhsp()->foreach([&](const AstVarRef* refp) {
+            if (refp->name() == name && refp->access().isWriteOrRW()) writesVar = true;
+        });
+        if (!writesVar) return;
+        const AstVarRef* const lhsRefp = VN_CAST(assignp->lhsp(), VarRef);
+        const AstAssignDly* const dlyp = VN_CAST(assignp, AssignDly);
+        if (dlyp && lhsRefp && clockedAssigns.count(dlyp)) {
+            sawDelayed = true;
+        } else if (VN_IS(assignp, AssignW) && lhsRefp && VN_IS(assignp->rhsp(), VarRef)
+                   && aliasName.empty()) {
+            aliasName = VN_AS(assignp->rhsp(), VarRef)->name();
+        } else {
+            sawOther = true;
+        }
+    });
+    if (sawOther || (sawDelayed && !aliasName.empty())) return false;
+    if (sawDelayed) return true;
+    if (!aliasName.empty()) return isRegisteredVar(modp, aliasName, maxDepth - 1);
+    return false;
+}
+
+/**
+ * @struct MetroMpiConfig
+ * @brief Code generation options shared by the Metro-MPI generators.
+ * @details Filled from the command line and written into the "config" section of the
+ * partition report (PartitionPortAnalyzer::toJson), which is where the generators read it
+ * back from.
+ */
+struct MetroMpiConfig {
+    ///< Partition clock port sampled once per posedge (--mmpi-clock). Empty keeps the
+    ///< combinational exchange, where every change of a boundary signal is a round-trip.
+    std::string boundaryClock;
+    ///< Number of messages partitions may run ahead of their receivers on rank pairs whose
+    ///< ports are all annotated latency insensitive (--mmpi-lookahead). Zero keeps the
+    ///< lockstep exchange.
+    int lookahead = 0;
+    ///< Partition outputs, as <module>.<port>, whose consumers tolerate extra cycles of
+    ///< latency, so their links may be primed for lookahead (--mmpi-latency-insensitive).
+    std::set<std::string> latencyInsensitive;
+    ///< Use persistent non-blocking requests on partition ranks (--mmpi-nonblocking).
+    bool nonblocking = false;
+    ///< Bit-pack each rank pair's message into a dense word buffer (--mmpi-pack).
+    bool pack = false;
+    ///< Send only the fields that changed since the previous message (--mmpi-delta).
+    bool delta = false;
+    ///< Generate the coordinated checkpoint and restore of all ranks (--mmpi-checkpoint).
+    bool checkpoint = false;
+    ///< Record eval and communication time on every rank, reported at shutdown (--mmpi-prof).
+    bool prof = false;
+    ///< Hierarchical name of the module holding the partitions; the profile names
+    ///< instances with it, as --mmpi-profile expects. Each partition's ports also carry
+    ///< their instance's full name, as a cut may span several parents.
+    std::string parentHier;
+    ///< Partition instances packed into one MPI process, exchanging through memory and
+    ///< evaluated on a thread pool (--mmpi-instances-per-rank).
+    int instancesPerRank = 1;
+    ///< MPI ranks launched on each node (--mmpi-ranks-per-node). Partitions are placed so
+    ///< that most traffic stays within a node; zero only keeps talking partitions on
+    ///< nearby ranks.
+    int ranksPerNode = 0;
+};
+
 /**
  * @class PartitionPortAnalyzer
  * @brief Performs a detailed analysis of the ports of specified partition instances.
@@ -123,6 +217,8 @@ public:
         std::string port;
         std::string mpi_process;
         int mpi_rank = -1;  // NEW: Added rank for the communication partner
+        bool registered = false;  ///< True if the partner port is a flop-driven output.
+        bool latencyInsensitive = false;  ///< True if the partner port is annotated so.
     };
     /**
      * @struct Port
@@ -140,6 +236,10 @@ public:
         std::string mpi_process = "idk";  ///< The target MPI process for communication.
         int mpi_rank = -1;  // NEW: Added rank for this port's own process
         std::string comm_type = "idk";  //communication type
+        bool registered = false;  ///< True if this is an output driven directly by a flop.
+        ///< True if this output is annotated with --mmpi-latency-insensitive.
+        bool latencyInsensitive = false;
+        int bcast_group = -1;  ///< Rank 0 fan-out this input is broadcast in, or -1.
 
         // MODIFIED: Changed to a vector of the new struct.
         std::vector<CommunicationPartner>
@@ -211,6 +311,7 @@ private:
     AstNodeModule* m_parentModule;  ///< AST node of the module containing the partitions.
     const std::vector<std::string>& m_partitionInstances;  ///< List of instance names to analyze.
     std::string m_parentModuleName;  ///< Name of the parent module.
+    MetroMpiConfig m_config;  ///< Code generation options, echoed into the JSON report.
 
     ///< Maps an instance name to a vector of its analyzed ports.
     std::map<std::string, std::vector<Port>> m_partitionData;
@@ -219,12 +320,22 @@ private:
     std::map<std::string, std::vector<std::pair<std::string, std::string>>> m_wireToEndpoints;
     ///< Maps a wire name (LHS) to the wire it is driven by (RHS) to trace chained assignments.
     std::map<std::string, std::string> m_wireAliasMap;
+    ///< Memoized resolveWireChain() results; ports on one net share the walk of its chain.
+    std::unordered_map<std::string, std::string> m_resolvedWires;
     ///< Maps an MPI process name ("system" or instance name) to a unique integer rank.
     std::map<std::string, int> m_mpiRankMap;
+    ///< Original module name of each instance in the parent; ranks are grouped by it.
+    std::map<std::string, std::string> m_instanceModule;
     // ================== Fix: it doesn't know about the i/o ports of the non-partition modules
     // inside parent module ================== This map will store a pointer to the AST definition
     // for EVERY instance in the parent.
     std::map<std::string, AstNodeModule*> m_instanceToModulePtr;
+    ///< --mmpi-latency-insensitive annotations that matched a partition output
+    std::set<std::string> m_annotatedFound;
+    ///< First partition id after this parent's, aligned to a fresh rank.
+    int m_nextRank = 1;
+    ///< Prepended to the instance names to make the process names of a cut unique.
+    std::string m_processPrefix;
 
     /**
      * @class PortGatherVisitor
@@ -341,6 +452,14 @@ private:
                 if (AstVar* varp = findVarInModule(partitionModule, p.name)) {
                     p.direction = varp->direction().xmlKwd();
                     p.width = getDTypeWidth(varp->dtypep());
+                    if (varp->direction() == VDirection::OUTPUT) {
+                        p.registered = isRegisteredVar(partitionModule, p.name);
+                        const std::string key = partitionModule->origName() + "." + p.name;
+                        if (m_analyzer->m_config.latencyInsensitive.count(key)) {
+                            p.latencyInsensitive = true;
+                            m_analyzer->m_annotatedFound.insert(key);
+                        }
+                    }
                 }
 
                 // Determine what the port is connected to.
@@ -431,30 +550,15 @@ private:
     }
 
     /**
-     * @brief Escapes special characters in a string for JSON compatibility.
-     * @param s The input string.
-     * @return The escaped string.
+     * @brief resolveWireChain() from a port's wire, computed once per wire.
+     * @details Only valid once m_wireAliasMap is complete, i.e. after the gather phase.
      */
-    std::string jsonEscape(const std::string& s) {
-        std::stringstream o;
-        for (auto c = s.cbegin(); c != s.cend(); c++) {
-            switch (*c) {
-            case '"': o << "\\\""; break;
-            case '\\': o << "\\\\"; break;
-            case '\b': o << "\\b"; break;
-            case '\f': o << "\\f"; break;
-            case '\n': o << "\\n"; break;
-            case '\r': o << "\\r"; break;
-            case '\t': o << "\\t"; break;
-            default:
-                if ('\x00' <= *c && *c <= '\x1f') {
-                    o << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)*c;
-                } else {
-                    o << *c;
-                }
-            }
-        }
-        return o.str();
+    const std::string& resolveWire(const std::string& wireName) {
+        const auto it = m_resolvedWires.find(wireName);
+        if (it != m_resolvedWires.end()) return it->second;
+        std::set<std::string> visited;
+        return m_resolvedWires.emplace(wireName, resolveWireChain(wireName, visited))
+            .first->second;
     }
 
     // ================== NEW HELPER FUNCTION START ==================
@@ -512,16 +616,51 @@ private:
     }
     // =================== NEW HELPER FUNCTION END ===================
 
+    /**
+     * @brief Tells whether a port of an analyzed partition is a registered output.
+     * @return False for ports of non-partition instances and of the parent module, whose
+     * drivers are not analyzed.
+     */
+    bool isRegisteredPort(const std::string& instanceName, const std::string& portName) const {
+        const Port* const portp = findPartitionPort(instanceName, portName);
+        return portp && portp->registered;
+    }
+
+    /**
+     * @brief Tells whether a port of an analyzed partition is annotated latency insensitive.
+     * @return False for ports of non-partition instances and of the parent module.
+     */
+    bool isLatencyInsensitivePort(const std::string& instanceName,
+                                  const std::string& portName) const {
+        const Port* const portp = findPartitionPort(instanceName, portName);
+        return portp && portp->latencyInsensitive;
+    }
+
+    const Port* findPartitionPort(const std::string& instanceName,
+                                  const std::string& portName) const {
+        const auto inst_it = m_partitionData.find(instanceName);
+        if (inst_it == m_partitionData.end()) return nullptr;
+        for (const auto& p : inst_it->second) {
+            if (p.name == portName) return &p;
+        }
+        return nullptr;
+    }
+
 public:
     /**
      * @brief Constructor for the PartitionPortAnalyzer.
      * @param parentModule AST node of the module containing the partition instances.
      * @param partitionInstances A vector of strings with the names of the instances to analyze.
+     * @param config Code generation options.
+     * @param firstRank Partition id of the first instance; a cut under several parents
+     * numbers each parent's partitions after the previous parent's.
      */
     PartitionPortAnalyzer(AstNodeModule* parentModule,
-                          std::vector<std::string>& partitionInstances)  // Note: non-const now
+                          std::vector<std::string>& partitionInstances,  // Note: non-const now
+                          const MetroMpiConfig& config, int firstRank = 1)
         : m_parentModule(parentModule)
-        , m_partitionInstances(partitionInstances) {
+        , m_partitionInstances(partitionInstances)
+        , m_config(config) {
         m_parentModuleName = parentModule->name();
 
         // --- NEW: Create the MPI Rank Map ---
@@ -531,11 +670,33 @@ public:
         // Sort partition names to ensure deterministic rank assignment.
         std::sort(partitionInstances.begin(), partitionInstances.end());
 
+        // With several instances per rank, the ids below are partition ids and id N runs
+        // on MPI rank 1 + (N - 1) / instancesPerRank. An MPI process runs a single module,
+        // so instances are grouped by module and each module starts on a fresh rank.
+        for (AstNode* nodep = parentModule->stmtsp(); nodep; nodep = nodep->nextp()) {
+            if (const AstCell* cellp = VN_CAST(nodep, Cell)) {
+                m_instanceModule[cellp->name()] = cellp->modp()->origName();
+            }
+        }
+        std::stable_sort(partitionInstances.begin(), partitionInstances.end(),
+                         [&](const std::string& a, const std::string& b) {
+                             return m_instanceModule[a] < m_instanceModule[b];
+                         });
+
         // Assign ranks 1, 2, 3... to the sorted partition instances.
-        int currentRank = 1;
+        const int perRank = std::max(1, m_config.instancesPerRank);
+        int currentRank = firstRank;
+        std::string lastModule;
         for (const auto& instName : m_partitionInstances) {
+            const std::string& module = m_instanceModule[instName];
+            if (!lastModule.empty() && module != lastModule) {
+                while ((currentRank - 1) % perRank != 0) ++currentRank;
+            }
+            lastModule = module;
             m_mpiRankMap[instName] = currentRank++;
         }
+        while ((currentRank - 1) % perRank != 0) ++currentRank;
+        m_nextRank = currentRank;
     }
 
     /**
@@ -577,16 +738,22 @@ public:
         });
         PortGatherVisitor gatherer(this, m_parentModule);
         gatherer.iterateConst(m_parentModule);
+        for (const std::string& key : m_config.latencyInsensitive) {
+            if (!m_annotatedFound.count(key)) {
+                std::cerr << "  --> WARNING: --mmpi-latency-insensitive '" << key
+                          << "' is not an output of a partition module; ignored.\n";
+            }
+        }
 
         // === Main Analysis Loop (Combines preliminary processing for each port) ===
+        bool boundaryClockFound = false;
         for (auto& inst_pair : m_partitionData) {
             for (auto& port : inst_pair.second) {
 
                 // --- Step 2.1: Resolve wire chains for the current port ---
                 if (port.type == "wire") {
-                    std::set<std::string> visitedWires;
-                    std::string initialWire = port.other_end;
-                    std::string finalWire = resolveWireChain(initialWire, visitedWires);
+                    const std::string initialWire = port.other_end;
+                    const std::string& finalWire = resolveWire(initialWire);
                     if (initialWire != finalWire) {
                         port.other_end = finalWire;
                         auto& initialEndpoints = m_wireToEndpoints[initialWire];
@@ -660,7 +827,8 @@ public:
                         int partner_mpi_rank = m_mpiRankMap[partner_mpi_process];
                         port.with_whom_is_it_communicating.push_back(
                             {endpoint.first, remote_port_name, partner_mpi_process,
-                             partner_mpi_rank});
+                             partner_mpi_rank, isRegisteredPort(endpoint.first, endpoint.second),
+                             isLatencyInsensitivePort(endpoint.first, endpoint.second)});
                     }
                 }
 
@@ -678,8 +846,23 @@ public:
                 if (port.active == "idk") {
                     port.active = port.with_whom_is_it_communicating.empty() ? "No" : "Yes";
                 }
+                // The boundary clock is regenerated locally by every partition, so it is
+                // never carried in a message.
+                if (!m_config.boundaryClock.empty() && port.name == m_config.boundaryClock) {
+                    port.comm_type = "clock";
+                    port.active = "No";
+                    boundaryClockFound = true;
+                }
             }
         }
+        if (!m_config.boundaryClock.empty() && !boundaryClockFound) {
+            std::cerr << "  --> WARNING: Boundary clock '" << m_config.boundaryClock
+                      << "' is not a port of the partition; using combinational exchange.\n";
+            m_config.boundaryClock.clear();
+        }
+
+        // === PHASE 2b: Topology-aware rank placement ===
+        placeRanks();
 
         // === PHASE 3: Global Name Disambiguation ===
         std::map<std::pair<int, int>, std::vector<std::pair<CommunicationPartner*, Port*>>>
@@ -717,13 +900,167 @@ public:
                 }
             }
         }
+
+        // === PHASE 4: Rank 0 fan-out ===
+        // A parent wire feeding the inputs of several partitions is broadcast once by rank 0
+        // instead of being copied into every partition's message. Only the cycle-batched
+        // exchange calls each partition's DPI exactly once per cycle, which is what lets
+        // all members join the same collective in the same order.
+        if (!m_config.boundaryClock.empty() && m_config.instancesPerRank == 1) {
+            std::map<std::string, std::vector<Port*>> systemFanout;
+            for (auto& inst_pair : m_partitionData) {
+                for (auto& port : inst_pair.second) {
+                    if (port.active != "Yes" || port.direction != "Input") continue;
+                    if (port.with_whom_is_it_communicating.size() != 1) continue;
+                    if (port.with_whom_is_it_communicating.front().mpi_rank != 0) continue;
+                    systemFanout[port.other_end].push_back(&port);
+                }
+            }
+            int nextGroup = 0;
+            for (auto& wire_ports : systemFanout) {
+                const std::vector<Port*>& members = wire_ports.second;
+                if (members.size() < 2) continue;
+                for (Port* portp : members) portp->bcast_group = nextGroup;
+                ++nextGroup;
+            }
+            if (nextGroup) {
+                std::cout << "  --> " << nextGroup << " rank 0 fan-out signal(s) will be broadcast\n";
+            }
+        }
     }
 
+    /**
+     * @brief Renumbers the partitions so that those exchanging the most bits share a node.
+     * @details The constructor's ids only follow instance names. Here, within each module's
+     * block of ids, a node is filled greedily: the next id goes to the partition with the
+     * most traffic to the partitions already on the node, and rank 0 counts as being on the
+     * first node. Ranks are laid out on nodes in order (by-slot mapping, or the rankfile
+     * written for --mmpi-ranks-per-node). Without a node size, the node is everything
+     * placed so far, which still keeps neighbors on nearby ranks. Ties keep name order, so
+     * partitions that do not talk to each other keep their ids.
+     */
+    void placeRanks() {
+        // Bits per exchange between two processes, in both directions
+        std::map<std::string, std::map<std::string, uint64_t>> traffic;
+        for (const auto& [inst, ports] : m_partitionData) {
+            for (const auto& port : ports) {
+                if (port.active != "Yes") continue;
+                for (const auto& partner : port.with_whom_is_it_communicating) {
+                    if (partner.mpi_process == inst) continue;
+                    traffic[inst][partner.mpi_process] += port.width;
+                    traffic[partner.mpi_process][inst] += port.width;
+                }
+            }
+        }
+
+        const int perRank = std::max(1, m_config.instancesPerRank);
+        const int perNode = m_config.ranksPerNode;
+        const auto nodeOf = [&](int id) {
+            return perNode && id ? (1 + (id - 1) / perRank) / perNode : 0;
+        };
+        // Node crossing traffic of the current numbering, to report the gain
+        const auto crossNode = [&]() {
+            uint64_t bits = 0;
+            for (const auto& [a, peers] : traffic) {
+                for (const auto& [b, w] : peers) {
+                    if (a < b && nodeOf(m_mpiRankMap[a]) != nodeOf(m_mpiRankMap[b])) bits += w;
+                }
+            }
+            return bits;
+        };
+        const uint64_t crossBefore = crossNode();
+
+        std::map<std::string, uint64_t> nodeScore;  // Traffic to the node being filled
+        std::map<std::string, uint64_t> placedScore;  // Traffic to everything placed
+        const auto place = [&](const std::string& inst) {
+            for (const auto& [peer, w] : traffic[inst]) {
+                nodeScore[peer] += w;
+                placedScore[peer] += w;
+            }
+        };
+        // Rank 0 only attracts partitions to its node when there are nodes
+        if (perNode) place("system");
+
+        int id = 1;
+        int node = 0;
+        for (size_t first = 0; first < m_partitionInstances.size();) {
+            // Same module blocks, and alignment, as the constructor
+            const std::string& module = m_instanceModule[m_partitionInstances[first]];
+            size_t last = first;
+            while (last < m_partitionInstances.size()
+                   && m_instanceModule[m_partitionInstances[last]] == module) {
+                ++last;
+            }
+            id = m_mpiRankMap[m_partitionInstances[first]];
+            std::vector<std::string> remaining(m_partitionInstances.begin() + first,
+                                               m_partitionInstances.begin() + last);
+            while (!remaining.empty()) {
+                if (nodeOf(id) != node) {
+                    node = nodeOf(id);
+                    nodeScore.clear();
+                }
+                auto best = remaining.begin();
+                for (auto it = remaining.begin(); it != remaining.end(); ++it) {
+                    if (std::make_pair(nodeScore[*it], placedScore[*it])
+                        > std::make_pair(nodeScore[*best], placedScore[*best])) {
+                        best = it;
+                    }
+                }
+                m_mpiRankMap[*best] = id++;
+                place(*best);
+                remaining.erase(best);
+            }
+            first = last;
+        }
+
+        for (auto& [inst, ports] : m_partitionData) {
+            for (auto& port : ports) {
+                port.mpi_rank = m_mpiRankMap[port.mpi_process];
+                for (auto& partner : port.with_whom_is_it_communicating) {
+                    partner.mpi_rank = m_mpiRankMap[partner.mpi_process];
+                }
+            }
+        }
+        if (perNode) {
+            std::cout << "  --> Rank placement: " << crossNode() << " of the bits exchanged per "
+                      << "cycle cross nodes (" << crossBefore << " in name order)\n";
+        }
+    }
+
+    /**
+     * @brief Prefixes the process names, once analyze() has run.
+     * @details Instances under different parents may share a name, and a process name
+     * also names the partition's wrapper and generated functions.
+     */
+    void prefixProcessNames(const std::string& prefix) {
+        if (prefix.empty()) return;
+        m_processPrefix = prefix;
+        std::map<std::string, std::vector<Port>> renamed;
+        for (auto& [inst, ports] : m_partitionData) {
+            for (auto& port : ports) {
+                port.mpi_process = prefix + port.mpi_process;
+                for (auto& partner : port.with_whom_is_it_communicating) {
+                    if (partner.mpi_process == "system") continue;
+                    partner.instance = prefix + partner.instance;
+                    partner.mpi_process = prefix + partner.mpi_process;
+                }
+            }
+            renamed[prefix + inst] = std::move(ports);
+        }
+        m_partitionData = std::move(renamed);
+    }
+
+    // First partition id free for the partitions of another parent.
+    int nextRank() const { return m_nextRank; }
+
     // A public getter to provide access to the analysis results.
     const std::map<std::string, std::vector<Port>>& getPartitionData() const {
         return m_partitionData;
     }
 
+    // The effective configuration, after options that do not apply were dropped.
+    const MetroMpiConfig& getConfig() const { return m_config; }
+
     /**
      * @brief Prints a formatted report of the analysis results to standard output.
      */
@@ -755,73 +1092,74 @@ public:
     }
 
     /**
-     * @brief Writes the analysis results to a JSON file.
+     * @brief Builds the analysis results in the layout of partition_report.json.
+     * @details The generators take this object directly; the file is only a dump of it.
+     */
+    json toJson() const {
+        json report;
+        report["config"] = {{"boundary_clock", m_config.boundaryClock},
+                            {"lookahead", m_config.lookahead},
+                            {"nonblocking", m_config.nonblocking},
+                            {"pack", m_config.pack},
+                            {"delta", m_config.delta},
+                            {"checkpoint", m_config.checkpoint},
+                            {"prof", m_config.prof},
+                            {"parent_hier", m_config.parentHier},
+                            {"instances_per_rank", m_config.instancesPerRank},
+                            {"ranks_per_node", m_config.ranksPerNode}};
+        json& partitions = report["partitions"] = json::object();
+        for (const auto& [inst_name, ports] : m_partitionData) {
+            const std::string localName = inst_name.substr(m_processPrefix.size());
+            const auto modIt = m_instanceToModulePtr.find(localName);
+            const std::string partitionModule
+                = modIt != m_instanceToModulePtr.end() ? modIt->second->origName() : "";
+            const std::string instanceHier = m_config.parentHier + "." + localName;
+            json& portsJson = partitions[inst_name] = json::array();
+            for (const auto& port : ports) {
+                json partners = json::array();
+                for (const auto& partner : port.with_whom_is_it_communicating) {
+                    partners.push_back({{"instance", partner.instance},
+                                        {"port", partner.port},
+                                        {"mpi_process", partner.mpi_process},
+                                        {"mpi_rank", partner.mpi_rank},
+                                        {"registered", partner.registered ? "Yes" : "No"},
+                                        {"latency_insensitive",
+                                         partner.latencyInsensitive ? "Yes" : "No"}});
+                }
+                portsJson.push_back({{"port_name", port.name},
+                                     {"direction", port.direction},
+                                     {"width", port.width},
+                                     {"active", port.active},
+                                     {"type", port.type},
+                                     {"connecting_wire", port.other_end},
+                                     {"mpi_process", port.mpi_process},
+                                     {"mpi_rank", port.mpi_rank},
+                                     {"partition_module", partitionModule},
+                                     {"instance_hier", instanceHier},
+                                     {"Comm", port.comm_type},
+                                     {"registered", port.registered ? "Yes" : "No"},
+                                     {"latency_insensitive",
+                                      port.latencyInsensitive ? "Yes" : "No"},
+                                     {"bcast_group", port.bcast_group},
+                                     {"with_whom_is_it_communicating", std::move(partners)}});
+            }
+        }
+        return report;
+    }
+
+    /**
+     * @brief Writes the analysis results to a JSON file (--mmpi-report).
+     * @param report The toJson() result the generators were given.
      * @param filename The name of the output JSON file.
      */
-    void writeJsonReport(const std::string& filename) {
+    static void writeJsonReport(const json& report, const std::string& filename) {
         std::ofstream jsonFile(filename);
         if (!jsonFile.is_open()) {
             std::cerr << "Error: Could not open file for writing JSON report: " << filename
                       << std::endl;
             return;
         }
-
-        jsonFile << "{\n";
-        jsonFile << "  \"partitions\": {\n";
-
-        for (auto it = m_partitionData.begin(); it != m_partitionData.end(); ++it) {
-            const std::string& inst_name = it->first;
-            const std::vector<Port>& ports = it->second;
-
-            jsonFile << "    \"" << jsonEscape(inst_name) << "\": [\n";
-
-            for (auto port_it = ports.begin(); port_it != ports.end(); ++port_it) {
-                const auto& port = *port_it;
-                jsonFile << "      {\n";
-                jsonFile << "        \"port_name\": \"" << jsonEscape(port.name) << "\",\n";
-                jsonFile << "        \"direction\": \"" << jsonEscape(port.direction) << "\",\n";
-                jsonFile << "        \"width\": " << port.width << ",\n";
-                jsonFile << "        \"active\": \"" << jsonEscape(port.active) << "\",\n";
-                jsonFile << "        \"type\": \"" << jsonEscape(port.type) << "\",\n";
-                jsonFile << "        \"connecting_wire\": \"" << jsonEscape(port.other_end)
-                         << "\",\n";
-                // MODIFIED: This field now correctly represents this port's own MPI process
-                jsonFile << "        \"mpi_process\": \"" << jsonEscape(port.mpi_process)
-                         << "\",\n";
-
-                jsonFile << "        \"mpi_rank\": " << port.mpi_rank << ",\n";
-                jsonFile << "        \"Comm\": \"" << jsonEscape(port.comm_type) << "\",\n";
-                jsonFile << "        \"with_whom_is_it_communicating\": [";
-
-                // MODIFIED: Generate an array of JSON objects with the new mpi_process field
-                for (auto comm_it = port.with_whom_is_it_communicating.begin();
-                     comm_it != port.with_whom_is_it_communicating.end(); ++comm_it) {
-                    jsonFile << "{";
-                    jsonFile << "\"instance\": \"" << jsonEscape(comm_it->instance) << "\", ";
-                    jsonFile << "\"port\": \"" << jsonEscape(comm_it->port) << "\", ";
-                    jsonFile << "\"mpi_process\": \"" << jsonEscape(comm_it->mpi_process)
-                             << "\", ";
-                    jsonFile << "\"mpi_rank\": " << comm_it->mpi_rank;
-                    jsonFile << "}";
-                    if (std::next(comm_it) != port.with_whom_is_it_communicating.end()) {
-                        jsonFile << ", ";
-                    }
-                }
-                // END OF MODIFICATION
-
-                jsonFile << "]\n";
-                jsonFile << "      }";
-                if (std::next(port_it) != ports.end()) { jsonFile << ","; }
-                jsonFile << "\n";
-            }
-
-            jsonFile << "    ]";
-            if (std::next(it) != m_partitionData.end()) { jsonFile << ","; }
-            jsonFile << "\n";
-        }
-        jsonFile << "  }\n";
-        jsonFile << "}\n";
-
+        jsonFile << report.dump(2) << "\n";
         jsonFile.close();
         std::cout << "Successfully wrote JSON report to " << filename << "\n";
     }
@@ -923,16 +1261,14 @@ class HierCellsGraphVisitor final : public VNVisitorConst {
         std::string instanceName;
         std::string hierInstance;
         std::string hierModule;
-        std::string hash;
-        int weight;
+        uint64_t weight;  // Estimated eval cost of the instance and everything below it
         ModNode() = default;
         ModNode(const std::string& mod, const std::string& inst, const std::string& hInst,
-                const std::string& hMod, const std::string& blake, const int w)
+                const std::string& hMod, const uint64_t w)
             : moduleName(mod)
             , instanceName(inst)
             , hierInstance(hInst)
             , hierModule(hMod)
-            , hash(blake)
             , weight(w) {}
     };
 
@@ -945,48 +1281,168 @@ class HierCellsGraphVisitor final : public VNVisitorConst {
     std::string m_hier;
     std::string m_hierWRTModuleName;
     std::unordered_map<std::string, std::vector<ModNode>> adjacency;
+    std::unordered_map<std::string, uint64_t> m_moduleCost;  // Module name -> own logic cost
+    std::unordered_map<std::string, uint64_t> m_profileWeights;  // Hier -> measured weight
+    // Cells of each module, found with one walk of its body however often it is instantiated
+    std::unordered_map<const AstNodeModule*, std::vector<AstCell*>> m_moduleCells;
 
     std::string stripTrailingDot(const std::string& str) {
         if (!str.empty() && str.back() == '.') { return str.substr(0, str.size() - 1); }
         return str;
     }
 
+    const std::vector<AstCell*>& cellsOf(AstNodeModule* modp) {
+        const auto it = m_moduleCells.find(modp);
+        if (it != m_moduleCells.end()) return it->second;
+        std::vector<AstCell*>& cells = m_moduleCells[modp];
+        modp->foreach([&](AstCell* cellp) { cells.push_back(cellp); });
+        return cells;
+    }
+
     // Recursive traversal algorithm to get the module's file path
-    void collectPartitionFiles(AstNodeModule* module, std::set<std::string>& fileSet) {
-        if (!module || module->dead()) return;
+    void collectPartitionFiles(AstNodeModule* module, std::set<std::string>& fileSet,
+                               std::unordered_set<const AstNodeModule*>& visited) {
+        if (!module || module->dead() || !visited.insert(module).second) return;
 
         // Add the current module's file to our set
         fileSet.insert(module->fileline()->filename());
 
         // Recurse into all child instances (AstCells)
-        module->foreach([&](AstCell* cellp) {
-            if (cellp->modp()) { collectPartitionFiles(cellp->modp(), fileSet); }
-        });
+        for (AstCell* cellp : cellsOf(module)) {
+            if (cellp->modp()) { collectPartitionFiles(cellp->modp(), fileSet, visited); }
+        }
+    }
+
+    // Files read by this run that the partition's verilate step may also read: includes,
+    // configuration files and the like. Files that only define modules outside the
+    // partition, and the -f files listing the design, are left out so that the model key
+    // still matches in other designs using the partition.
+    std::vector<std::string> partitionDependFiles(AstNetlist* rootp,
+                                                  const std::set<std::string>& partitionFiles) {
+        std::set<std::string> otherFiles;
+        for (AstNodeModule* modp = rootp->modulesp(); modp;
+             modp = VN_AS(modp->nextp(), NodeModule)) {
+            const std::string& file = modp->fileline()->filename();
+            if (!partitionFiles.count(file)) otherFiles.insert(file);
+        }
+        std::istringstream args{argString};
+        std::string arg;
+        while (args >> arg) {
+            if ((arg == "-f" || arg == "-F") && args >> arg) otherFiles.insert(arg);
+        }
+        std::vector<std::string> files;
+        for (const std::string& file : V3File::getAllDeps()) {
+            if (!partitionFiles.count(file) && !otherFiles.count(file)) files.push_back(file);
+        }
+        return files;
+    }
+
+    // Rough estimate of one evaluation of a module's own logic, excluding the modules it
+    // instantiates. Shared by all instances of the module. It is a V3InstrCount instruction
+    // count of the module as elaborated, before scheduling and optimization remove or
+    // duplicate logic. Before V3Width the widths that count needs are not known yet, so
+    // the module's expressions are counted instead.
+    uint64_t moduleCost(const std::string& moduleName) {
+        const auto it = m_moduleCost.find(moduleName);
+        if (it != m_moduleCost.end()) return it->second;
+        uint64_t cost = 1;  // Every instance costs something, even a pure wrapper
+        const auto modIt = moduleNameToModulePtr.find(moduleName);
+        if (modIt != moduleNameToModulePtr.end()) {
+            if (v3Global.assertDTypesResolved()) {
+                cost += V3InstrCount::count(modIt->second, false);
+            } else {
+                modIt->second->foreach([&](const AstNodeExpr*) { ++cost; });
+            }
+        }
+        m_moduleCost.emplace(moduleName, cost);
+        return cost;
     }
 
     void dfs(const std::string& nodeHier, std::unordered_set<std::string>& visited) {
         if (visited.count(nodeHier)) return;
         visited.insert(nodeHier);
-        int totalChildWeight = 0;
-        bool hasChild = false;
+        uint64_t totalChildWeight = 0;
         auto it = adjacency.find(nodeHier);
         if (it != adjacency.end()) {
             for (const ModNode& child : it->second) {
-                hasChild = true;
                 dfs(child.hierInstance, visited);
                 totalChildWeight += nodeMetadata[child.hierInstance].weight;
             }
         }
         if (nodeMetadata.count(nodeHier)) {
-            nodeMetadata[nodeHier].weight = hasChild ? totalChildWeight : 1;
+            ModNode& node = nodeMetadata[nodeHier];
+            const auto profIt = m_profileWeights.find(nodeHier);
+            if (profIt != m_profileWeights.end()) {
+                node.weight = profIt->second;
+            } else {
+                const uint64_t ownCost = (nodeHier == "$root") ? 0 : moduleCost(node.moduleName);
+                node.weight = ownCost + totalChildWeight;
+            }
+        }
+    }
+
+    /**
+     * @brief Overrides estimated weights with measured costs from a profile.
+     * @details Each non-comment line holds a hierarchical instance name, as printed by the
+     * partition selection, and its measured cost in any unit (e.g. eval ticks). Measured
+     * costs are scaled so that the profiled instances keep their total estimated weight;
+     * this keeps them comparable with the estimates of the instances the profile does not
+     * cover, while their relative costs come from the measurement. An instance's cost
+     * includes the instances below it, so only profiled instances with no profiled
+     * instance below them set the scale.
+     */
+    void loadProfile(const std::string& filename) {
+        std::ifstream profileFile(filename);
+        if (!profileFile.is_open()) {
+            std::cerr << "  --> WARNING: Could not open profile '" << filename
+                      << "'; using estimated weights.\n";
+            return;
+        }
+        std::map<std::string, double> measured;
+        std::string line;
+        while (std::getline(profileFile, line)) {
+            std::istringstream iss(line);
+            std::string hier;
+            double cost = 0;
+            if (!(iss >> hier) || hier[0] == '#') continue;
+            if (!(iss >> cost) || cost < 0) {
+                std::cerr << "  --> WARNING: Ignoring malformed profile line: " << line << "\n";
+                continue;
+            }
+            if (!nodeMetadata.count(hier)) {
+                std::cerr << "  --> WARNING: Profiled instance '" << hier
+                          << "' is not in the design; ignored.\n";
+                continue;
+            }
+            measured[hier] = cost;
+        }
+        double estimatedSum = 0;
+        double measuredSum = 0;
+        for (const auto& [hier, cost] : measured) {
+            const std::string prefix = hier + ".";
+            const auto below = measured.lower_bound(prefix);
+            if (below != measured.end() && below->first.compare(0, prefix.size(), prefix) == 0) {
+                continue;
+            }
+            estimatedSum += nodeMetadata[hier].weight;
+            measuredSum += cost;
+        }
+        if (measuredSum <= 0) return;
+        const double scale = estimatedSum / measuredSum;
+        for (const auto& [hier, cost] : measured) {
+            m_profileWeights[hier] = std::max<uint64_t>(1, std::llround(cost * scale));
         }
+        std::cout << "  Loaded " << m_profileWeights.size() << " measured weights from '"
+                  << filename << "'\n";
+        std::unordered_set<std::string> visited;
+        dfs("$root", visited);
     }
 
     void visit(AstNodeModule* nodep) override {
         if (!nodep->dead()) {
             m_hier = "$root";
             m_hierWRTModuleName = "$root";
-            iterateChildrenConst(nodep);
+            for (AstCell* cellp : cellsOf(nodep)) iterateConst(cellp);
         }
     }
 
@@ -1002,7 +1458,7 @@ class HierCellsGraphVisitor final : public VNVisitorConst {
         std::string childHierWRTInstanceName = parentHier + "." + instanceName;
         std::string childHierWRTModuleName = stripTrailingDot(m_hierWRTModuleName) + "." + modName;
         ModNode childNode(modName, instanceName, childHierWRTInstanceName, childHierWRTModuleName,
-                          blake2b_128_hex(childHierWRTModuleName), 0);
+                          0);
         nodeMetadata[childHierWRTInstanceName] = childNode;
         edges.emplace_back(parentHier, childHierWRTInstanceName);
         adjacency[parentHier].push_back(childNode);
@@ -1010,7 +1466,10 @@ class HierCellsGraphVisitor final : public VNVisitorConst {
         const std::string oldModHier = m_hierWRTModuleName;
         m_hier = childHierWRTInstanceName;
         m_hierWRTModuleName = childHierWRTModuleName;
-        iterateChildrenConst(nodep->modp());
+        // Only the cells of the child matter here, not the rest of its body
+        if (nodep->modp()) {
+            for (AstCell* cellp : cellsOf(nodep->modp())) iterateConst(cellp);
+        }
         m_hier = oldHier;
         m_hierWRTModuleName = oldModHier;
     }
@@ -1023,77 +1482,180 @@ public:
         m_hier = stripTrailingDot(top->name()) + ".";
         m_rootHier = stripTrailingDot(top->origName());
         nodeMetadata["$root"]
-            = ModNode("$root", "$root", "$root", "$root", blake2b_128_hex("$root"), 0);
+            = ModNode("$root", "$root", "$root", "$root", 0);
         iterateConst(top);
     }
 
-    bool runBFSCheckDuplicateHashes(std::string& o_partitionModuleName,
-                                    std::vector<std::string>& o_partitionInstanceNames,
-                                    std::string& o_parentHier) {
-        std::queue<std::string> q;
-        q.push("$root");
-        std::unordered_set<std::string> visited;
-        visited.insert("$root");
-        int level = 0;
-        while (!q.empty()) {
-            size_t levelSize = q.size();
-            std::unordered_map<std::string, std::vector<ModNode>> hashToNodes;
-            for (size_t i = 0; i < levelSize; ++i) {
-                std::string current = q.front();
-                q.pop();
-                const auto& children = adjacency[current];
-                for (const auto& child : children) {
-                    if (visited.count(child.hierInstance)) continue;
-                    visited.insert(child.hierInstance);
-                    hashToNodes[child.hash].push_back(child);
-                    q.push(child.hierInstance);
-                }
+    /**
+     * @brief Selects the partition instances by weight rather than by identical hashes.
+     * @details The cut is a frontier of the hierarchy: the instances of the top module at
+     * first, then repeatedly the heaviest frontier instance is replaced by its children.
+     * Only a module instantiated once is split this way, as its source is rewritten to
+     * instantiate the partitions' wrappers, so a cut may take instances from several
+     * levels and parents. For each frontier, instances are offloaded in decreasing order
+     * of weight, whether or not they are instances of the same module, as long as they fit
+     * in @p maxRanks (0 means no limit). An instance that would need a rank beyond that is
+     * passed over for lighter ones. A cut is scored by its bottleneck: the heavier of the
+     * largest partition and what stays on rank 0, i.e. the total weight minus everything
+     * offloaded. Splitting stops once the heaviest instance cannot be split or is lighter
+     * than the best bottleneck, as splitting only adds to rank 0. The cut with the
+     * smallest bottleneck wins; ties prefer fewer ranks, then fewer splits. An instance
+     * that is another parameterization of a module already taken stays on rank 0, with a
+     * warning if the selected cut has one.
+     * @param maxRanks Maximum number of partition ranks (excluding rank 0), or 0.
+     * @param instancesPerRank Instances of one module that share a partition rank.
+     * @param o_partitionsByParent Receives the selected instance names by parent hierarchy.
+     * @return True if a cut that offloads anything from rank 0 was found.
+     */
+    bool selectWeightedPartitions(
+        int maxRanks, int instancesPerRank,
+        std::map<std::string, std::vector<std::string>>& o_partitionsByParent) {
+        // A frontier entry: the instance's parent hierarchy and the instance
+        using Site = std::pair<std::string, ModNode>;
+        struct Cut {
+            std::vector<Site> taken;
+            std::vector<Site> skipped;
+            int ranks = 0;
+            uint64_t bottleneck = 0;
+        };
+        const uint64_t totalWeight = nodeMetadata["$root"].weight;
+        std::unordered_map<std::string, int> instancesOfModule;
+        for (const auto& hierNode : nodeMetadata) ++instancesOfModule[hierNode.second.moduleName];
+        const auto splittable = [&](const ModNode& node) {
+            return adjacency.count(node.hierInstance)
+                   && moduleNameToModulePtr.count(node.moduleName)
+                   && instancesOfModule[node.moduleName] == 1;
+        };
+        const auto parentsOf = [](const std::vector<Site>& sites) {
+            std::set<std::string> hiers;
+            for (const Site& site : sites) hiers.insert(site.first);
+            std::string names;
+            for (const std::string& hier : hiers) {
+                names += (names.empty() ? "'" : ", '") + hier + "'";
             }
-            bool foundAny = false;
-            std::string bestHash;
-            int maxWeight = -1;
-            for (const auto& [hash, nodes] : hashToNodes) {
-                if (nodes.size() > 1) {
-                    int currentWeightSum = 0;
-                    for (const auto& node : nodes) {
-                        if (nodeMetadata.count(node.hierInstance)) {
-                            currentWeightSum += nodeMetadata[node.hierInstance].weight;
-                        }
-                    }
-                    if (currentWeightSum > maxWeight) {
-                        maxWeight = currentWeightSum;
-                        bestHash = hash;
-                        foundAny = true;
-                    }
+            return names;
+        };
+
+        // The best offload of one frontier; its bottleneck is the total weight if none helps
+        const auto evaluate = [&](const std::vector<Site>& frontier) {
+            std::vector<Site> candidates;
+            for (const Site& site : frontier) {
+                // The parent must be a real module, as its source is rewritten
+                if (site.first == "$root" || !moduleNameToModulePtr.count(site.second.moduleName))
+                    continue;
+                candidates.push_back(site);
+            }
+            std::stable_sort(candidates.begin(), candidates.end(),
+                             [](const Site& a, const Site& b) {
+                                 return a.second.weight > b.second.weight;
+                             });
+            // Stubs and wrappers are named after the original module name, so differently
+            // parameterized copies of one module cannot both be partitions; the heaviest
+            // variant is kept.
+            Cut best;
+            best.bottleneck = totalWeight;
+            std::vector<Site> skipped;
+            std::map<std::string, std::string> origToModName;
+            for (auto it = candidates.begin(); it != candidates.end();) {
+                const std::string origName
+                    = moduleNameToModulePtr[it->second.moduleName]->origName();
+                const auto res = origToModName.emplace(origName, it->second.moduleName);
+                if (!res.second && res.first->second != it->second.moduleName) {
+                    skipped.push_back(*it);
+                    it = candidates.erase(it);
+                } else {
+                    ++it;
                 }
             }
-            if (foundAny) {
-                std::cout << "Duplicate hash(es) found at level " << level << ":\n";
-                std::cout << "  Hash: " << bestHash << " (Max weight sum: " << maxWeight << ")\n";
-                const auto& bestNodes = hashToNodes[bestHash];
-                o_partitionModuleName = bestNodes[0].moduleName;
-                size_t lastDot = bestNodes[0].hierInstance.rfind('.');
-                o_parentHier = (lastDot != std::string::npos)
-                                   ? bestNodes[0].hierInstance.substr(0, lastDot)
-                                   : "$root";
-                for (const auto& node : bestNodes) {
-                    std::cout << "    Module: " << node.moduleName
-                              << ", Instance: " << node.instanceName
-                              << ", Hier: " << node.hierInstance
-                              << ", Weight: " << nodeMetadata[node.hierInstance].weight << "\n";
-                    o_partitionInstanceNames.push_back(node.instanceName);
+
+            // Instances share a rank only with instances of the same module under the same
+            // parent, so every such group starts a new rank, as PartitionPortAnalyzer
+            // numbers them
+            std::vector<Site> taken;
+            std::map<std::pair<std::string, std::string>, int> takenOfModule;
+            int ranks = 0;
+            uint64_t offloaded = 0;
+            for (const Site& site : candidates) {
+                int& ofModule = takenOfModule[{
+                    site.first, moduleNameToModulePtr[site.second.moduleName]->origName()}];
+                const int newRank = ofModule % instancesPerRank == 0 ? 1 : 0;
+                if (maxRanks > 0 && ranks + newRank > maxRanks) continue;
+                ranks += newRank;
+                ++ofModule;
+                taken.push_back(site);
+                offloaded += site.second.weight;
+                const uint64_t bottleneck
+                    = std::max(taken[0].second.weight, totalWeight - offloaded);
+                if (bottleneck < best.bottleneck
+                    || (bottleneck == best.bottleneck && !best.taken.empty()
+                        && ranks < best.ranks)) {
+                    best.bottleneck = bottleneck;
+                    best.ranks = ranks;
+                    best.taken = taken;
+                    best.skipped = skipped;
                 }
-                return true;
             }
-            ++level;
+            return best;
+        };
+
+        std::vector<Site> frontier;
+        for (const ModNode& child : adjacency["$root"]) {
+            frontier.emplace_back("$root", nodeMetadata[child.hierInstance]);
+        }
+        Cut best;
+        best.bottleneck = totalWeight;
+        while (true) {
+            const auto heaviest = std::max_element(
+                frontier.begin(), frontier.end(),
+                [](const Site& a, const Site& b) { return a.second.weight < b.second.weight; });
+            if (heaviest == frontier.end() || !splittable(heaviest->second)
+                || heaviest->second.weight < best.bottleneck) {
+                break;
+            }
+            const std::string parentHier = heaviest->second.hierInstance;
+            frontier.erase(heaviest);
+            for (const ModNode& child : adjacency[parentHier]) {
+                frontier.emplace_back(parentHier, nodeMetadata[child.hierInstance]);
+            }
+            Cut cut = evaluate(frontier);
+            if (cut.taken.empty()) continue;
+            if (best.taken.empty() || cut.bottleneck < best.bottleneck
+                || (cut.bottleneck == best.bottleneck && cut.ranks < best.ranks)) {
+                best = std::move(cut);
+                std::cout << "  Candidate cut under " << parentsOf(best.taken) << ": "
+                          << best.taken.size() << " partitions on " << best.ranks
+                          << " rank(s), bottleneck weight " << best.bottleneck << " of "
+                          << totalWeight << "\n";
+            }
+        }
+        if (best.taken.empty()) {
+            std::cout << "No cut reduces the load of rank 0; no partitions selected.\n";
+            return false;
+        }
+        std::cout << "Selected " << best.taken.size() << " partition(s) under "
+                  << parentsOf(best.taken) << " (bottleneck weight " << best.bottleneck << " of "
+                  << totalWeight << "):\n";
+        std::set<std::string> selectedOrigNames;
+        for (const auto& [parentHier, node] : best.taken) {
+            std::cout << "    Module: " << node.moduleName << ", Instance: " << node.instanceName
+                      << ", Hier: " << node.hierInstance << ", Weight: " << node.weight << "\n";
+            o_partitionsByParent[parentHier].push_back(node.instanceName);
+            selectedOrigNames.insert(moduleNameToModulePtr[node.moduleName]->origName());
+        }
+        for (const auto& [parentHier, node] : best.skipped) {
+            if (!selectedOrigNames.count(moduleNameToModulePtr[node.moduleName]->origName())) {
+                continue;
+            }
+            std::cerr << "  --> WARNING: Instance '" << node.hierInstance << "' is another "
+                      << "parameterization of a partition module; it stays on rank 0.\n";
         }
-        std::cout << "No duplicate hashes found to select a partition top.\n";
-        return false;
+        return true;
     }
 
     void runDFS() {
         std::unordered_set<std::string> visited;
         dfs("$root", visited);
+        if (!v3Global.opt.mmpiProfile().empty()) loadProfile(v3Global.opt.mmpiProfile());
     }
 
     void dumpDot(std::ostream& os) {
@@ -1121,12 +1683,13 @@ public:
     void findAndPrintPartitionPorts(AstNetlist* rootp) {
         std::cout << "Building hierarchy graph and calculating weights...\n";
         runDFS();
-        std::cout << "\nFinding partition instances via BFS hash check...\n";
-        std::string partitionModuleName;
-        std::vector<std::string> partitionInstanceNames;
-        std::string parentHier;
+        std::cout << "\nFinding partition instances by weight...\n";
+        std::map<std::string, std::vector<std::string>> partitionsByParent;
+        // Every partition rank hosts up to --mmpi-instances-per-rank instances
+        const int maxRanks = std::max(0, v3Global.opt.mmpiRanks() - 1);
         bool foundPartitions
-            = runBFSCheckDuplicateHashes(partitionModuleName, partitionInstanceNames, parentHier);
+            = selectWeightedPartitions(maxRanks, std::max(1, v3Global.opt.mmpiInstancesPerRank()),
+                                       partitionsByParent);
 
         if (foundPartitions) {
             // =================================================================
@@ -1142,138 +1705,245 @@ public:
             }
             // =================================================================
 
+            // Parents outermost first; ranks and the modified files follow this order
+            std::vector<std::string> parentHiers;
+            size_t partitionCount = 0;
+            for (const auto& [parentHier, instanceNames] : partitionsByParent) {
+                parentHiers.push_back(parentHier);
+                partitionCount += instanceNames.size();
+            }
+            std::stable_sort(parentHiers.begin(), parentHiers.end(),
+                             [](const std::string& a, const std::string& b) {
+                                 return std::count(a.begin(), a.end(), '.')
+                                        < std::count(b.begin(), b.end(), '.');
+                             });
+            // Instances under different parents may share a name, so with several parents
+            // a partition is named after its path below the top module, e.g. c0_u0
+            const auto processPrefix = [&](const std::string& parentHier) {
+                const size_t topEnd = parentHier.find('.', std::string{"$root."}.size());
+                if (parentHiers.size() < 2 || topEnd == std::string::npos) return std::string{};
+                std::string prefix = parentHier.substr(topEnd + 1);
+                std::replace(prefix.begin(), prefix.end(), '.', '_');
+                return prefix + "_";
+            };
+
             std::cout << "\n======================================================================"
                          "===================================================\n";
             std::cout << "PARTITION ANALYSIS REPORT\n";
-            std::cout << "Found " << partitionInstanceNames.size()
-                      << " partition instances of module '" << partitionModuleName << "'\n";
+            std::cout << "Found " << partitionCount << " partition instances\n";
+
+            // Partitions may be instances of different modules; each module gets its own
+            // stub, Makefile and partition main.
+            std::map<std::string, std::string> instanceModuleOrigNames;
+            std::map<std::string, std::string> partitionModules;  // Orig name -> module name
+            std::vector<MPIFileGenerator::ParentSite> parentSites;
+            for (const std::string& parentHier : parentHiers) {
+                const std::string& parentModuleName = nodeMetadata[parentHier].moduleName;
+                const auto parentIt = moduleNameToModulePtr.find(parentModuleName);
+                if (parentIt == moduleNameToModulePtr.end()) {
+                    std::cout << "ERROR: Could not find AST pointer for parent module '"
+                              << parentModuleName << "'\n";
+                    return;
+                }
+                MPIFileGenerator::ParentSite site;
+                site.moduleName = parentModuleName;
+                site.origName = parentIt->second->origName();
+                site.filePath = parentIt->second->fileline()->filename();
+                std::cout << "Parent Module: '" << parentModuleName << "' (Hier: " << parentHier
+                          << ")\n";
+                for (const auto& instanceName : partitionsByParent[parentHier]) {
+                    const std::string& moduleName
+                        = nodeMetadata[parentHier + "." + instanceName].moduleName;
+                    std::string origName = moduleName;  // Default to same name
+                    if (moduleNameToModulePtr.count(moduleName)) {
+                        origName = moduleNameToModulePtr[moduleName]->origName();
+                    }
+                    const std::string processName = processPrefix(parentHier) + instanceName;
+                    instanceModuleOrigNames[processName] = origName;
+                    partitionModules[origName] = moduleName;
+                    site.instances[processName] = instanceName;
+                    std::cout << "  --> Instance '" << processName << "' of '" << origName
+                              << "'\n";
+                }
+                parentSites.push_back(site);
+            }
+
+            for (const auto& [partitionModuleOrigName, partitionModuleName] : partitionModules) {
+                std::cout << "\n[Metro-MPI] Collecting source files for partition '"
+                          << partitionModuleOrigName << "'...\n";
+                std::set<std::string> partitionFileSet;
+                std::unordered_set<const AstNodeModule*> visitedModules;
+                collectPartitionFiles(moduleNameToModulePtr.at(partitionModuleName),
+                                      partitionFileSet, visitedModules);
+
+                std::vector<std::string> partitionFiles(partitionFileSet.begin(),
+                                                        partitionFileSet.end());
+                std::cout << "  --> Found " << partitionFiles.size() << " unique source files:\n";
+                for (const auto& file : partitionFiles) std::cout << "    - " << file << "\n";
+
+                const std::vector<std::string> dependFiles
+                    = partitionDependFiles(rootp, partitionFileSet);
+                std::cout << "  --> " << dependFiles.size()
+                          << " other file(s) are part of the model key\n";
+
+                MakefileGenerator makefileGenerator;
+                makefileGenerator.generate(argString, partitionModuleOrigName, partitionFiles,
+                                           dependFiles, V3Options::version());
+            }
 
-            std::string partitionModuleOrigName = partitionModuleName;  // Default to same name
-            if (moduleNameToModulePtr.count(partitionModuleName)) {
-                partitionModuleOrigName = moduleNameToModulePtr[partitionModuleName]->origName();
+            std::string timescale;
+            if (rootp->timescaleSpecified()) {
+                const AstNodeModule* const outerParentp
+                    = moduleNameToModulePtr[parentSites.front().moduleName];
+                timescale = std::string{"`timescale "} + outerParentp->timeunit().ascii() + " / "
+                            + rootp->timeprecision().ascii();
             }
-            std::cout << "  --> Original source name: '" << partitionModuleOrigName << "'\n";
-            std::cout << "Debug 1 " << partitionModuleOrigName << endl;
-
-            if (nodeMetadata.count(parentHier)) {
-                std::string parentModuleName = nodeMetadata[parentHier].moduleName;
-                if (moduleNameToModulePtr.count(parentModuleName)) {
-                    // --- NEW LOGIC STARTS HERE ---
-                    std::cout << "\n[Metro-MPI] Collecting source files for partition '"
-                              << partitionModuleOrigName << "'...\n";
-                    std::set<std::string> partitionFileSet;
-                    if (moduleNameToModulePtr.count(partitionModuleName)) {
-                        AstNodeModule* partitionTopModule
-                            = moduleNameToModulePtr.at(partitionModuleName);
-                        collectPartitionFiles(partitionTopModule, partitionFileSet);
+
+            MetroMpiConfig config;
+            config.boundaryClock = v3Global.opt.mmpiClock();
+            config.lookahead = v3Global.opt.mmpiLookahead();
+            config.latencyInsensitive = v3Global.opt.mmpiLatencyInsensitive();
+            config.nonblocking = v3Global.opt.mmpiNonBlocking();
+            config.pack = v3Global.opt.mmpiPack();
+            config.delta = v3Global.opt.mmpiDelta();
+            config.checkpoint = v3Global.opt.mmpiCheckpoint();
+            config.prof = v3Global.opt.mmpiProf();
+            config.instancesPerRank = v3Global.opt.mmpiInstancesPerRank();
+            config.ranksPerNode = v3Global.opt.mmpiRanksPerNode();
+
+            // One analysis per parent, as partitions under different parents only talk
+            // through rank 0. Every rank runs the same exchange, so a boundary clock that
+            // is not a port of some partitions is dropped for all of them.
+            std::vector<std::unique_ptr<PartitionPortAnalyzer>> analyzers;
+            while (true) {
+                analyzers.clear();
+                int firstRank = 1;
+                bool clockDropped = false;
+                for (const std::string& parentHier : parentHiers) {
+                    config.parentHier = parentHier;
+                    analyzers.emplace_back(new PartitionPortAnalyzer{
+                        moduleNameToModulePtr[nodeMetadata[parentHier].moduleName],
+                        partitionsByParent[parentHier], config, firstRank});
+                    analyzers.back()->analyze();
+                    firstRank = analyzers.back()->nextRank();
+                    if (analyzers.back()->getConfig().boundaryClock != config.boundaryClock) {
+                        clockDropped = true;
                     }
+                }
+                if (!clockDropped || analyzers.size() == 1) break;
+                config.boundaryClock.clear();
+            }
 
-                    std::vector<std::string> partitionFiles(partitionFileSet.begin(),
-                                                            partitionFileSet.end());
-                    std::cout << "  --> Found " << partitionFiles.size()
-                              << " unique source files:\n";
-                    for (const auto& file : partitionFiles) {
-                        std::cout << "    - " << file << "\n";
+            // Handed to the generators in memory; the file is for inspection only
+            json report;
+            std::map<std::string, std::vector<PartitionPortAnalyzer::Port>> partitionData;
+            int bcastGroups = 0;  // Fan-out groups are numbered per parent
+            for (size_t i = 0; i < analyzers.size(); ++i) {
+                analyzers[i]->prefixProcessNames(processPrefix(parentHiers[i]));
+                analyzers[i]->printReport();
+                for (const auto& [instName, ports] : analyzers[i]->getPartitionData()) {
+                    partitionData[instName] = ports;
+                }
+                json parentReport = analyzers[i]->toJson();
+                if (i == 0) {
+                    report["config"] = parentReport["config"];
+                    report["partitions"] = json::object();
+                }
+                int groups = 0;
+                for (auto& item : parentReport["partitions"].items()) {
+                    for (json& port : item.value()) {
+                        const int group = port.value("bcast_group", -1);
+                        if (group < 0) continue;
+                        groups = std::max(groups, group + 1);
+                        port["bcast_group"] = group + bcastGroups;
                     }
+                    report["partitions"][item.key()] = std::move(item.value());
+                }
+                bcastGroups += groups;
+            }
+            if (v3Global.opt.mmpiReport()) {
+                PartitionPortAnalyzer::writeJsonReport(report, "metro_mpi/partition_report.json");
+            }
+            // =================================================================
+            // ### Calling the MPI File Generator ###
 
-                    MakefileGenerator makefileGenerator;
-                    makefileGenerator.generate(argString, partitionModuleOrigName, partitionFiles);
-                    // Now we have the 'partitionFiles' vector to use for generating the Makefile
-
-                    AstNodeModule* parentModulePtr = moduleNameToModulePtr[parentModuleName];
-                    std::cout << "Parent Module: '" << parentModuleName
-                              << "' (Hier: " << parentHier << ")\n";
-
-                    const std::string parentModuleFilePath
-                        = parentModulePtr->fileline()->filename();
-
-                    PartitionPortAnalyzer analyzer(parentModulePtr, partitionInstanceNames);
-                    analyzer.analyze();
-                    analyzer.printReport();
-                    analyzer.writeJsonReport("metro_mpi/partition_report.json");
-                    // =================================================================
-                    // ### Calling the MPI File Generator ###
-
-                    MPIFileGenerator fileGenerator;
-                    fileGenerator.generateAndModifyFiles(
-                        partitionModuleName, partitionModuleOrigName, analyzer.getPartitionData(),
-                        moduleNameToModulePtr, parentModuleFilePath, parentModuleName);
-
-                    // =================================================================
-                    // NEW: Calling the metro_mpi.cpp code generator
-
-                    MPICodeGenerator codeGenerator;
-                    codeGenerator.generateMpiVerificationFile("metro_mpi/partition_report.json");
-
-                    // =================================================================
-                    // ### NEW: Calling the main <PartitionModuleName>_main.cpp generator ###
-                    MPIMainGenerator mainGenerator;
-                    std::cout << "Debug 2 " << partitionModuleOrigName << endl;
-                    mainGenerator.generate("metro_mpi/partition_report.json",
-                                           partitionModuleOrigName);
-
-                    // =================================================================
-                    // ### NEW: Calling the Rank 0 Main C++ driver generator ###
-                    if (rootp->topModulep()) {
-                        std::string topModuleNameForRank0;
-                        AstNodeModule* currentTop = rootp->topModulep();
-
-                        if (currentTop && currentTop->name() == "$root") {
-                            // After Verilator's wrapTop pass, the user's top module is the single
-                            // cell instantiated inside the new '$root' module.
-                            AstCell* topCell = nullptr;
-
-                            // Use the correct 'foreach' visitor to find the cell inside the
-                            // module.
-                            currentTop->foreach([&](AstCell* cellp) {
-                                if (!topCell) {  // Find the first (and should be only) cell
-                                    topCell = cellp;
-                                }
-                            });
-
-                            if (topCell && topCell->modp()) {
-                                // Correctly get the module pointer from the cell, then get its
-                                // original name.
-                                topModuleNameForRank0 = topCell->modp()->origName();
-                                std::cout
-                                    << "[Metro-MPI] Detected wrapped top module. Rank 0 top is '"
-                                    << topModuleNameForRank0 << "'.\n";
-                            } else {
-                                std::cerr << "  --> WARNING: Could not find top-level instance "
-                                             "inside $root module. Falling back.\n";
-                                topModuleNameForRank0 = v3Global.opt.topModule();
-                            }
-                        } else if (currentTop) {
-                            // This is a fallback in case the analysis runs before wrapTop
-                            topModuleNameForRank0 = currentTop->origName();
-                        } else {
-                            std::cerr << "  --> WARNING: Could not determine top-level module. "
-                                         "Falling back.\n";
-                            topModuleNameForRank0 = v3Global.opt.topModule();
-                        }
+            MPIFileGenerator fileGenerator;
+            fileGenerator.generateAndModifyFiles(instanceModuleOrigNames, partitionData,
+                                                 moduleNameToModulePtr, parentSites,
+                                                 analyzers.front()->getConfig().boundaryClock,
+                                                 timescale);
 
-                        if (topModuleNameForRank0.empty()) {
-                            std::cerr << "  --> FATAL: Top module name for Rank 0 generator is "
-                                         "empty. Aborting.\n";
-                            return;  // Stop further processing
-                        }
-                        Rank0MainGenerator rank0Generator;
-                        std::cout << "topModuleName -> " << topModuleNameForRank0 << std::endl;
-                        rank0Generator.generate("metro_mpi/partition_report.json",
-                                                topModuleNameForRank0);
+            // =================================================================
+            // NEW: Calling the metro_mpi.cpp code generator
 
+            MPICodeGenerator codeGenerator;
+            codeGenerator.generateFromReport(report);
+
+            // =================================================================
+            // ### NEW: Calling the main <PartitionModuleName>_main.cpp generator ###
+            for (const auto& it : partitionModules) {
+                MPIMainGenerator mainGenerator;
+                mainGenerator.generateFromReport(report, it.first);
+            }
+
+            // =================================================================
+            // ### NEW: Calling the Rank 0 Main C++ driver generator ###
+            if (rootp->topModulep()) {
+                std::string topModuleNameForRank0;
+                AstNodeModule* currentTop = rootp->topModulep();
+
+                if (currentTop && currentTop->name() == "$root") {
+                    // After Verilator's wrapTop pass, the user's top module is the single
+                    // cell instantiated inside the new '$root' module.
+                    AstCell* topCell = nullptr;
+
+                    // Use the correct 'foreach' visitor to find the cell inside the
+                    // module.
+                    currentTop->foreach([&](AstCell* cellp) {
+                        if (!topCell) {  // Find the first (and should be only) cell
+                            topCell = cellp;
+                        }
+                    });
+
+                    if (topCell && topCell->modp()) {
+                        // Correctly get the module pointer from the cell, then get its
+                        // original name.
+                        topModuleNameForRank0 = topCell->modp()->origName();
+                        std::cout
+                            << "[Metro-MPI] Detected wrapped top module. Rank 0 top is '"
+                            << topModuleNameForRank0 << "'.\n";
                     } else {
-                        std::cerr << "  --> ERROR: Could not determine top-level module name for "
-                                     "Rank 0 generator.\n";
+                        std::cerr << "  --> WARNING: Could not find top-level instance "
+                                     "inside $root module. Falling back.\n";
+                        topModuleNameForRank0 = v3Global.opt.topModule();
                     }
-
+                } else if (currentTop) {
+                    // This is a fallback in case the analysis runs before wrapTop
+                    topModuleNameForRank0 = currentTop->origName();
                 } else {
-                    std::cout << "ERROR: Could not find AST pointer for parent module '"
-                              << parentModuleName << "'\n";
+                    std::cerr << "  --> WARNING: Could not determine top-level module. "
+                                 "Falling back.\n";
+                    topModuleNameForRank0 = v3Global.opt.topModule();
                 }
+
+                if (topModuleNameForRank0.empty()) {
+                    std::cerr << "  --> FATAL: Top module name for Rank 0 generator is "
+                                 "empty. Aborting.\n";
+                    return;  // Stop further processing
+                }
+                Rank0MainGenerator rank0Generator;
+                std::cout << "topModuleName -> " << topModuleNameForRank0 << std::endl;
+                // The harness implements the DPI imports of the partition stubs,
+                // which are named after the partition modules.
+                std::vector<std::string> partitionModuleOrigNames;
+                for (const auto& it : partitionModules) {
+                    partitionModuleOrigNames.push_back(it.first);
+                }
+                rank0Generator.generateFromReport(report, partitionModuleOrigNames);
+
             } else {
-                std::cout << "ERROR: Could not find metadata for parent hierarchy '" << parentHier
-                          << "'\n";
+                std::cerr << "  --> ERROR: Could not determine top-level module name for "
+                             "Rank 0 generator.\n";
             }
         } else {
             std::cout << "\nNo partition top was selected, skipping port printing.\n";
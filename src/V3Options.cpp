@@ -876,6 +876,32 @@ void V3Options::notify() VL_MT_DISABLED {
                 + ". Suggest see manual");
     }
 
+    // Metro-MPI wire formats: delta messages are variable length, so they can use neither
+    // the packed word buffer nor the fixed-size persistent requests
+    if (m_mmpiDelta && m_mmpiPack) {
+        cmdfl->v3error("--mmpi-delta cannot be used together with --mmpi-pack");
+    }
+    if (m_mmpiDelta && m_mmpiNonBlocking) {
+        cmdfl->v3error("--mmpi-delta cannot be used together with --mmpi-nonblocking");
+    }
+    if (m_mmpiInstancesPerRank > 1 && m_mmpiNonBlocking) {
+        cmdfl->v3error(
+            "--mmpi-instances-per-rank cannot be used together with --mmpi-nonblocking");
+    }
+    // With a boundary clock, a rank answers rank 0 only after evaluating the edge, but rank 0
+    // waits for each instance's answer before sending to the next one it hosts
+    if (m_mmpiInstancesPerRank > 1 && !m_mmpiClock.empty()) {
+        cmdfl->v3error("--mmpi-instances-per-rank cannot be used together with --mmpi-clock");
+    }
+    // Checkpoints serialize the models, and replay in-flight messages through the blocking
+    // exchange functions
+    if (m_mmpiCheckpoint && !m_savable) {
+        cmdfl->v3error("--mmpi-checkpoint requires --savable");
+    }
+    if (m_mmpiCheckpoint && m_mmpiNonBlocking) {
+        cmdfl->v3error("--mmpi-checkpoint cannot be used together with --mmpi-nonblocking");
+    }
+
     if (m_exe && !v3Global.opt.libCreate().empty()) {
         cmdfl->v3error("--exe cannot be used together with --lib-create. Suggest see manual");
     }
@@ -934,6 +960,23 @@ void V3Options::notify() VL_MT_DISABLED {
         if (traceFormat().vcd()) m_traceThreads = 1;
     }
 
+    if (trace() && traceFormat().bin() && m_traceThreads) {
+        // Records are written straight into the mapped file, there is nothing to offload
+        cmdfl->v3error("--trace-bin cannot be used with --trace-threads");
+        m_traceThreads = 0;
+    }
+
+    if (m_traceShards > 1 && !(trace() && traceFormat().fst())) {
+        // Only the FST writer splits its output
+        cmdfl->v3error("--trace-shards requires --trace-fst");
+        m_traceShards = 1;
+    }
+
+    if (useTraceShards() && useTraceOffload()) {
+        cmdfl->v3error("--trace-shards cannot be used with --trace-threads > 1");
+        m_traceThreads = 1;
+    }
+
     UASSERT(!(useTraceParallel() && useTraceOffload()),
             "Cannot use both parallel and offloaded tracing");
 
@@ -1452,6 +1495,45 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc,
     DECL_OPTION("-mmpi-o1", Set, &m_mmpio1);
     DECL_OPTION("-mmpi-xml", Set, &m_mmpixml);
     DECL_OPTION("-mmpi-mk", Set, &m_mmpimk);
+    DECL_OPTION("-mmpi-clock", Set, &m_mmpiClock);
+    DECL_OPTION("-mmpi-nonblocking", OnOff, &m_mmpiNonBlocking);
+    DECL_OPTION("-mmpi-pack", OnOff, &m_mmpiPack);
+    DECL_OPTION("-mmpi-delta", OnOff, &m_mmpiDelta);
+    DECL_OPTION("-mmpi-checkpoint", OnOff, &m_mmpiCheckpoint);
+    DECL_OPTION("-mmpi-prof", OnOff, &m_mmpiProf);
+    DECL_OPTION("-mmpi-report", OnOff, &m_mmpiReport);
+    DECL_OPTION("-mmpi-profile", Set, &m_mmpiProfile);
+    DECL_OPTION("-mmpi-latency-insensitive", CbVal, [this, fl](const char* valp) {
+        const string port = valp;
+        const size_t dot = port.find('.');
+        if (dot == string::npos || dot == 0 || dot + 1 == port.size()) {
+            fl->v3error("--mmpi-latency-insensitive expects <module>.<port>: " << valp);
+            return;
+        }
+        m_mmpiLatencyInsensitive.insert(port);
+    });
+    DECL_OPTION("-mmpi-lookahead", CbVal, [this, fl](const char* valp) {
+        m_mmpiLookahead = std::atoi(valp);
+        if (m_mmpiLookahead < 0) fl->v3error("--mmpi-lookahead must be >= 0: " << valp);
+    });
+    DECL_OPTION("-mmpi-ranks", CbVal, [this, fl](const char* valp) {
+        m_mmpiRanks = std::atoi(valp);
+        if (m_mmpiRanks < 0 || m_mmpiRanks == 1) {
+            fl->v3error("--mmpi-ranks must be 0 (no limit) or >= 2: " << valp);
+        }
+    });
+    DECL_OPTION("-mmpi-instances-per-rank", CbVal, [this, fl](const char* valp) {
+        m_mmpiInstancesPerRank = std::atoi(valp);
+        if (m_mmpiInstancesPerRank < 1) {
+            fl->v3error("--mmpi-instances-per-rank must be >= 1: " << valp);
+        }
+    });
+    DECL_OPTION("-mmpi-ranks-per-node", CbVal, [this, fl](const char* valp) {
+        m_mmpiRanksPerNode = std::atoi(valp);
+        if (m_mmpiRanksPerNode < 0) {
+            fl->v3error("--mmpi-ranks-per-node must be >= 0: " << valp);
+        }
+    });
     DECL_OPTION("-d1", Set, &m_d1);
     DECL_OPTION("-d2", Set, &m_d2);
     // DECL_OPTION("-mmpi-xml", CbVal, [this, fl](const char* valp) {
@@ -1622,6 +1704,7 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc,
                         << fl->warnMore() << "... Suggest 'all', 'none', or 'pure'");
         }
     });
+    DECL_OPTION("-threads-dynamic", OnOff, &m_threadsDynamic);
     DECL_OPTION("-threads-max-mtasks", CbVal, [this, fl](const char* valp) {
         m_threadsMaxMTasks = std::atoi(valp);
         if (m_threadsMaxMTasks < 1) fl->v3fatal("--threads-max-mtasks must be >= 1: " << valp);
@@ -1650,6 +1733,10 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc,
     DECL_OPTION("-top", Set, &m_topModule);
     DECL_OPTION("-top-module", Set, &m_topModule);
     DECL_OPTION("-trace", OnOff, &m_trace);
+    DECL_OPTION("-trace-bin", CbCall, [this]() {
+        m_trace = true;
+        m_traceFormat = TraceFormat::BIN;
+    });
     DECL_OPTION("-trace-saif", CbCall, [this]() {
         m_trace = true;
         m_traceFormat = TraceFormat::SAIF;
@@ -1672,6 +1759,11 @@ void V3Options::parseOptsList(FileLine* fl, const string& optdir, int argc,
     DECL_OPTION("-trace-max-array", Set, &m_traceMaxArray);
     DECL_OPTION("-trace-max-width", Set, &m_traceMaxWidth);
     DECL_OPTION("-trace-params", OnOff, &m_traceParams);
+    DECL_OPTION("-trace-scope-enable", OnOff, &m_traceScopeEnable);
+    DECL_OPTION("-trace-shards", CbVal, [this, fl](const char* valp) {
+        m_traceShards = std::atoi(valp);
+        if (m_traceShards < 1) fl->v3fatal("--trace-shards must be >= 1: " << valp);
+    });
     DECL_OPTION("-trace-structs", OnOff, &m_traceStructs);
     DECL_OPTION("-trace-threads", CbVal, [this, fl](const char* valp) {
         m_trace = true;
@@ -133,22 +133,25 @@ inline std::ostream& operator<<(std::ostream& os, const VTimescale& rhs) {
 
 class TraceFormat final {
 public:
-    enum en : uint8_t { VCD = 0, FST, SAIF } m_e;
+    enum en : uint8_t { VCD = 0, FST, SAIF, BIN } m_e;
     // cppcheck-suppress noExplicitConstructor
     constexpr TraceFormat(en _e = VCD)
         : m_e{_e} {}
     explicit TraceFormat(int _e)
         : m_e(static_cast<en>(_e)) {}  // Need () or GCC 4.8 false warning
     constexpr operator en() const { return m_e; }
+    bool bin() const { return m_e == BIN; }
     bool fst() const { return m_e == FST; }
     bool saif() const { return m_e == SAIF; }
     bool vcd() const { return m_e == VCD; }
     string classBase() const VL_MT_SAFE {
-        static const char* const names[] = {"VerilatedVcd", "VerilatedFst", "VerilatedSaif"};
+        static const char* const names[]
+            = {"VerilatedVcd", "VerilatedFst", "VerilatedSaif", "VerilatedBin"};
         return names[m_e];
     }
     string sourceName() const VL_MT_SAFE {
-        static const char* const names[] = {"verilated_vcd", "verilated_fst", "verilated_saif"};
+        static const char* const names[]
+            = {"verilated_vcd", "verilated_fst", "verilated_saif", "verilated_bin"};
         return names[m_e];
     }
 };
@@ -265,6 +268,17 @@ private:
     bool m_mmpio1 = false;        // main switch: --mmpi-o1
     bool m_mmpixml = false;        // main switch: --mmpi-xml
     bool m_mmpimk = false;        // main switch: --mmpi-mk
+    bool m_mmpiNonBlocking = false;  // main switch: --mmpi-nonblocking
+    bool m_mmpiPack = false;  // main switch: --mmpi-pack
+    bool m_mmpiDelta = false;  // main switch: --mmpi-delta
+    bool m_mmpiCheckpoint = false;  // main switch: --mmpi-checkpoint
+    bool m_mmpiProf = false;  // main switch: --mmpi-prof
+    bool m_mmpiReport = false;  // main switch: --mmpi-report
+    int m_mmpiRanks = 0;  // main switch: --mmpi-ranks
+    int m_mmpiInstancesPerRank = 1;  // main switch: --mmpi-instances-per-rank
+    int m_mmpiRanksPerNode = 0;  // main switch: --mmpi-ranks-per-node
+    string m_mmpiProfile;  // main switch: --mmpi-profile
+    V3StringSet m_mmpiLatencyInsensitive;  // argument: --mmpi-latency-insensitive list
     bool m_d1 = false;        // main switch: --d1
     bool m_d2 = false;        // main switch: --d2
     bool m_main = false;            // main switch: --main
@@ -299,10 +313,12 @@ private:
     bool m_threadsCoarsen = true;   // main switch: --threads-coarsen
     bool m_threadsDpiPure = true;   // main switch: --threads-dpi all/pure
     bool m_threadsDpiUnpure = false;  // main switch: --threads-dpi all
+    bool m_threadsDynamic = false;  // main switch: --threads-dynamic
     VOptionBool m_timing;           // main switch: --timing
     bool m_trace = false;           // main switch: --trace
     bool m_traceCoverage = false;   // main switch: --trace-coverage
     bool m_traceParams = true;      // main switch: --trace-params
+    bool m_traceScopeEnable = false;  // main switch: --trace-scope-enable
     bool m_traceStructs = false;    // main switch: --trace-structs
     bool m_noTraceTop = false;      // main switch: --no-trace-top
     bool m_traceUnderscore = false; // main switch: --trace-underscore
@@ -328,6 +344,7 @@ private:
     int         m_localizeMaxSize = 1024;  // main switch: --localize-max-size
     VOptionBool m_makeDepend;  // main switch: -MMD
     int         m_maxNumWidth = 65536;  // main switch: --max-num-width
+    int         m_mmpiLookahead = 0;  // main switch: --mmpi-lookahead
     int         m_moduleRecursion = 100;  // main switch: --module-recursion-depth
     int         m_outputGroups = -1;  // main switch: --output-groups
     int         m_outputSplit = 20000;  // main switch: --output-split
@@ -349,6 +366,7 @@ private:
     TraceFormat m_traceFormat;  // main switch: --trace or --trace-fst
     int         m_traceMaxArray = 32;  // main switch: --trace-max-array
     int         m_traceMaxWidth = 256; // main switch: --trace-max-width
+    int         m_traceShards = 1;  // main switch: --trace-shards
     int         m_traceThreads = 0; // main switch: --trace-threads
     int         m_unrollCount = 64;  // main switch: --unroll-count
     int         m_unrollStmts = 30000;  // main switch: --unroll-stmts
@@ -368,6 +386,7 @@ private:
     string      m_libCreate;    // main switch: --lib-create {lib_name}
     string      m_mainTopName;  // main switch: --main-top-name
     string      m_makeDir;      // main switch: -Mdir
+    string      m_mmpiClock;    // main switch: --mmpi-clock
     string      m_modPrefix;    // main switch: --mod-prefix
     string      m_pipeFilter;   // main switch: --pipe-filter
     string      m_prefix;       // main switch: --prefix
@@ -537,15 +556,30 @@ public:
     bool mmpio1() const { return m_mmpio1; }
     bool mmpixml() const { return m_mmpixml; }
     bool mmpimk() const { return m_mmpimk; }
+    string mmpiClock() const { return m_mmpiClock; }
+    int mmpiLookahead() const { return m_mmpiLookahead; }
+    bool mmpiNonBlocking() const { return m_mmpiNonBlocking; }
+    bool mmpiPack() const { return m_mmpiPack; }
+    bool mmpiDelta() const { return m_mmpiDelta; }
+    bool mmpiCheckpoint() const { return m_mmpiCheckpoint; }
+    bool mmpiProf() const { return m_mmpiProf; }
+    bool mmpiReport() const { return m_mmpiReport; }
+    int mmpiRanks() const { return m_mmpiRanks; }
+    int mmpiInstancesPerRank() const { return m_mmpiInstancesPerRank; }
+    int mmpiRanksPerNode() const { return m_mmpiRanksPerNode; }
+    string mmpiProfile() const { return m_mmpiProfile; }
+    const V3StringSet& mmpiLatencyInsensitive() const { return m_mmpiLatencyInsensitive; }
     bool d1() const { return m_d1; }
     bool d2() const { return m_d2; }
     bool threadsDpiPure() const { return m_threadsDpiPure; }
     bool threadsDpiUnpure() const { return m_threadsDpiUnpure; }
+    bool threadsDynamic() const { return m_threadsDynamic; }
     bool threadsCoarsen() const { return m_threadsCoarsen; }
     VOptionBool timing() const { return m_timing; }
     bool trace() const { return m_trace; }
     bool traceCoverage() const { return m_traceCoverage; }
     bool traceParams() const { return m_traceParams; }
+    bool traceScopeEnable() const { return m_traceScopeEnable; }
     bool traceStructs() const { return m_traceStructs; }
     bool traceUnderscore() const { return m_traceUnderscore; }
     bool main() const { return m_main; }
@@ -619,16 +653,21 @@ public:
     VTimescale timeComputeUnit(const VTimescale& flag) const;
     int traceDepth() const { return m_traceDepth; }
     TraceFormat traceFormat() const { return m_traceFormat; }
+    bool traceEnabledBin() const { return trace() && traceFormat().bin(); }
     bool traceEnabledFst() const { return trace() && traceFormat().fst(); }
     bool traceEnabledSaif() const { return trace() && traceFormat().saif(); }
     bool traceEnabledVcd() const { return trace() && traceFormat().vcd(); }
     int traceMaxArray() const { return m_traceMaxArray; }
     int traceMaxWidth() const { return m_traceMaxWidth; }
+    int traceShards() const { return m_traceShards; }
     int traceThreads() const { return m_traceThreads; }
     bool useTraceOffload() const { return trace() && traceFormat().fst() && traceThreads() > 1; }
     bool useTraceParallel() const {
-        return trace() && traceFormat().vcd() && (threads() > 1 || hierChild() > 1);
+        return trace()
+               && ((traceFormat().vcd() && (threads() > 1 || hierChild() > 1))
+                   || useTraceShards());
     }
+    bool useTraceShards() const { return trace() && traceFormat().fst() && traceShards() > 1; }
     bool useFstWriterThread() const { return traceThreads() && traceFormat().fst(); }
     unsigned vmTraceThreads() const {
         return useTraceParallel() ? threads() : useTraceOffload() ? 1 : 0;
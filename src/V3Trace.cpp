@@ -116,16 +116,19 @@ public:
 class TraceTraceVertex final : public V3GraphVertex {
     VL_RTTI_IMPL(TraceTraceVertex, V3GraphVertex)
     AstTraceDecl* const m_nodep;  // TRACEINC this represents
+    AstCFunc* const m_initFuncp;  // Trace initialization function declaring the signal
     // nullptr, or other vertex with the real code() that duplicates this one
     TraceTraceVertex* m_duplicatep = nullptr;
 
 public:
-    TraceTraceVertex(V3Graph* graphp, AstTraceDecl* nodep)
+    TraceTraceVertex(V3Graph* graphp, AstTraceDecl* nodep, AstCFunc* initFuncp)
         : V3GraphVertex{graphp}
-        , m_nodep{nodep} {}
+        , m_nodep{nodep}
+        , m_initFuncp{initFuncp} {}
     ~TraceTraceVertex() override = default;
     // ACCESSORS
     AstTraceDecl* nodep() const { return m_nodep; }
+    AstCFunc* initFuncp() const { return m_initFuncp; }
     string name() const override { return nodep()->name(); }
     string dotColor() const override { return "red"; }
     FileLine* fileline() const override { return nodep()->fileline(); }
@@ -184,14 +187,19 @@ class TraceVisitor final : public VNVisitor {
     TraceActivityVertex* const m_alwaysVtxp;  // "Always trace" vertex
     bool m_finding = false;  // Pass one of algorithm?
 
-    // Trace parallelism. Only VCD tracing can be parallelized at this time.
+    // Trace parallelism. Only VCD tracing, and FST tracing split into multiple
+    // files, can be parallelized at this time. With FST, each function writes one file.
     const uint32_t m_parallelism
-        = v3Global.opt.useTraceParallel() ? static_cast<uint32_t>(v3Global.opt.threads()) : 1;
+        = v3Global.opt.useTraceShards()
+              ? static_cast<uint32_t>(v3Global.opt.traceShards())
+              : v3Global.opt.useTraceParallel() ? static_cast<uint32_t>(v3Global.opt.threads())
+                                                : 1;
 
     VDouble0 m_statSetters;  // Statistic tracking
     VDouble0 m_statSettersSlow;  // Statistic tracking
     VDouble0 m_statUniqCodes;  // Statistic tracking
     VDouble0 m_statUniqSigs;  // Statistic tracking
+    VDouble0 m_statGroups;  // Statistic tracking
 
     // All activity numbers applying to a given trace
     using ActCodeSet = std::set<uint32_t>;
@@ -626,6 +634,17 @@ class TraceVisitor final : public VNVisitor {
         const int splitLimit = v3Global.opt.outputSplitCTrace() ? v3Global.opt.outputSplitCTrace()
                                                                 : std::numeric_limits<int>::max();
 
+        // With --trace-scope-enable, signals of one scope with the same activity are dumped as a
+        // group, guarded by a runtime enable, so a scope disabled with traceScopeEnable costs
+        // one check per group.
+        const bool scopeEnable = v3Global.opt.traceScopeEnable();
+        struct Group final {
+            AstCFunc* m_initFuncp;  // Initialization function registering the group
+            uint32_t m_code;  // First code of group
+            uint32_t m_endCode;  // One past last code of group
+        };
+        std::vector<Group> groups;
+
         // pre-incremented, so starts at 0
         uint32_t topFuncNum = std::numeric_limits<uint32_t>::max();
         TraceVec::const_iterator it = traces.begin();
@@ -639,7 +658,9 @@ class TraceVisitor final : public VNVisitor {
             const uint32_t maxCodes = std::max((nAllCodes + parallelism - 1) / parallelism, 1U);
             uint32_t nCodes = 0;
             const ActCodeSet* prevActSet = nullptr;
+            const AstCFunc* prevInitFuncp = nullptr;
             AstIf* ifp = nullptr;
+            AstIf* fulIfp = nullptr;
             uint32_t baseCode = 0;
             for (; nCodes < maxCodes && it != traces.end(); ++it) {
                 const ActCodeSet& actSet = it->first;
@@ -674,19 +695,33 @@ class TraceVisitor final : public VNVisitor {
                     ifp = nullptr;
                 }
 
-                // If required, create the conditional node checking the activity flags
-                if (!prevActSet || actSet != *prevActSet) {
+                // If required, create the conditional node checking the activity flags,
+                // and with --trace-scope-enable start a new group checking its enable
+                if (!prevActSet || actSet != *prevActSet
+                    || (scopeEnable && vtxp->initFuncp() != prevInitFuncp)) {
                     FileLine* const flp = m_topScopep->fileline();
                     const bool always = actSet.count(TraceActivityVertex::ACTIVITY_ALWAYS) != 0;
                     AstNodeExpr* condp = nullptr;
-                    if (always) {
-                        condp = new AstConst{flp, 1};  // Always true, will be folded later
-                    } else {
+                    if (!always) {
                         for (const uint32_t actCode : actSet) {
                             AstNodeExpr* const selp = selectActivity(flp, actCode, VAccess::READ);
                             condp = condp ? new AstOr{flp, condp, selp} : selp;
                         }
                     }
+                    if (scopeEnable) {
+                        AstNodeExpr* const enp
+                            = new AstCExpr{flp,
+                                           "bufp->groupEnabled(vlSymsp->__Vm_baseCode + "
+                                               + cvtToStr(declp->code()) + ")",
+                                           1};
+                        fulIfp = new AstIf{flp, enp->cloneTree(false)};
+                        subFulFuncp->addStmtsp(fulIfp);
+                        condp = condp ? new AstLogAnd{flp, condp, enp} : enp;
+                        prevInitFuncp = vtxp->initFuncp();
+                        groups.push_back({vtxp->initFuncp(), declp->code(), declp->code()});
+                        ++m_statGroups;
+                    }
+                    if (!condp) condp = new AstConst{flp, 1};  // Always true, will be folded later
                     ifp = new AstIf{flp, condp};
                     if (!always) ifp->branchPred(VBranchPred::BP_UNLIKELY);
                     subChgFuncp->addStmtsp(ifp);
@@ -697,7 +732,11 @@ class TraceVisitor final : public VNVisitor {
                 // Add TraceInc nodes
                 FileLine* const flp = declp->fileline();
                 AstTraceInc* const incFulp = new AstTraceInc{flp, declp, VTraceType::FULL};
-                subFulFuncp->addStmtsp(incFulp);
+                if (fulIfp) {
+                    fulIfp->addThensp(incFulp);
+                } else {
+                    subFulFuncp->addStmtsp(incFulp);
+                }
                 AstTraceInc* const incChgp
                     = new AstTraceInc{flp, declp, VTraceType::CHANGE, baseCode};
                 ifp->addThensp(incChgp);
@@ -718,8 +757,17 @@ class TraceVisitor final : public VNVisitor {
 
                 // Track partitioning
                 nCodes += declp->codeInc();
+                if (scopeEnable) groups.back().m_endCode = declp->code() + declp->codeInc();
             }
         }
+
+        // Register the groups when the signals are declared
+        for (const Group& group : groups) {
+            group.m_initFuncp->addStmtsp(new AstCStmt{
+                group.m_initFuncp->fileline(),
+                "tracep->declGroup(vlSymsp->__Vm_baseCode + " + cvtToStr(group.m_code)
+                    + ", vlSymsp->__Vm_baseCode + " + cvtToStr(group.m_endCode) + ");\n"});
+        }
     }
 
     void createCleanupFunction() {
@@ -890,10 +938,10 @@ class TraceVisitor final : public VNVisitor {
     void visit(AstTraceDecl* nodep) override {
         UINFO(8, "   TRACE " << nodep << endl);
         if (!m_finding) {
-            V3GraphVertex* const vertexp = new TraceTraceVertex{&m_graph, nodep};
+            UASSERT_OBJ(m_cfuncp, nodep, "Trace not under func");
+            V3GraphVertex* const vertexp = new TraceTraceVertex{&m_graph, nodep, m_cfuncp};
             nodep->user1p(vertexp);
 
-            UASSERT_OBJ(m_cfuncp, nodep, "Trace not under func");
             VL_RESTORER(m_tracep);
             m_tracep = nodep;
             iterateChildren(nodep);
@@ -937,6 +985,7 @@ public:
         V3Stats::addStat("Tracing, Activity slow blocks", m_statSettersSlow);
         V3Stats::addStat("Tracing, Unique trace codes", m_statUniqCodes);
         V3Stats::addStat("Tracing, Unique traced signals", m_statUniqSigs);
+        V3Stats::addStat("Tracing, Enable groups", m_statGroups);
     }
 };
 
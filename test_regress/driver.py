@@ -1021,6 +1021,11 @@ class VlTest:
                 self.trace_format = 'saif-sc'  # pylint: disable=attribute-defined-outside-init
             else:
                 self.trace_format = 'saif-c'  # pylint: disable=attribute-defined-outside-init
+        elif re.search(r'-trace-bin', checkflags):
+            if self.sc:
+                self.trace_format = 'bin-sc'  # pylint: disable=attribute-defined-outside-init
+            else:
+                self.trace_format = 'bin-c'  # pylint: disable=attribute-defined-outside-init
         elif self.sc:
             self.trace_format = 'vcd-sc'  # pylint: disable=attribute-defined-outside-init
         else:
@@ -1577,6 +1582,8 @@ class VlTest:
             return self.obj_dir + "/simx.fst"
         if re.match(r'^saif', self.trace_format):
             return self.obj_dir + "/simx.saif"
+        if re.match(r'^bin', self.trace_format):
+            return self.obj_dir + "/simx.bin"
         return self.obj_dir + "/simx.vcd"
 
     def skip_if_too_few_cores(self) -> None:
@@ -1904,6 +1911,10 @@ class VlTest:
                 fh.write("#include \"verilated_saif_c.h\"\n")
             if self.trace and self.trace_format == 'saif-sc':
                 fh.write("#include \"verilated_saif_sc.h\"\n")
+            if self.trace and self.trace_format == 'bin-c':
+                fh.write("#include \"verilated_bin_c.h\"\n")
+            if self.trace and self.trace_format == 'bin-sc':
+                fh.write("#include \"verilated_bin_sc.h\"\n")
             if self.savable:
                 fh.write("#include \"verilated_save.h\"\n")
 
@@ -1991,6 +2002,10 @@ class VlTest:
                     fh.write("    std::unique_ptr<VerilatedSaifC> tfp{new VerilatedSaifC};\n")
                 if self.trace_format == 'saif-sc':
                     fh.write("    std::unique_ptr<VerilatedSaifSc> tfp{new VerilatedSaifSc};\n")
+                if self.trace_format == 'bin-c':
+                    fh.write("    std::unique_ptr<VerilatedBinC> tfp{new VerilatedBinC};\n")
+                if self.trace_format == 'bin-sc':
+                    fh.write("    std::unique_ptr<VerilatedBinSc> tfp{new VerilatedBinSc};\n")
                 if self.sc:
                     fh.write("    sc_core::sc_start(sc_core::SC_ZERO_TIME);" +
                              "  // Finish elaboration before trace and open\n")
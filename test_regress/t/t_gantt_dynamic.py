@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+# Test for bin/verilator_gantt with --threads-dynamic
+
+import vltest_bootstrap
+
+test.scenarios('vltmt')
+test.top_filename = "t/t_gen_alw.v"  # Any, as long as runs a few cycles
+
+test.compile(v_flags2=["--prof-exec", "--threads-dynamic", "--stats"], threads=2)
+
+test.file_grep(test.stats, r'Optimizations, Thread schedule dynamic\s+(\d+)')
+
+test.execute(all_run_flags=[
+    "+verilator+prof+exec+start+2",
+    " +verilator+prof+exec+window+2",
+    " +verilator+prof+exec+file+" + test.obj_dir + "/profile_exec.dat"])  # yapf:disable
+
+# Every mtask runs once per evaluation, whichever thread takes it
+test.file_grep(test.obj_dir + "/profile_exec.dat", r'MTASK_BEGIN')
+test.file_grep_not(test.obj_dir + "/profile_exec.dat", r'Unknown')
+
+gantt_log = test.obj_dir + "/gantt.log"
+
+test.run(cmd=[
+    os.environ["VERILATOR_ROOT"] + "/bin/verilator_gantt", test.obj_dir + "/profile_exec.dat",
+    "--vcd " + test.obj_dir + "/profile_exec.vcd", "| tee " + gantt_log
+])
+
+test.file_grep(gantt_log, r'Total threads += 2')
+test.file_grep(gantt_log, r'Total mtasks += 7')
+test.file_grep(gantt_log, r'\|\s+2\s+\|\s+2\.0+\s+\|\s+eval')
+
+test.passes()
@@ -0,0 +1,44 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+# Test for bin/verilator_gantt, with hot spinning worker threads
+
+import vltest_bootstrap
+
+test.scenarios('vltmt')
+test.top_filename = "t/t_gen_alw.v"  # Any, as long as runs a few cycles
+
+test.compile(v_flags2=["--prof-exec"], threads=2)
+
+test.execute(all_run_flags=[
+    "+verilator+threads+spin+1",
+    " +verilator+prof+exec+start+2",
+    " +verilator+prof+exec+window+2",
+    " +verilator+prof+exec+file+" + test.obj_dir + "/profile_exec.dat"])  # yapf:disable
+
+# The worker spin statistics are recorded in the profile
+profile = test.obj_dir + "/profile_exec.dat"
+test.file_grep(profile, r'^VLPROF stat yieldticks \d+$')
+test.file_grep(profile, r'^VLPROF stat spinticks \d+$')
+test.file_grep(profile, r'^VLPROF stat parkticks \d+$')
+test.file_grep(profile, r'^VLPROF stat parks \d+$')
+
+gantt_log = test.obj_dir + "/gantt.log"
+
+test.run(cmd=[
+    os.environ["VERILATOR_ROOT"] + "/bin/verilator_gantt", profile, "--no-vcd",
+    "| tee " + gantt_log
+])
+
+test.file_grep(gantt_log, r'Total threads += 2')
+test.file_grep(gantt_log, r'Yield time += \d+ rdtsc ticks')
+test.file_grep(gantt_log, r'Worker spin time += \d+ rdtsc ticks')
+test.file_grep(gantt_log, r'Worker park time += \d+ rdtsc ticks in \d+ parks')
+
+test.passes()
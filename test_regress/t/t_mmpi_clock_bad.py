@@ -0,0 +1,20 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt')
+test.top_filename = "t/t_flag_werror.v"
+
+test.lint(fails=True, verilator_flags2=["--mmpi-clock clk", "--mmpi-instances-per-rank 2"])
+
+test.file_grep(test.compile_log_filename,
+               r'%Error: --mmpi-instances-per-rank cannot be used together with --mmpi-clock')
+
+test.passes()
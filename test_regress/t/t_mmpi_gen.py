@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt')
+
+# The generators write to metro_mpi/ under the current directory
+test.run(logfile=test.obj_dir + "/vlt_mmpi.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", os.environ["VERILATOR_ROOT"] + "/bin/verilator",
+              "--lint-only", "--mmpi-o1", "--mmpi-report",
+              "../../" + test.top_filename],
+         verilator_run=True)  # yapf:disable
+
+mmpi_dir = test.obj_dir + "/metro_mpi"
+
+test.file_grep(test.obj_dir + "/vlt_mmpi.log", r'Selected 2 partition\(s\) under \'\$root.t\'')
+
+test.file_grep(mmpi_dir + "/partition_report.json", r'"boundary_clock": ""')
+test.file_grep(mmpi_dir + "/partition_report.json", r'"lookahead": 0')
+test.file_grep(mmpi_dir + "/modified_tile.v", r'import "DPI-C" function void dpi_tile\(')
+test.file_grep(mmpi_dir + "/modified_tile.v", r'always @\(\*\)')
+test.file_grep(mmpi_dir + "/u0_tile_wrapper.v", r'modified_tile')
+test.file_grep(mmpi_dir + "/u1_tile_wrapper.v", r'modified_tile')
+test.file_grep(mmpi_dir + "/modified_t.v", r'u0_tile_wrapper')
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'mpi_send_rank_1_to_0')
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'mpi_send_rank_2_to_0')
+test.file_grep(mmpi_dir + "/rank0_harness.h", r'metro_mpi_ctrl')
+test.file_grep(mmpi_dir + "/tile_main.cpp", r'#include "metro_mpi.cpp"')
+test.glob_one(mmpi_dir + "/README_integration.txt")
+
+# None of the optional modes are on by default
+test.file_grep_not(mmpi_dir + "/modified_tile.v", r'posedge')
+test.file_grep_not(mmpi_dir + "/metro_mpi.cpp", r'MPI_Send_init')
+test.file_grep_not(mmpi_dir + "/metro_mpi.cpp", r'mpi_pack_rank_')
+test.file_grep_not(mmpi_dir + "/metro_mpi.cpp", r'mpi_delta_encode_rank_')
+test.file_grep_not(mmpi_dir + "/metro_mpi.cpp", r'METRO_MPI_CTRL_SAVE')
+test.file_grep_not(mmpi_dir + "/metro_mpi.cpp", r'metro_mpi_prof_report')
+test.file_grep_not(mmpi_dir + "/tile_main.cpp", r'send_system_outputs')
+test.file_grep_not(mmpi_dir + "/tile_main.cpp", r'VlThreadPool')
+test.passes()
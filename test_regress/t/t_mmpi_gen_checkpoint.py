@@ -0,0 +1,34 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt')
+test.top_filename = "t/t_mmpi_gen.v"
+
+# The generators write to metro_mpi/ under the current directory
+test.run(logfile=test.obj_dir + "/vlt_mmpi.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", os.environ["VERILATOR_ROOT"] + "/bin/verilator",
+              "--lint-only", "--mmpi-o1", "--mmpi-report", "--savable", "--mmpi-checkpoint",
+              "../../" + test.top_filename],
+         verilator_run=True)  # yapf:disable
+
+mmpi_dir = test.obj_dir + "/metro_mpi"
+
+test.file_grep(mmpi_dir + "/partition_report.json", r'"checkpoint": true')
+
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'METRO_MPI_CTRL_SAVE')
+test.file_grep(mmpi_dir + "/tile_main.cpp", r'void save_partition_1\(')
+test.file_grep(mmpi_dir + "/tile_main.cpp", r'void restore_partition_2\(')
+test.file_grep(mmpi_dir + "/rank0_harness.h", r'void metro_mpi_checkpoint\(')
+test.file_grep(mmpi_dir + "/rank0_harness.h", r'bool metro_mpi_restore\(')
+test.file_grep(mmpi_dir + "/Makefile.tile", r'VERILATOR_FLAGS = .*--savable')
+
+test.passes()
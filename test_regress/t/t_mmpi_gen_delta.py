@@ -0,0 +1,30 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt')
+test.top_filename = "t/t_mmpi_gen.v"
+
+# The generators write to metro_mpi/ under the current directory
+test.run(logfile=test.obj_dir + "/vlt_mmpi.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", os.environ["VERILATOR_ROOT"] + "/bin/verilator",
+              "--lint-only", "--mmpi-o1", "--mmpi-report", "--mmpi-delta",
+              "../../" + test.top_filename],
+         verilator_run=True)  # yapf:disable
+
+mmpi_dir = test.obj_dir + "/metro_mpi"
+
+test.file_grep(mmpi_dir + "/partition_report.json", r'"delta": true')
+
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'mpi_delta_encode_rank_1_to_2\(')
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'mpi_delta_decode_rank_1_to_2\(')
+
+test.passes()
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt')
+
+# The generators write to metro_mpi/ under the current directory
+test.run(logfile=test.obj_dir + "/vlt_mmpi.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", os.environ["VERILATOR_ROOT"] + "/bin/verilator",
+              "--lint-only", "--mmpi-o1", "--mmpi-report",
+              "../../" + test.top_filename],
+         verilator_run=True)  # yapf:disable
+
+mmpi_dir = test.obj_dir + "/metro_mpi"
+
+# Splitting the clusters beats offloading them whole, so the tiles of both move
+test.file_grep(test.obj_dir + "/vlt_mmpi.log",
+               r'Selected 4 partition\(s\) under \'\$root.t.c0\', \'\$root.t.c1\'')
+
+# The instances share their names, so the partitions are named after their paths
+for name in ["c0_u0", "c0_u1", "c1_u0", "c1_u1"]:
+    test.glob_one(mmpi_dir + "/" + name + "_tile_wrapper.v")
+test.file_grep(mmpi_dir + "/partition_report.json", r'"instance_hier": "\$root.t.c1.u0"')
+
+# Both clusters live in one file, rewritten once, each only in its own body
+test.file_grep(mmpi_dir + "/modified_left.v", r'c0_u1_tile_wrapper u1 \(')
+test.file_grep(mmpi_dir + "/modified_left.v", r'c1_u0_tile_wrapper u0 \(')
+test.file_grep_not(mmpi_dir + "/modified_left.v", r'^ *tile u')
+if os.path.exists(mmpi_dir + "/modified_right.v"):
+    test.error("modified_right.v written for a parent already in modified_left.v")
+
+# Partitions under one parent talk directly, those under different parents
+# through rank 0
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'mpi_send_rank_1_to_2')
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'mpi_send_rank_3_to_4')
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'mpi_send_rank_2_to_0')
+test.file_grep_not(mmpi_dir + "/metro_mpi.cpp", r'mpi_send_rank_2_to_3')
+
+test.passes()
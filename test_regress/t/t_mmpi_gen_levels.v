@@ -0,0 +1,76 @@
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2025 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+// Two clusters under the top, each holding two heavy tiles with the same
+// instance names, so the Metro-MPI partitioning cuts under both clusters.
+
+module t (/*AUTOARG*/
+   // Outputs
+   sum,
+   // Inputs
+   clk, in
+   );
+   input clk;
+   input [31:0] in;
+   output [31:0] sum;
+
+   wire [31:0] q0;
+
+   left c0 (.clk(clk), .a(in), .q(q0));
+   right c1 (.clk(clk), .a(q0), .q(sum));
+endmodule
+
+module left (/*AUTOARG*/
+   // Outputs
+   q,
+   // Inputs
+   clk, a
+   );
+   input clk;
+   input [31:0] a;
+   output [31:0] q;
+
+   wire [31:0] m;
+
+   tile u0 (.clk(clk), .a(a), .q(m));
+   tile u1 (.clk(clk), .a(m), .q(q));
+endmodule
+
+module right (/*AUTOARG*/
+   // Outputs
+   q,
+   // Inputs
+   clk, a
+   );
+   input clk;
+   input [31:0] a;
+   output [31:0] q;
+
+   wire [31:0] m;
+
+   tile u1 (.clk(clk), .a(m), .q(q));
+   tile u0 (.clk(clk), .a(a), .q(m));
+endmodule
+
+module tile (/*AUTOARG*/
+   // Outputs
+   q,
+   // Inputs
+   clk, a
+   );
+   input clk;
+   input [31:0] a;
+   output reg [31:0] q;
+
+   reg [31:0] acc;
+   reg [31:0] mix;
+
+   always @(posedge clk) begin
+      acc <= acc * 32'd3 + a;
+      mix <= (mix << 5) ^ (mix >> 3) ^ acc ^ 32'h9e3779b9;
+      q <= acc ^ (mix >> 7) ^ (mix << 11) ^ (acc + mix);
+   end
+endmodule
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt')
+test.top_filename = "t/t_mmpi_gen.v"
+
+# The generators write to metro_mpi/ under the current directory
+test.run(logfile=test.obj_dir + "/vlt_mmpi.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", os.environ["VERILATOR_ROOT"] + "/bin/verilator",
+              "--lint-only", "--mmpi-o1", "--mmpi-report",
+              "--mmpi-clock", "clk", "--mmpi-lookahead", "2",
+              "--mmpi-latency-insensitive", "tile.q",
+              "--mmpi-latency-insensitive", "tile.nope",
+              "../../" + test.top_filename],
+         verilator_run=True)  # yapf:disable
+
+mmpi_dir = test.obj_dir + "/metro_mpi"
+
+test.file_grep(test.obj_dir + "/vlt_mmpi.log",
+               r"--mmpi-latency-insensitive 'tile.nope' is not an output of a partition module")
+
+test.file_grep(mmpi_dir + "/partition_report.json", r'"lookahead": 2')
+test.file_grep(mmpi_dir + "/partition_report.json", r'"latency_insensitive": "Yes"')
+
+# The links fed by the annotated tile.q are primed with two cycles of reset outputs
+test.file_grep(mmpi_dir + "/tile_main.cpp", r'void prime_outputs_from_rank_1\(')
+test.file_grep(mmpi_dir + "/tile_main.cpp", r'mpi_prime_rank_1_to_2\(resp_to_2, 2\);')
+test.file_grep(mmpi_dir + "/metro_mpi.cpp", r'mpi_prime_rank_1_to_2')
+
+test.passes()
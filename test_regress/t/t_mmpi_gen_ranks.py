@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt')
+test.top_filename = "t/t_mmpi_gen.v"
+
+# The generators write to metro_mpi/ under the current directory
+test.run(logfile=test.obj_dir + "/vlt_mmpi.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", os.environ["VERILATOR_ROOT"] + "/bin/verilator",
+              "--lint-only", "--mmpi-o1", "--mmpi-ranks", "2",
+              "../../" + test.top_filename],
+         verilator_run=True)  # yapf:disable
+
+mmpi_dir = test.obj_dir + "/metro_mpi"
+
+# Rank 0 and one partition rank: only the first of the two equal tiles moves
+test.file_grep(test.obj_dir + "/vlt_mmpi.log", r'Selected 1 partition\(s\)')
+test.file_grep(test.obj_dir + "/vlt_mmpi.log", r'Module: tile, Instance: u0,')
+test.file_grep_not(test.obj_dir + "/vlt_mmpi.log", r'Module: tile, Instance: u1,')
+
+test.glob_one(mmpi_dir + "/u0_tile_wrapper.v")
+test.file_grep(mmpi_dir + "/modified_t.v", r'tile u1')
+test.file_grep_not(mmpi_dir + "/metro_mpi.cpp", r'mpi_send_rank_2_to_0')
+
+# Without --mmpi-report the analysis stays in memory
+if os.path.exists(mmpi_dir + "/partition_report.json"):
+    test.error("partition_report.json written without --mmpi-report")
+
+test.passes()
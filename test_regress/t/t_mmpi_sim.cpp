@@ -0,0 +1,65 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2025 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+// Rank 0 testbench of the Metro-MPI simulation tests.  Built with
+// T_MMPI_REFERENCE, the same testbench drives the design in place.
+
+#include <verilated.h>
+
+#include <cstdio>
+#include <memory>
+
+#include "Vt.h"
+
+#ifndef T_MMPI_REFERENCE
+#include "metro_mpi/rank0_harness.h"
+#endif
+
+int main(int argc, char** argv) {
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    contextp->commandArgs(argc, argv);
+#ifndef T_MMPI_REFERENCE
+    mpi_initialize();
+#endif
+    const std::unique_ptr<Vt> topp{new Vt{contextp.get(), "top"}};
+
+    uint32_t cyc = 0;
+    topp->clk = 0;
+    topp->in = 0;
+#ifdef T_MMPI_CHECKPOINT
+    // A restored run continues after the cycle that wrote the checkpoint
+    const bool restored
+        = metro_mpi_restore([&](VerilatedDeserialize& os) { os >> *topp >> cyc; });
+    if (!restored) topp->eval();
+#else
+    topp->eval();
+#endif
+
+    for (; cyc < 40; ++cyc) {
+#ifdef T_MMPI_CHECKPOINT
+        if (cyc == 20 && !restored) {
+            metro_mpi_checkpoint([&](VerilatedSerialize& os) { os << *topp << cyc; });
+        }
+#endif
+        // The input changes with the clock, as registered logic feeding it would
+        topp->in = cyc * 0x01010101U + 7;
+        topp->clk = 1;
+        topp->eval();
+        topp->clk = 0;
+        topp->eval();
+        printf("sum %u %08x\n", cyc, topp->sum);
+    }
+
+    topp->final();
+#ifndef T_MMPI_REFERENCE
+    metro_mpi_broadcast_shutdown();
+    mpi_finalize();
+#endif
+    printf("*-* All Finished *-*\n");
+    return 0;
+}
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+# Partitions t_mmpi_gen.v, builds the generated partition main and rank 0,
+# runs them, and compares the outputs with the design simulated in place.
+# The t_mmpi_sim_*.py tests run this one with other settings of:
+#   mmpi_flags      Metro-MPI options of the partitioning run
+#   mmpi_transport  "shm" (processes started here) or "mpi" (mpirun)
+#   mmpi_lag        Cycles the outputs trail the design in place, or None
+#                   when they may differ and only have to keep changing
+#   mmpi_top        Design partitioned, with the ports of t_mmpi_gen.v
+
+import vltest_bootstrap
+import shutil
+
+test.scenarios('vlt')
+test.pli_filename = "t/t_mmpi_sim.cpp"
+
+mmpi_flags = globals().get('mmpi_flags', ["--mmpi-clock", "clk"])
+mmpi_transport = globals().get('mmpi_transport', "shm")
+mmpi_lag = globals().get('mmpi_lag', 0)
+test.top_filename = globals().get('mmpi_top', "t/t_mmpi_gen.v")
+
+mmpi_checkpoint = "--mmpi-checkpoint" in mmpi_flags
+mmpi_prof = "--mmpi-prof" in mmpi_flags
+verilator = os.environ["VERILATOR_ROOT"] + "/bin/verilator"
+
+if mmpi_transport == "mpi" and not (shutil.which("mpirun") and shutil.which("mpic++")):
+    test.skip("No MPI")
+
+# The generators write to metro_mpi/ under the current directory
+test.run(logfile=test.obj_dir + "/vlt_mmpi.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", verilator, "--lint-only", "--mmpi-o1", *mmpi_flags,
+              "../../" + test.top_filename],
+         verilator_run=True)  # yapf:disable
+
+# The partition main, through its generated Makefile; the model cache is off so
+# no run shares models with another
+test.run(logfile=test.obj_dir + "/vlt_mmpi_partition.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "PATH=" + os.environ["VERILATOR_ROOT"] + "/bin:$PATH",
+              os.environ["MAKE"], "-f", "metro_mpi/Makefile.tile",
+              "METRO_MPI_TRANSPORT=" + mmpi_transport, "METRO_MPI_CACHE=",
+              "|| { cat build_library.log; false; }"],
+         verilator_run=True)  # yapf:disable
+
+build_flags = ["--cc", "--exe", "--build", "--top-module", "t", "-CFLAGS", "-I.."]
+if mmpi_checkpoint:
+    build_flags += ["--savable", "-CFLAGS", "-DT_MMPI_CHECKPOINT"]
+if mmpi_transport == "shm":
+    rank0_flags = ["-CFLAGS", "-DMETRO_MPI_SHM", "-LDFLAGS", "-lrt"]
+else:
+    rank0_flags = ["-MAKEFLAGS", "CXX=mpic++", "-MAKEFLAGS", "LINK=mpic++"]
+
+# Rank 0: the rewritten parents, the partition stub and a wrapper per instance
+rank0_sources = [
+    "metro_mpi/" + os.path.basename(filename)
+    for filename in sorted(test.glob_some(test.obj_dir + "/metro_mpi/modified_*.v") +
+                           test.glob_some(test.obj_dir + "/metro_mpi/*_wrapper.v"))
+]
+test.run(logfile=test.obj_dir + "/vlt_mmpi_rank0.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", verilator, *build_flags, *rank0_flags, "--Mdir", "obj_rank0",
+              *rank0_sources, "../../" + test.pli_filename],
+         verilator_run=True)  # yapf:disable
+
+test.run(logfile=test.obj_dir + "/vlt_mmpi_reference.log",
+         cmd=["cd " + test.obj_dir + " &&",
+              "perl", verilator, *build_flags, "-CFLAGS", "-DT_MMPI_REFERENCE",
+              "--Mdir", "obj_reference", "../../" + test.top_filename,
+              "../../" + test.pli_filename],
+         verilator_run=True)  # yapf:disable
+
+test.run(logfile=test.obj_dir + "/reference.log",
+         cmd=[test.obj_dir + "/obj_reference/Vt"],
+         check_finished=True)
+
+ranks = int(test.file_grep(test.obj_dir + "/metro_mpi/metro_mpi.cpp",
+                           r'constexpr int mpi_shm_ranks = (\d+);')[0][0])
+
+
+# Every job gets its own segment, so an aborted one cannot block the next
+shm_name = test.name + "_" + str(os.getpid())
+
+
+def run_ranks(logname, env=""):
+    """Run rank 0 and the partition ranks; rank 0 logs to logname"""
+    if mmpi_transport == "shm":
+        shell = ("export " + env + " METRO_MPI_SIZE=" + str(ranks) + " METRO_MPI_SHM_NAME=/" +
+                 shm_name + " && pids= && for r in $(seq 1 " +
+                 str(ranks - 1) + "); do METRO_MPI_RANK=$r timeout 600 obj_dir_tile/Vtile > " +
+                 logname + ".$r 2>&1 & pids=\"$pids $!\"; done; METRO_MPI_RANK=0 timeout 600 " +
+                 "obj_rank0/Vt > " + logname + " 2>&1; status=$?; " +
+                 "for p in $pids; do wait $p || status=1; done; exit $status")
+    else:
+        # Open MPI refuses more ranks than cores, or running as root, without these
+        shell = ("export " + env + " OMPI_MCA_rmaps_base_oversubscribe=1" +
+                 " OMPI_ALLOW_RUN_AS_ROOT=1 OMPI_ALLOW_RUN_AS_ROOT_CONFIRM=1 && timeout 600 " +
+                 "mpirun -np 1 obj_rank0/Vt : -np " + str(ranks - 1) + " obj_dir_tile/Vtile > " +
+                 logname + " 2>&1")
+    test.run(logfile=test.obj_dir + "/" + logname + ".run",
+             cmd=["cd " + test.obj_dir + " && { " + shell + "; }"])
+    test.file_grep(test.obj_dir + "/" + logname, r'\*-\* All Finished \*-\*')
+    # Rank 0 removes the segment when the job ends
+    if mmpi_transport == "shm" and os.path.exists("/dev/shm/" + shm_name):
+        test.error(logname + ": shared memory /" + shm_name + " left behind")
+
+
+def sums(logname):
+    """The sum values printed into a log, by cycle"""
+    return dict(
+        re.findall(r'^sum (\d+) (\w+)$', test.file_contents(test.obj_dir + "/" + logname),
+                   re.MULTILINE))
+
+
+def check_sums(logname, first):
+    """Compare the sums of cycles from first on with the reference"""
+    got = sums(logname)
+    expected = sums("reference.log")
+    if sorted(map(int, got.keys())) != list(range(first, 40)):
+        test.error(logname + ": missing cycles: " + ' '.join(sorted(got.keys(), key=int)))
+    elif mmpi_lag is None:
+        if len(set(got.values())) < 2:
+            test.error(logname + ": sum never changes")
+    else:
+        for cyc in range(max(first, mmpi_lag), 40):
+            if got[str(cyc)] != expected[str(cyc - mmpi_lag)]:
+                test.error(logname + ": cycle " + str(cyc) + " sum " + got[str(cyc)] +
+                           ", expected " + expected[str(cyc - mmpi_lag)])
+                break
+
+
+if mmpi_transport == "shm":
+    # The rank count is compiled in, so a job started with another one stops at once
+    test.run(logfile=test.obj_dir + "/shm_size.log",
+             cmd=["cd " + test.obj_dir + " &&", "METRO_MPI_SIZE=" + str(ranks + 1),
+                  "METRO_MPI_RANK=0", "METRO_MPI_SHM_NAME=/" + shm_name, "obj_rank0/Vt"],
+             fails=True)  # yapf:disable
+    test.file_grep(test.obj_dir + "/shm_size.log", r'METRO_MPI_SIZE must be ' + str(ranks))
+
+run_ranks("rank0.log")
+check_sums("rank0.log", 0)
+
+if mmpi_prof:
+    # Rank 0 merges the measurements of every rank when the job ends
+    test.file_grep(test.obj_dir + "/rank0.log", r'Wrote profile metro_mpi_prof.txt')
+    for rank in range(ranks):
+        test.file_grep(test.obj_dir + "/metro_mpi_prof.txt", r'^ +' + str(rank) + r' +\d')
+    test.file_grep(test.obj_dir + "/metro_mpi_prof.txt", r'# link 1_to_2: \d+ messages')
+    test.file_grep(test.obj_dir + "/metro_mpi_prof.txt", r'# eval imbalance')
+    test.file_grep(test.obj_dir + "/metro_mpi_prof.json", r'"traceEvents"')
+    test.file_grep(test.obj_dir + "/metro_mpi_prof.weights", r'^\$root\.t\.u0 \d+$')
+    test.file_grep(test.obj_dir + "/metro_mpi_prof.weights", r'^\$root\.t\.u1 \d+$')
+
+if mmpi_checkpoint:
+    # Resume every rank from the state written at cycle 20
+    test.file_grep(test.obj_dir + "/rank0.log", r'Writing checkpoint metro_mpi.ckpt')
+    run_ranks("restored.log", "METRO_MPI_RESTORE=metro_mpi.ckpt")
+    test.file_grep(test.obj_dir + "/restored.log", r'Restoring checkpoint metro_mpi.ckpt')
+    check_sums("restored.log", 20)
+
+test.passes()
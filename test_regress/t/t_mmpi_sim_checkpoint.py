@@ -0,0 +1,18 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+import runpy
+
+test.scenarios('vlt')
+
+# Checkpoints every rank at cycle 20, then resumes a second job from it
+mmpi_flags = ["--savable", "--mmpi-checkpoint", "--mmpi-clock", "clk"]
+
+runpy.run_path('t/t_mmpi_sim.py', globals())
@@ -0,0 +1,20 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+import runpy
+
+test.scenarios('vlt')
+
+# Both tiles on one partition rank. Without a boundary clock the outputs follow
+# the order Verilator evaluates the stubs in, so they are not compared
+mmpi_flags = ["--mmpi-instances-per-rank", "2"]
+mmpi_lag = None
+
+runpy.run_path('t/t_mmpi_sim.py', globals())
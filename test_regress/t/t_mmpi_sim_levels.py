@@ -0,0 +1,19 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+import runpy
+
+test.scenarios('vlt')
+
+# Partitions cut under two parents, the clusters' rewritten bodies sharing one
+# file, exchange through rank 0 without a cycle of delay
+mmpi_top = "t/t_mmpi_gen_levels.v"
+
+runpy.run_path('t/t_mmpi_sim.py', globals())
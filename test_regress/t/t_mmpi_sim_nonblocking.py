@@ -0,0 +1,19 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+import runpy
+
+test.scenarios('vlt')
+
+# Persistent requests only exist on the MPI transport
+mmpi_flags = ["--mmpi-clock", "clk", "--mmpi-nonblocking"]
+mmpi_transport = "mpi"
+
+runpy.run_path('t/t_mmpi_sim.py', globals())
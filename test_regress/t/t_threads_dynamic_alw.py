@@ -0,0 +1,23 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vltmt')
+test.top_filename = "t/t_gen_alw.v"
+
+# More threads than mtasks on some levels, so threads go idle and steal
+test.compile(verilator_flags2=['--cc', '--stats', '--threads-dynamic'], threads=4)
+
+test.file_grep(test.stats, r'Optimizations, Thread schedule dynamic\s+(\d+)')
+
+# Self-checking, so the results are the same as with the static schedule
+test.execute()
+
+test.passes()
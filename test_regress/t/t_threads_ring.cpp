@@ -0,0 +1,63 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2025 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+#include <verilated.h>
+#include <verilated_threads.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// These require the above. Comment prevents clang-format moving them
+#include "TestCheck.h"
+
+#include VM_PREFIX_INCLUDE
+
+int errors = 0;
+
+double sc_time_stamp() { return 0; }
+
+// Appended to by the worker only, read once it is idle
+static std::vector<intptr_t> s_order;
+
+static void recordTask(void* selfp, bool) { s_order.push_back(reinterpret_cast<intptr_t>(selfp)); }
+
+static void slowTask(void*, bool) {
+    // Hold the worker so the producer fills the ring behind it
+    for (int i = 0; i < 100000; ++i) VL_CPU_RELAX();
+}
+
+int main(int argc, char** argv) {
+    const std::unique_ptr<VerilatedContext> contextp{new VerilatedContext};
+    contextp->commandArgs(argc, argv);
+    const std::unique_ptr<VM_PREFIX> topp{new VM_PREFIX{contextp.get()}};
+
+    VlThreadPool pool{contextp.get(), 1};
+    VlWorkerThread* const workerp = pool.workerp(0);
+
+    // Many more tasks than the ring holds, so the producer waits for the worker to make
+    // room, and the tasks must still run once each, in order
+    constexpr intptr_t N_TASKS = 1000;
+    for (int round = 0; round < 3; ++round) {
+        s_order.clear();
+        workerp->addTask(slowTask, nullptr);
+        for (intptr_t i = 0; i < N_TASKS; ++i) {
+            workerp->addTask(recordTask, reinterpret_cast<void*>(i));
+        }
+        workerp->wait();
+        TEST_CHECK_EQ(s_order.size(), static_cast<size_t>(N_TASKS));
+        for (intptr_t i = 0; i < static_cast<intptr_t>(s_order.size()); ++i) {
+            TEST_CHECK_EQ(s_order[i], i);
+        }
+    }
+
+    topp->eval();
+    topp->final();
+    if (!errors) printf("*-* All Finished *-*\n");
+    return errors;
+}
@@ -0,0 +1,54 @@
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2025 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+module t (clk);
+   input clk;
+   integer cyc = 0;
+
+   // Traced with block-wise change detection, as at least 8 elements of at
+   // most 32 bits. 40 elements make one full block of 32 and a partial one.
+   logic        a1[40];
+   logic [7:0]  a8[40];
+   logic [15:0] a16[40];
+   logic [31:0] a32[40];
+
+   initial begin
+      for (int i = 0; i < 40; ++i) begin
+         a1[i] = i[0];
+         a8[i] = i[7:0];
+         a16[i] = 16'h100 + i[15:0];
+         a32[i] = 32'h10000 + i;
+      end
+   end
+
+   // Change a few elements at a time, in either block, and rewrite some
+   // elements with their current value, which must not be dumped
+   always @(posedge clk) begin
+      cyc <= cyc + 1;
+      if (cyc == 1) begin
+         a8[5] <= 8'h5a;
+         a32[33] <= 32'hdeadbeef;
+      end
+      else if (cyc == 2) begin
+         a1[17] <= 1'b0;
+         a16[39] <= 16'hbeef;
+      end
+      else if (cyc == 3) begin
+         a8[5] <= 8'h5a;
+         a16[0] <= 16'h1;
+         a32[31] <= 32'h1;
+      end
+      else if (cyc == 4) begin
+         a1[17] <= 1'b1;
+         a8[36] <= 8'hff;
+         a8[37] <= 8'd37;
+      end
+      else if (cyc == 5) begin
+         $write("*-* All Finished *-*\n");
+         $finish;
+      end
+   end
+endmodule
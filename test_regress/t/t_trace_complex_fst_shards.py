@@ -0,0 +1,35 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt_all')
+test.top_filename = "t/t_trace_complex.v"
+test.golden_filename = "t/t_trace_complex_fst.out"
+
+test.compile(verilator_flags2=['--cc --trace-fst --trace-shards 2'])
+
+test.execute()
+
+manifest = test.obj_dir + "/simx.manifest"
+test.file_grep(manifest, r'^shards 2$')
+test.file_grep(manifest, r'^shard simx_shard0.fst \d+$')
+test.file_grep(manifest, r'^shard simx_shard1.fst \d+$')
+
+# Each signal is in exactly one of the shards
+nvars = 0
+for shard in range(2):
+    vcd = test.obj_dir + "/simx_shard" + str(shard) + ".vcd"
+    test.fst2vcd(test.obj_dir + "/simx_shard" + str(shard) + ".fst", vcd)
+    nvars += len(re.findall(r'\$var ', test.file_contents(vcd)))
+expvars = len(re.findall(r'\$var ', test.file_contents(test.golden_filename)))
+if nvars != expvars:
+    test.error("Shards declare " + str(nvars) + " signals, expected " + str(expvars))
+
+test.passes()
@@ -0,0 +1,52 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2025 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+
+#include <memory>
+
+#include VM_PREFIX_INCLUDE
+
+unsigned long long main_time = 0;
+double sc_time_stamp() { return (double)main_time; }
+
+int main(int argc, char** argv) {
+    Verilated::debug(0);
+    Verilated::traceEverOn(true);
+    Verilated::commandArgs(argc, argv);
+
+    std::unique_ptr<VM_PREFIX> top{new VM_PREFIX{"top"}};
+
+    const char* const filename = VL_STRINGIFY(TEST_OBJ_DIR) "/simflight.vcd";
+    std::unique_ptr<VerilatedVcdC> tfp{new VerilatedVcdC};
+    top->trace(tfp.get(), 99);
+    // Keep at least the last 40 time steps in memory
+    tfp->flightRecorder(40);
+    tfp->traceScopeEnable("", true);
+    tfp->open(filename);
+
+    top->clk = 0;
+
+    while (main_time < 400) {
+        top->clk = !top->clk;
+        top->eval();
+        // Enabling a scope makes the next dump a full one, which is a step as well
+        tfp->traceScopeEnable("", true);
+        tfp->dump((unsigned int)(main_time));
+        ++main_time;
+    }
+    tfp->flightDump();
+
+    tfp->close();
+    top->final();
+    tfp.reset();
+    top.reset();
+    printf("*-* All Finished *-*\n");
+    return 0;
+}
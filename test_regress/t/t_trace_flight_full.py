@@ -0,0 +1,29 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt_all')
+test.top_filename = "t/t_trace_cat.v"
+
+test.compile(make_top_shell=False,
+             make_main=False,
+             v_flags2=["--trace-vcd --exe", test.pli_filename])
+
+test.execute()
+
+trace = test.obj_dir + "/simflight.vcd"
+test.file_grep(trace, r'\$enddefinitions')
+test.file_grep(trace, r'^#399$')
+# Only the last part of the run is kept
+first = test.file_grep(trace, r'^#(\d+)$')
+if first and not 300 <= int(first[0][0]) <= 360:
+    test.error("Flight recorder window starts at unexpected time #" + first[0][0])
+
+test.passes()
@@ -0,0 +1,60 @@
+// -*- mode: C++; c-file-style: "cc-mode" -*-
+//
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2025 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+
+#include <memory>
+#include <sys/stat.h>
+
+#include VM_PREFIX_INCLUDE
+
+#include "TestCheck.h"
+
+int errors = 0;
+
+unsigned long long main_time = 0;
+double sc_time_stamp() { return (double)main_time; }
+
+int main(int argc, char** argv) {
+    Verilated::debug(0);
+    Verilated::traceEverOn(true);
+    Verilated::commandArgs(argc, argv);
+
+    std::unique_ptr<VM_PREFIX> top{new VM_PREFIX{"top"}};
+
+    const char* const filename = VL_STRINGIFY(TEST_OBJ_DIR) "/simflight.vcd";
+    std::unique_ptr<VerilatedVcdC> tfp{new VerilatedVcdC};
+    top->trace(tfp.get(), 99);
+    tfp->flightRecorder(40);
+    tfp->open(filename);
+
+    top->clk = 0;
+
+    struct stat st;
+    while (main_time < 400) {
+        top->clk = !top->clk;
+        top->eval();
+        if (Verilated::gotFinish()) break;
+        tfp->dump((unsigned int)(main_time));
+        ++main_time;
+        // Nothing is written before the failure
+        if (main_time == 200) TEST_CHECK_NE(stat(filename, &st), 0);
+    }
+    // The assertion failure flushed the trace, which wrote the window
+    TEST_CHECK_EQ(Verilated::gotError(), true);
+    TEST_CHECK_EQ(main_time, 300ULL);
+    TEST_CHECK_EQ(stat(filename, &st), 0);
+
+    tfp->close();
+    top->final();
+    tfp.reset();
+    top.reset();
+    printf("*-* All Finished *-*\n");
+    return errors;
+}
@@ -0,0 +1,31 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt_all')
+
+test.compile(make_top_shell=False,
+             make_main=False,
+             v_flags2=["--trace-vcd --assert --exe", test.pli_filename])
+
+test.execute()
+
+test.file_grep(test.run_log_filename, r'Assertion failed')
+
+trace = test.obj_dir + "/simflight.vcd"
+test.file_grep(trace, r'\$enddefinitions')
+# Window ends with the last dump before the failure
+test.file_grep(trace, r'^#299$')
+test.file_grep_not(trace, r'^#300$')
+first = test.file_grep(trace, r'^#(\d+)$')
+if first and not 200 <= int(first[0][0]) <= 260:
+    test.error("Flight recorder window starts at unexpected time #" + first[0][0])
+
+test.passes()
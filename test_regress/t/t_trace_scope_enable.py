@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt_all')
+test.top_filename = "t/t_trace_cat.v"
+
+test.compile(make_top_shell=False,
+             make_main=False,
+             v_flags2=["--trace-vcd --trace-scope-enable --exe", test.pli_filename])
+
+# Each group of signals is checked once
+test.file_grep(test.obj_dir + "/V" + test.name + "__Trace__0.cpp", r'bufp->groupEnabled\(')
+
+test.execute()
+
+trace = test.obj_dir + "/simx.vcd"
+# Signals stay declared while their scope is disabled
+clk = test.file_grep(trace, r'\$var wire +1 (\S+) clk ')
+cyc = test.file_grep(trace, r'\$var wire +32 (\S+) cyc ')
+
+# Time stamps at which each signal was dumped
+dumped = {clk[0][0]: [], cyc[0][0]: []}
+time = 0
+for line in test.file_contents(trace).splitlines():
+    if line.startswith("#"):
+        time = int(line[1:])
+    elif line.startswith("b"):
+        dumped[line.split()[1]].append(time)
+    elif line[:1] in ("0", "1"):
+        dumped[line[1:]].append(time)
+
+# See t_trace_scope_enable.cpp for when each scope is enabled
+if not dumped[cyc[0][0]] or not all(100 <= t < 200 or t >= 300 for t in dumped[cyc[0][0]]):
+    test.error("cyc dumped while top.t disabled: " + str(dumped[cyc[0][0]]))
+if 300 not in dumped[cyc[0][0]]:
+    test.error("cyc not dumped on re-enabling top.t")
+if not all(t < 200 or t >= 300 for t in dumped[clk[0][0]]):
+    test.error("clk dumped while all scopes disabled: " + str(dumped[clk[0][0]]))
+if 399 not in dumped[clk[0][0]]:
+    test.error("clk not dumped under re-enabled top.t")
+
+test.passes()
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+# DESCRIPTION: Verilator: Verilog Test driver/expect definition
+#
+# Copyright 2025 by Wilson Snyder. This program is free software; you
+# can redistribute it and/or modify it under the terms of either the GNU
+# Lesser General Public License Version 3 or the Perl Artistic License
+# Version 2.0.
+# SPDX-License-Identifier: LGPL-3.0-only OR Artistic-2.0
+
+import vltest_bootstrap
+
+test.scenarios('vlt_all')
+
+test.compile(make_top_shell=False,
+             make_main=False,
+             v_flags2=["--trace-fst --trace-scope-enable --exe", test.pli_filename])
+
+test.execute()
+
+trace = test.obj_dir + "/simx.vcd"
+test.fst2vcd(test.obj_dir + "/simx.fst", trace)
+
+# Hierarchical name of each code, and time stamps at which it had a known value
+names = {}
+dumped = {}
+scopes = []
+time = 0
+for line in test.file_contents(trace).splitlines():
+    words = line.split()
+    if not words:
+        continue
+    if words[0] == "$scope":
+        scopes.append(words[2])
+    elif words[0] == "$upscope":
+        scopes.pop()
+    elif words[0] == "$var":
+        names[words[3]] = ".".join(scopes + [words[4]])
+        dumped[words[3]] = []
+    elif line.startswith("#"):
+        time = int(line[1:])
+    elif line[0] in "bB" and len(words) == 2:
+        if "x" not in words[0].lower():
+            dumped[words[1]].append(time)
+    elif line[0] in "01":
+        dumped[line[1:]].append(time)
+
+times = {}
+for code, name in names.items():
+    times[name] = dumped[code]
+
+# See t_trace_scope_enable_fst.cpp for when each scope is enabled
+a = times.get("top.t.a.count")
+b = times.get("top.t.b.count")
+if a is None or b is None or "top.t.cyc" not in times:
+    test.error("Signals not declared: " + str(sorted(times)))
+if times["top.t.cyc"]:
+    test.error("top.t.cyc dumped while disabled: " + str(times["top.t.cyc"]))
+if not a or not all(t < 200 for t in a):
+    test.error("top.t.a dumped while disabled: " + str(a))
+if not b or not all(t >= 200 for t in b):
+    test.error("top.t.b dumped while disabled: " + str(b))
+if 200 not in b:
+    test.error("top.t.b not dumped on enabling")
+
+test.passes()
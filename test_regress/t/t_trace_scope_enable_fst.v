@@ -0,0 +1,33 @@
+// DESCRIPTION: Verilator: Verilog Test module
+//
+// This file ONLY is placed under the Creative Commons Public Domain, for
+// any use, without warranty, 2025 by Wilson Snyder.
+// SPDX-License-Identifier: CC0-1.0
+
+module t
+  (
+   input wire clk
+   );
+
+   integer    cyc; initial cyc = 0;
+
+   always @ (posedge clk) begin
+      cyc <= cyc + 1;
+   end
+
+   sub #(.INC(1)) a (.clk);
+   sub #(.INC(2)) b (.clk);
+endmodule
+
+module sub
+  #(parameter INC = 1)
+  (
+   input wire clk
+   );
+
+   integer    count; initial count = 0;
+
+   always @ (posedge clk) begin
+      count <= count + INC;
+   end
+endmodule